@@ -0,0 +1,25 @@
+#include "boot_timeline.h"
+
+uint32_t boot_timeline[BOOT_PHASE_COUNT];
+
+const char *const boot_phase_names[BOOT_PHASE_COUNT] = {
+    "clock", "board", "settings", "device_stack", "host_stack", "stdio",
+    "loop", "pc_mounted", "pad_attached", "pad_mounted", "first_report",
+};
+
+#if PT_BOOT_TIMELINE
+
+#include "pico/time.h"
+
+void boot_mark(uint8_t phase)
+{
+  // Only the first occurrence counts. A racing second writer stores a time
+  // just as valid, so no locking is needed
+  if (boot_timeline[phase] == 0)
+  {
+    uint32_t now = time_us_32();
+    boot_timeline[phase] = now ? now : 1;
+  }
+}
+
+#endif
@@ -0,0 +1,574 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tusb.h"
+#include "pico/bootrom.h"
+#include "pico/time.h"
+#include "hardware/watchdog.h"
+
+#include "command.h"
+#include "latency_stats.h"
+#include "report_mailbox.h"
+#include "report_ring.h"
+#include "delta_filter.h"
+#include "stage_profile.h"
+#include "settings.h"
+#include "event_loop.h"
+#include "host_poll.h"
+#include "sof_align.h"
+#include "config_store.h"
+#include "boot_timeline.h"
+#include "pad_cache.h"
+#include "pipeline.h"
+#include "turbo.h"
+#include "hid_input.h"
+#include "usb_personality.h"
+#include "macro.h"
+
+#define COMMAND_CDC_ITF 0
+#define COMMAND_MAX_ARGS 8
+
+typedef struct
+{
+  const char *name;
+  const char *usage;
+  void (*handler)(uint8_t argc, char **argv);
+} command_t;
+
+static command_parser_t parser;
+static volatile bool rx_pending;
+
+// Parse a decimal or 0x-prefixed number no larger than max
+static bool parse_uint(const char *s, uint32_t max, uint32_t *out)
+{
+  char *end;
+  unsigned long v = strtoul(s, &end, 0);
+  if (end == s || *end || v > max)
+  {
+    return false;
+  }
+  *out = (uint32_t)v;
+  return true;
+}
+
+//--------------------------------------------------------------------+
+// Commands
+//--------------------------------------------------------------------+
+
+static void cmd_help(uint8_t argc, char **argv);
+
+static void cmd_stats(uint8_t argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+
+#if PT_LATENCY_STATS
+  static const char *const stage_names[LATENCY_STAGE_COUNT] = {"rx->queue", "queue->done", "rx->done"};
+  static latency_stats_t lat;
+  latency_stats_snapshot(&lat);
+  for (uint8_t i = 0; i < LATENCY_STAGE_COUNT; i++)
+  {
+    latency_hist_t const *h = &lat.stage[i];
+    printf("latency %-11s n=%lu min=%lu p99=%lu max=%lu us\n", stage_names[i],
+           (unsigned long)h->count, (unsigned long)h->min_us, (unsigned long)h->p99_us, (unsigned long)h->max_us);
+  }
+#endif
+
+#if PT_STAGE_PROFILE
+  static const char *const profile_names[PROFILE_STAGE_COUNT] = {"translate", "remap", "smooth", "curve", "pipeline"};
+  for (uint8_t i = 0; i < PROFILE_STAGE_COUNT; i++)
+  {
+    stage_profile_t p = stage_profile[i];
+    printf("cycles %-9s n=%lu min=%lu avg=%lu max=%lu\n", profile_names[i], (unsigned long)p.count,
+           (unsigned long)p.min, (unsigned long)(p.count ? p.total / p.count : 0), (unsigned long)p.max);
+  }
+#endif
+
+#if PT_EVENT_LOOP
+  static const char *const event_names[EVENT_COUNT] = {"device", "host", "ring", "relay", "tick"};
+  for (uint8_t i = 0; i < EVENT_COUNT; i++)
+  {
+    event_latency_t l = event_stats.latency[i];
+    printf("wake %-6s n=%lu avg=%lu max=%lu us\n", event_names[i], (unsigned long)l.count,
+           (unsigned long)(l.count ? l.total_us / l.count : 0), (unsigned long)l.max_us);
+  }
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    printf("core%u sleeps=%lu asleep=%lu%%\n", i, (unsigned long)event_stats.sleeps[i],
+           (unsigned long)(event_stats.slept_us[i] * 100 / time_us_64()));
+  }
+#endif
+
+  config_store_stats_t const *cs = &config_store_stats;
+  printf("config seq=%lu loaded=%u pending=%u writes=%lu erases=%lu failed=%lu\n", (unsigned long)cs->seq, cs->loaded,
+         cs->pending, (unsigned long)cs->writes, (unsigned long)cs->erases, (unsigned long)cs->failed);
+
+#if PT_TURBO
+  turbo_stats_t const *ts = &turbo_stats;
+  printf("turbo ticks=%lu missed=%lu tick_late_max=%lu us injected=%lu toggle min/avg/max=%lu/%lu/%lu us\n",
+         (unsigned long)ts->ticks, (unsigned long)ts->missed, (unsigned long)ts->tick_late_max_us,
+         (unsigned long)ts->injected, (unsigned long)ts->toggle_min_us,
+         (unsigned long)(ts->injected ? ts->toggle_total_us / ts->injected : 0), (unsigned long)ts->toggle_max_us);
+#endif
+
+#if PT_HID_HOST
+  for (uint8_t i = 0; i < PT_HID_INTERFACES; i++)
+  {
+    hid_input_stats_t const *hs = &hid_input_stats[i];
+    if (hs->dev_addr)
+    {
+      printf("hid dev=%u itf=%u ops=%u reports=%lu ignored=%lu\n", hs->dev_addr, hs->idx, hs->ops,
+             (unsigned long)hs->reports, (unsigned long)hs->ignored);
+    }
+  }
+#endif
+
+  for (uint8_t i = 0; i < PT_XINPUT_PADS; i++)
+  {
+    report_mailbox_t const *mb = &report_mailbox[i];
+    printf("pad %u sent=%lu overwritten=%lu mirror_overwritten=%lu dropped=%lu ring_dropped=%lu ring_skipped=%lu "
+           "suppressed=%lu\n",
+           i, (unsigned long)mb->sent, (unsigned long)mb->overwritten, (unsigned long)mb->mirror_overwritten,
+           (unsigned long)mb->dropped,
+           (unsigned long)report_ring[i].dropped, (unsigned long)report_ring[i].skipped,
+           (unsigned long)delta_filter[i].suppressed);
+
+    host_poll_stats_t const *hp = &host_poll_stats[i];
+    printf("pad %u poll bInterval=%u (native %u) rate=%lu Hz max_gap=%lu us received=%lu failed=%lu\n", i,
+           hp->interval, hp->native_interval, (unsigned long)hp->rate_hz, (unsigned long)hp->max_gap_us,
+           (unsigned long)hp->received, (unsigned long)hp->failed);
+  }
+}
+
+// map btn <out> <src|none> | map stick <out> <src> [inv] | map trigger <out> <src> | map reset
+static void cmd_map(uint8_t argc, char **argv)
+{
+  uint32_t out, src;
+  remap_config_t *cfg = &settings.remap;
+
+  if (argc == 2 && strcmp(argv[1], "reset") == 0)
+  {
+    remap_config_identity(cfg);
+  }
+  else if (argc == 4 && strcmp(argv[1], "btn") == 0 && parse_uint(argv[2], REMAP_BUTTON_COUNT - 1, &out))
+  {
+    if (strcmp(argv[3], "none") == 0)
+    {
+      src = REMAP_NONE;
+    }
+    else if (!parse_uint(argv[3], REMAP_BUTTON_COUNT - 1, &src))
+    {
+      printf("ERR bad source\n");
+      return;
+    }
+    cfg->button_src[out] = (uint8_t)src;
+  }
+  else if ((argc == 4 || argc == 5) && strcmp(argv[1], "stick") == 0 &&
+           parse_uint(argv[2], REMAP_STICK_AXES - 1, &out) && parse_uint(argv[3], REMAP_STICK_AXES - 1, &src))
+  {
+    bool invert = argc == 5 && strcmp(argv[4], "inv") == 0;
+    cfg->stick_src[out] = (uint8_t)src;
+    cfg->stick_invert = (uint8_t)((cfg->stick_invert & ~(1u << out)) | (invert ? 1u << out : 0));
+  }
+  else if (argc == 4 && strcmp(argv[1], "trigger") == 0 &&
+           parse_uint(argv[2], REMAP_TRIGGERS - 1, &out) && parse_uint(argv[3], REMAP_TRIGGERS - 1, &src))
+  {
+    cfg->trigger_src[out] = (uint8_t)src;
+  }
+  else
+  {
+    printf("ERR usage: map btn|stick|trigger <out> <src> [inv] | map reset\n");
+    return;
+  }
+
+  settings_changed();
+  printf("OK\n");
+}
+
+// dz stick|trigger <n> <deadzone> [anti] [outer] [curve]
+static void cmd_dz(uint8_t argc, char **argv)
+{
+  uint32_t n, v[4];
+  bool stick = argc >= 4 && strcmp(argv[1], "stick") == 0;
+  bool trigger = argc >= 4 && strcmp(argv[1], "trigger") == 0;
+  uint32_t max = stick ? 32767 : 255;
+
+  if ((!stick && !trigger) || argc > 7 || !parse_uint(argv[2], 1, &n))
+  {
+    printf("ERR usage: dz stick|trigger <0|1> <deadzone> [anti] [outer] [curve 0-100]\n");
+    return;
+  }
+
+  // Fields that are not given keep their current value
+  if (stick)
+  {
+    curve_stick_config_t const *c = &settings.curve.stick[n];
+    v[0] = c->deadzone, v[1] = c->anti_deadzone, v[2] = c->outer, v[3] = c->curve;
+  }
+  else
+  {
+    curve_trigger_config_t const *c = &settings.curve.trigger[n];
+    v[0] = c->deadzone, v[1] = c->anti_deadzone, v[2] = c->outer, v[3] = c->curve;
+  }
+  for (uint8_t i = 3; i < argc; i++)
+  {
+    if (!parse_uint(argv[i], i == 6 ? 100 : max, &v[i - 3]))
+    {
+      printf("ERR bad value %s\n", argv[i]);
+      return;
+    }
+  }
+
+  if (stick)
+  {
+    settings.curve.stick[n] = (curve_stick_config_t){
+        .deadzone = (uint16_t)v[0], .anti_deadzone = (uint16_t)v[1], .outer = (uint16_t)v[2], .curve = (uint8_t)v[3]};
+  }
+  else
+  {
+    settings.curve.trigger[n] = (curve_trigger_config_t){
+        .deadzone = (uint8_t)v[0], .anti_deadzone = (uint8_t)v[1], .outer = (uint8_t)v[2], .curve = (uint8_t)v[3]};
+  }
+  settings_changed();
+  printf("OK\n");
+}
+
+// boot
+static void cmd_boot(uint8_t argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+
+#if PT_BOOT_TIMELINE
+  uint32_t prev = 0;
+  for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++)
+  {
+    if (boot_timeline[i] == 0)
+    {
+      printf("boot %-12s -\n", boot_phase_names[i]);
+      continue;
+    }
+    printf("boot %-12s %10lu us  +%lu\n", boot_phase_names[i], (unsigned long)boot_timeline[i],
+           (unsigned long)(boot_timeline[i] - prev));
+    prev = boot_timeline[i];
+  }
+#endif
+
+  for (uint8_t i = 0; i < PT_XINPUT_PADS; i++)
+  {
+    pad_connect_stats_t const *s = &pad_connect_stats[i];
+    printf("pad %u connects=%lu fast=%lu last: %s mount=%lu us first_report=%lu us best=%lu us\n", i,
+           (unsigned long)s->connects, (unsigned long)s->fast_connects, s->last_fast ? "fast" : "full",
+           (unsigned long)s->mount_us, (unsigned long)s->first_report_us, (unsigned long)s->best_us);
+  }
+}
+
+// smooth [axes] [min_cutoff] [beta] [d_cutoff]
+static void cmd_smooth(uint8_t argc, char **argv)
+{
+  static const uint32_t max[] = {(1u << STICK_FILTER_AXES) - 1, 10000, 255, 10000};
+  stick_filter_config_t *cfg = &settings.filter;
+  uint32_t v[4] = {cfg->axes, cfg->min_cutoff, cfg->beta, cfg->d_cutoff};
+
+  if (argc > 5)
+  {
+    printf("ERR usage: smooth [axes] [min_cutoff] [beta] [d_cutoff]\n");
+    return;
+  }
+  for (uint8_t i = 1; i < argc; i++)
+  {
+    if (!parse_uint(argv[i], max[i - 1], &v[i - 1]))
+    {
+      printf("ERR bad value %s\n", argv[i]);
+      return;
+    }
+  }
+  if (argc > 1)
+  {
+    *cfg = (stick_filter_config_t){
+        .axes = (uint8_t)v[0], .min_cutoff = (uint16_t)v[1], .beta = (uint8_t)v[2], .d_cutoff = (uint16_t)v[3]};
+    settings_changed();
+  }
+
+  printf("smooth axes=0x%x min_cutoff=%u.%u Hz beta=%u.%u Hz d_cutoff=%u.%u Hz\n", cfg->axes, cfg->min_cutoff / 10,
+         cfg->min_cutoff % 10, cfg->beta / 10, cfg->beta % 10, cfg->d_cutoff / 10, cfg->d_cutoff % 10);
+}
+
+// turbo [button rate]
+static void cmd_turbo(uint8_t argc, char **argv)
+{
+  uint32_t button, rate;
+  if (argc == 3 && parse_uint(argv[1], TURBO_BUTTON_COUNT - 1, &button) &&
+      parse_uint(argv[2], TURBO_RATE_MAX, &rate))
+  {
+    settings.turbo.rate[button] = (uint8_t)rate;
+    settings_changed();
+  }
+  else if (argc != 1)
+  {
+    printf("ERR usage: turbo [<button> <rate 0-%u>]\n", TURBO_RATE_MAX);
+    return;
+  }
+
+  printf("turbo:");
+  for (uint8_t i = 0; i < TURBO_BUTTON_COUNT; i++)
+  {
+    if (settings.turbo.rate[i])
+    {
+      printf(" %u=%u/s", i, settings.turbo.rate[i]);
+    }
+  }
+  printf("\n");
+}
+
+#if PT_MACRO
+// macro [rec [slot] | stop | play [slot] | save]
+static void cmd_macro(uint8_t argc, char **argv)
+{
+  bool rec = argc >= 2 && strcmp(argv[1], "rec") == 0;
+  bool play = argc >= 2 && strcmp(argv[1], "play") == 0;
+  uint32_t slot = 0;
+  bool ok = true;
+  if ((rec || play) && (argc == 2 || (argc == 3 && parse_uint(argv[2], PT_XINPUT_PADS - 1, &slot))))
+  {
+    ok = rec ? macro_record_start((uint8_t)slot) : macro_replay_start((uint8_t)slot);
+  }
+  else if (argc == 2 && strcmp(argv[1], "stop") == 0)
+  {
+    macro_stop();
+  }
+  else if (argc == 2 && strcmp(argv[1], "save") == 0)
+  {
+    ok = macro_save();
+  }
+  else if (argc != 1)
+  {
+    printf("ERR usage: macro [rec [slot] | stop | play [slot] | save]\n");
+    return;
+  }
+  if (!ok)
+  {
+    printf("ERR macro is %s\n", macro_state_names[macro_state()]);
+    return;
+  }
+
+  macro_stats_t const *s = &macro_stats;
+  printf("macro %s events=%lu bytes=%lu/%u captured=%lu%s%s\n", macro_state_names[macro_state()],
+         (unsigned long)s->events, (unsigned long)s->bytes, PT_MACRO_BUFFER_SIZE, (unsigned long)s->captured,
+         s->full ? " full" : "", config_store_stats.macro_pending ? " saving" : "");
+  printf("macro replayed=%lu held_back=%lu late min/avg/max=%lu/%lu/%lu us over_%u=%lu\n", (unsigned long)s->replayed,
+         (unsigned long)s->held_back, (unsigned long)s->late_min_us,
+         (unsigned long)(s->replayed ? s->late_total_us / s->replayed : 0), (unsigned long)s->late_max_us,
+         MACRO_LATE_LIMIT_US, (unsigned long)s->late_over);
+}
+#endif
+
+// personality [xinput|hid|both]
+static void cmd_personality(uint8_t argc, char **argv)
+{
+  if (argc == 2)
+  {
+    uint8_t p = 0;
+    while (p < USB_PERSONALITY_COUNT && strcmp(argv[1], usb_personality_names[p]) != 0)
+    {
+      p++;
+    }
+    if (p == USB_PERSONALITY_COUNT)
+    {
+      printf("ERR usage: personality [xinput|hid|both]\n");
+      return;
+    }
+    // The device re-enumerates once this reply is out
+    settings.personality = p;
+    settings_changed();
+  }
+  else if (argc != 1)
+  {
+    printf("ERR usage: personality [xinput|hid|both]\n");
+    return;
+  }
+
+  usb_personality_stats_t const *s = &usb_personality_stats;
+  printf("personality %s", usb_personality_names[usb_personality_active()]);
+  if (settings.personality != usb_personality_active())
+  {
+    printf(" -> %s", usb_personality_names[settings.personality]);
+  }
+  printf(" switches=%lu last=%lu us best=%lu us\n", (unsigned long)s->switches, (unsigned long)s->last_us,
+         (unsigned long)s->best_us);
+}
+
+// pipe [mask]
+static void cmd_pipe(uint8_t argc, char **argv)
+{
+  uint32_t mask;
+  if (argc == 2)
+  {
+    if (!parse_uint(argv[1], PIPELINE_BIT(PIPELINE_STAGE_COUNT) - 1, &mask))
+    {
+      printf("ERR usage: pipe [mask]\n");
+      return;
+    }
+    pipeline_set_mask(mask);
+  }
+
+  mask = atomic_load_explicit(&pipeline_mask, memory_order_relaxed);
+  printf("pipeline %s:", PT_PIPELINE_RUNTIME ? "runtime" : "static");
+  for (uint8_t i = 0; i < PIPELINE_STAGE_COUNT; i++)
+  {
+    if (PIPELINE_STAGES_BUILT & PIPELINE_BIT(i))
+    {
+      printf(" %s%s", pipeline_stage_names[i], (PT_PIPELINE_RUNTIME && !(mask & PIPELINE_BIT(i))) ? "(off)" : "");
+    }
+  }
+  printf("\n");
+}
+
+// bench [iterations]
+static void cmd_bench(uint8_t argc, char **argv)
+{
+  uint32_t n = 1000, static_cycles, dynamic_cycles;
+  if (argc == 2 && !parse_uint(argv[1], 100000, &n))
+  {
+    printf("ERR usage: bench [iterations]\n");
+    return;
+  }
+  pipeline_bench(n, &static_cycles, &dynamic_cycles);
+  printf("bench %lu reports: static %lu cycles, runtime (mask 0x%x) %lu cycles per report\n", (unsigned long)n,
+         (unsigned long)static_cycles, (unsigned)atomic_load_explicit(&pipeline_mask, memory_order_relaxed),
+         (unsigned long)dynamic_cycles);
+}
+
+// save
+static void cmd_save(uint8_t argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  config_store_save();
+  printf("OK written once the pads are idle for %u ms\n", PT_CONFIG_STORE_IDLE_MS);
+}
+
+#if PT_SOF_ALIGN
+// sof [on|off]
+static void cmd_sof(uint8_t argc, char **argv)
+{
+  if (argc == 2)
+  {
+    if (strcmp(argv[1], "on") != 0 && strcmp(argv[1], "off") != 0)
+    {
+      printf("ERR usage: sof [on|off]\n");
+      return;
+    }
+    sof_align_enable(strcmp(argv[1], "on") == 0);
+  }
+
+  sof_align_stats_t const *s = &sof_align_stats;
+  printf("sof %s phase=%u us period=%u frames commits=%lu late=%lu max_lateness=%lu us\n",
+         sof_align_active() ? "aligned" : "immediate", s->phase_us, s->period, (unsigned long)s->commits,
+         (unsigned long)s->late, (unsigned long)s->max_lateness_us);
+  printf("sof age min=%lu avg=%lu max=%lu jitter=%lu us, armed avg=%lu max=%lu us\n", (unsigned long)s->age_min_us,
+         (unsigned long)s->age_avg_us, (unsigned long)s->age_max_us, (unsigned long)(s->age_max_us - s->age_min_us),
+         (unsigned long)s->wait_avg_us, (unsigned long)s->wait_max_us);
+}
+#endif
+
+// reboot [bootsel]
+static void cmd_reboot(uint8_t argc, char **argv)
+{
+  if (argc == 2 && strcmp(argv[1], "bootsel") == 0)
+  {
+    reset_usb_boot(0, 0);
+  }
+  watchdog_reboot(0, 0, 0);
+}
+
+static const command_t commands[] = {
+    {"help", "", cmd_help},
+    {"stats", "", cmd_stats},
+    {"boot", "", cmd_boot},
+    {"map", "btn|stick|trigger <out> <src> [inv] | reset", cmd_map},
+    {"dz", "stick|trigger <0|1> <deadzone> [anti] [outer] [curve]", cmd_dz},
+    {"smooth", "[axes] [min_cutoff] [beta] [d_cutoff]", cmd_smooth},
+    {"turbo", "[<button> <rate>]", cmd_turbo},
+#if PT_MACRO
+    {"macro", "[rec [slot] | stop | play [slot] | save]", cmd_macro},
+#endif
+    {"personality", "[xinput|hid|both]", cmd_personality},
+    {"pipe", "[mask]", cmd_pipe},
+    {"bench", "[iterations]", cmd_bench},
+    {"save", "", cmd_save},
+#if PT_SOF_ALIGN
+    {"sof", "[on|off]", cmd_sof},
+#endif
+    {"reboot", "[bootsel]", cmd_reboot},
+};
+
+static void cmd_help(uint8_t argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  for (uint8_t i = 0; i < TU_ARRAY_SIZE(commands); i++)
+  {
+    printf("%s %s\n", commands[i].name, commands[i].usage);
+  }
+}
+
+void command_execute(char *line)
+{
+  char *argv[COMMAND_MAX_ARGS];
+  uint8_t argc = command_tokenize(line, argv, COMMAND_MAX_ARGS);
+  if (argc == 0)
+  {
+    return;
+  }
+  if (argc > COMMAND_MAX_ARGS)
+  {
+    printf("ERR too many arguments, at most %u\n", COMMAND_MAX_ARGS - 1);
+    return;
+  }
+
+  for (uint8_t i = 0; i < TU_ARRAY_SIZE(commands); i++)
+  {
+    if (strcmp(argv[0], commands[i].name) == 0)
+    {
+      commands[i].handler(argc, argv);
+      return;
+    }
+  }
+  printf("ERR unknown command %s, try help\n", argv[0]);
+}
+
+//--------------------------------------------------------------------+
+// CDC glue
+//--------------------------------------------------------------------+
+
+void command_rx_notify(void)
+{
+  rx_pending = true;
+}
+
+void command_task(void)
+{
+  if (!rx_pending)
+  {
+    return;
+  }
+  rx_pending = false;
+
+  uint8_t buf[CFG_TUD_CDC_EP_BUFSIZE];
+  uint32_t count;
+  while ((count = tud_cdc_n_read(COMMAND_CDC_ITF, buf, sizeof(buf))) > 0)
+  {
+    uint32_t pos = 0;
+    while (pos < count)
+    {
+      bool line_ready;
+      pos += command_parser_feed(&parser, buf + pos, count - pos, &line_ready);
+      if (line_ready)
+      {
+        command_execute(parser.line);
+      }
+    }
+  }
+}
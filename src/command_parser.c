@@ -0,0 +1,77 @@
+#include "command.h"
+
+// Nothing in here touches the SDK or TinyUSB, so tools/command_fuzz builds
+// this file on the host
+
+void command_parser_reset(command_parser_t *p)
+{
+  p->len = 0;
+  p->overflow = false;
+}
+
+uint32_t command_parser_feed(command_parser_t *p, const uint8_t *data, uint32_t len, bool *line_ready)
+{
+  *line_ready = false;
+  for (uint32_t i = 0; i < len; i++)
+  {
+    char c = (char)data[i];
+    if (c == '\r' || c == '\n')
+    {
+      // Empty lines (e.g. the \n of \r\n) and oversized ones are dropped
+      if (p->len && !p->overflow)
+      {
+        p->line[p->len] = '\0';
+        *line_ready = true;
+      }
+      p->len = 0;
+      bool ready = *line_ready;
+      p->overflow = false;
+      if (ready)
+      {
+        return i + 1;
+      }
+      continue;
+    }
+
+    // Keep one byte for the terminator
+    if (p->len >= sizeof(p->line) - 1)
+    {
+      p->overflow = true;
+      continue;
+    }
+    p->line[p->len++] = c;
+  }
+  return len;
+}
+
+uint8_t command_tokenize(char *line, char **argv, uint8_t max_args)
+{
+  uint8_t argc = 0;
+  char *s = line;
+  while (*s)
+  {
+    while (*s == ' ' || *s == '\t')
+    {
+      s++;
+    }
+    if (!*s)
+    {
+      break;
+    }
+    // argv is full and there is another token, the caller rejects the line
+    if (argc == max_args)
+    {
+      return (uint8_t)(max_args + 1);
+    }
+    argv[argc++] = s;
+    while (*s && *s != ' ' && *s != '\t')
+    {
+      s++;
+    }
+    if (*s)
+    {
+      *s++ = '\0';
+    }
+  }
+  return argc;
+}
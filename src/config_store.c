@@ -0,0 +1,297 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "hardware/flash.h"
+
+#include "config_store.h"
+#include "report_mailbox.h"
+
+#define STORE_MAGIC 0x43505450u  // "PTPC"
+#define STORE_VERSION 4
+#define STORE_SIZE (PT_CONFIG_STORE_SECTORS * FLASH_SECTOR_SIZE)
+#define STORE_OFFSET (PICO_FLASH_SIZE_BYTES - STORE_SIZE)
+#define STORE_PAGES (STORE_SIZE / FLASH_PAGE_SIZE)
+#define PAGES_PER_SECTOR (FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE)
+
+#define MACRO_MAGIC 0x434D5450u  // "PTMC"
+#define MACRO_VERSION 1
+#define MACRO_SIZE (PT_MACRO_FLASH_SECTORS * FLASH_SECTOR_SIZE)
+#define MACRO_OFFSET (STORE_OFFSET - MACRO_SIZE)
+
+// Every record occupies exactly one flash page
+typedef struct
+{
+  uint32_t magic;
+  uint16_t version;  // layout of the payload, records of other versions are skipped
+  uint16_t length;   // sizeof(settings_t) when written
+  uint32_t seq;
+  uint32_t crc;      // CRC-32 of the header up to here and the payload
+  settings_t payload;
+} store_record_t;
+
+_Static_assert(sizeof(store_record_t) <= FLASH_PAGE_SIZE, "settings no longer fit in one flash page");
+
+// First page of the macro region, the recording follows from the next page
+typedef struct
+{
+  uint32_t magic;
+  uint16_t version;  // of the macro_codec.h format
+  uint16_t reserved;
+  uint32_t length;   // bytes of recording
+  uint32_t crc;      // CRC-32 of the recording
+} macro_header_t;
+
+_Static_assert(PT_MACRO_BUFFER_SIZE % FLASH_PAGE_SIZE == 0, "PT_MACRO_BUFFER_SIZE must be a multiple of the flash page");
+_Static_assert(PT_MACRO_BUFFER_SIZE + FLASH_PAGE_SIZE <= MACRO_SIZE, "PT_MACRO_FLASH_SECTORS too small for the macro buffer");
+
+typedef struct
+{
+  const uint8_t *data;
+  uint32_t pages;  // of data, rounded up
+} macro_op_t;
+
+typedef struct
+{
+  uint32_t erase_offset;  // sector to erase first, 0 if none
+  uint32_t program_offset;
+} store_op_t;
+
+config_store_stats_t config_store_stats;
+
+// Page the next record goes to
+static uint32_t next_page;
+
+// Staging buffer for the page being programmed, flash cannot be written
+// from XIP
+static uint8_t page_buf[FLASH_PAGE_SIZE] __attribute__((aligned(4)));
+
+static uint32_t last_activity_seq;
+static uint32_t last_activity_ms;
+
+static const uint8_t *macro_data;
+static uint32_t macro_len;
+
+static const uint8_t *page_ptr(uint32_t page)
+{
+  return (const uint8_t *)(XIP_BASE + STORE_OFFSET + page * FLASH_PAGE_SIZE);
+}
+
+static uint32_t crc32(uint32_t crc, const uint8_t *data, size_t len)
+{
+  crc = ~crc;
+  while (len--)
+  {
+    crc ^= *data++;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+static uint32_t record_crc(const store_record_t *rec)
+{
+  uint32_t crc = crc32(0, (const uint8_t *)rec, offsetof(store_record_t, crc));
+  return crc32(crc, (const uint8_t *)&rec->payload, sizeof(rec->payload));
+}
+
+static bool record_valid(const store_record_t *rec)
+{
+  return rec->magic == STORE_MAGIC && rec->version == STORE_VERSION && rec->length == sizeof(settings_t) &&
+         rec->crc == record_crc(rec);
+}
+
+static bool page_erased(uint32_t page)
+{
+  const uint32_t *p = (const uint32_t *)page_ptr(page);
+  for (uint32_t i = 0; i < FLASH_PAGE_SIZE / 4; i++)
+  {
+    if (p[i] != 0xFFFFFFFFu)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool config_store_load(settings_t *out)
+{
+  const store_record_t *newest = NULL;
+  uint32_t newest_page = 0;
+
+  for (uint32_t page = 0; page < STORE_PAGES; page++)
+  {
+    const store_record_t *rec = (const store_record_t *)page_ptr(page);
+    if (record_valid(rec) && (!newest || (int32_t)(rec->seq - newest->seq) > 0))
+    {
+      newest = rec;
+      newest_page = page;
+    }
+  }
+
+  if (!newest)
+  {
+    next_page = 0;
+    return false;
+  }
+
+  memcpy(out, &newest->payload, sizeof(*out));
+  next_page = (newest_page + 1) % STORE_PAGES;
+  config_store_stats.seq = newest->seq;
+  config_store_stats.loaded = true;
+  return true;
+}
+
+void config_store_save(void)
+{
+  config_store_stats.pending = true;
+}
+
+// Runs with interrupts off and the other core parked. flash_range_* exit
+// XIP themselves, this wrapper is kept in RAM so no part of the write path
+// fetches from flash while it is unavailable
+static void __not_in_flash_func(store_write)(void *param)
+{
+  store_op_t const *op = (store_op_t const *)param;
+  if (op->erase_offset)
+  {
+    flash_range_erase(op->erase_offset, FLASH_SECTOR_SIZE);
+  }
+  flash_range_program(op->program_offset, page_buf, FLASH_PAGE_SIZE);
+}
+
+static void store_commit(void)
+{
+  store_op_t op = {0};
+
+  // A page that is not blank (an interrupted erase, foreign data) cannot be
+  // programmed, move on to the next sector and erase it. The same happens
+  // whenever the log enters a new sector
+  if (!page_erased(next_page))
+  {
+    next_page = (next_page / PAGES_PER_SECTOR + 1) * PAGES_PER_SECTOR % STORE_PAGES;
+  }
+  if (next_page % PAGES_PER_SECTOR == 0)
+  {
+    bool blank = true;
+    for (uint32_t i = 0; i < PAGES_PER_SECTOR && blank; i++)
+    {
+      blank = page_erased(next_page + i);
+    }
+    if (!blank)
+    {
+      op.erase_offset = STORE_OFFSET + next_page * FLASH_PAGE_SIZE;
+    }
+  }
+  op.program_offset = STORE_OFFSET + next_page * FLASH_PAGE_SIZE;
+
+  memset(page_buf, 0xFF, sizeof(page_buf));
+  store_record_t *rec = (store_record_t *)page_buf;
+  rec->magic = STORE_MAGIC;
+  rec->version = STORE_VERSION;
+  rec->length = sizeof(settings_t);
+  rec->seq = config_store_stats.seq + 1;
+  rec->payload = settings;
+  rec->crc = record_crc(rec);
+
+  if (flash_safe_execute(store_write, &op, PT_CONFIG_STORE_LOCKOUT_MS) != PICO_OK)
+  {
+    // Try again on a later pass
+    config_store_stats.failed++;
+    return;
+  }
+
+  if (op.erase_offset)
+  {
+    config_store_stats.erases++;
+  }
+  config_store_stats.writes++;
+  config_store_stats.seq = rec->seq;
+  config_store_stats.pending = false;
+  next_page = (next_page + 1) % STORE_PAGES;
+}
+
+// Same conditions as store_write, for the macro region
+static void __not_in_flash_func(macro_write)(void *param)
+{
+  macro_op_t const *op = (macro_op_t const *)param;
+  flash_range_erase(MACRO_OFFSET, ((op->pages + 1) * FLASH_PAGE_SIZE + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE *
+                                      FLASH_SECTOR_SIZE);
+  flash_range_program(MACRO_OFFSET, page_buf, FLASH_PAGE_SIZE);
+  if (op->pages)
+  {
+    flash_range_program(MACRO_OFFSET + FLASH_PAGE_SIZE, op->data, op->pages * FLASH_PAGE_SIZE);
+  }
+}
+
+void config_store_save_macro(const uint8_t *data, uint32_t len)
+{
+  macro_data = data;
+  macro_len = len;
+  config_store_stats.macro_pending = true;
+}
+
+uint32_t config_store_load_macro(uint8_t *data, uint32_t max)
+{
+  const macro_header_t *hdr = (const macro_header_t *)(XIP_BASE + MACRO_OFFSET);
+  const uint8_t *rec = (const uint8_t *)(XIP_BASE + MACRO_OFFSET + FLASH_PAGE_SIZE);
+  if (hdr->magic != MACRO_MAGIC || hdr->version != MACRO_VERSION || hdr->length > max ||
+      hdr->crc != crc32(0, rec, hdr->length))
+  {
+    return 0;
+  }
+  memcpy(data, rec, hdr->length);
+  return hdr->length;
+}
+
+static void macro_commit(void)
+{
+  memset(page_buf, 0xFF, sizeof(page_buf));
+  macro_header_t *hdr = (macro_header_t *)page_buf;
+  *hdr = (macro_header_t){
+      .magic = MACRO_MAGIC, .version = MACRO_VERSION, .length = macro_len, .crc = crc32(0, macro_data, macro_len)};
+
+  macro_op_t op = {.data = macro_data, .pages = (macro_len + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE};
+  if (flash_safe_execute(macro_write, &op, PT_CONFIG_STORE_LOCKOUT_MS) != PICO_OK)
+  {
+    config_store_stats.failed++;
+    return;
+  }
+  config_store_stats.macro_writes++;
+  config_store_stats.macro_pending = false;
+}
+
+void config_store_task(void)
+{
+  // Any frame posted to a mailbox counts as report traffic
+  uint32_t activity_seq = 0;
+  for (uint8_t i = 0; i < PT_XINPUT_PADS; i++)
+  {
+    activity_seq += report_mailbox[i].seq;
+  }
+  uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+  if (activity_seq != last_activity_seq)
+  {
+    last_activity_seq = activity_seq;
+    last_activity_ms = now_ms;
+  }
+
+  // Both cores stall while the flash is busy, an erase takes tens of
+  // milliseconds. Only do it while nobody is playing
+  if (!(config_store_stats.pending || config_store_stats.macro_pending) ||
+      now_ms - last_activity_ms < PT_CONFIG_STORE_IDLE_MS)
+  {
+    return;
+  }
+  if (config_store_stats.pending)
+  {
+    store_commit();
+  }
+  else
+  {
+    macro_commit();
+  }
+}
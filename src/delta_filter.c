@@ -0,0 +1,68 @@
+#include <string.h>
+
+#include "delta_filter.h"
+
+delta_filter_t delta_filter[PT_XINPUT_PADS];
+
+#if PT_DELTA_STICK_THRESHOLD > 0
+static bool within_threshold(int16_t a, int16_t b)
+{
+  int32_t d = (int32_t)a - (int32_t)b;
+  return d <= PT_DELTA_STICK_THRESHOLD && d >= -PT_DELTA_STICK_THRESHOLD;
+}
+
+// Only stick noise below the threshold separates the two reports
+static bool is_stick_noise(const xinput_report_t *a, const xinput_report_t *b)
+{
+  return a->bmButtons == b->bmButtons &&
+         a->bLeftTrigger == b->bLeftTrigger &&
+         a->bRightTrigger == b->bRightTrigger &&
+         within_threshold(a->wThumbLeftX, b->wThumbLeftX) &&
+         within_threshold(a->wThumbLeftY, b->wThumbLeftY) &&
+         within_threshold(a->wThumbRightX, b->wThumbRightX) &&
+         within_threshold(a->wThumbRightY, b->wThumbRightY);
+}
+#endif
+
+void delta_filter_reset(delta_filter_t *filter)
+{
+  memset(filter, 0, sizeof(*filter));
+}
+
+bool delta_filter_check(delta_filter_t *filter, const xinput_report_t *report, uint32_t now_us)
+{
+  // The report struct is packed, copy it into aligned words for the compare
+  uint32_t words[DELTA_REPORT_WORDS] = {0};
+  memcpy(words, report, sizeof(*report));
+
+  if (filter->valid && now_us - filter->last_us < PT_DELTA_KEEPALIVE_MS * 1000u)
+  {
+    uint32_t diff = 0;
+    for (uint32_t i = 0; i < DELTA_REPORT_WORDS; i++)
+    {
+      diff |= words[i] ^ filter->last[i];
+    }
+
+    bool unchanged = diff == 0;
+#if PT_DELTA_STICK_THRESHOLD > 0
+    if (!unchanged)
+    {
+      xinput_report_t last;
+      memcpy(&last, filter->last, sizeof(last));
+      unchanged = is_stick_noise(report, &last);
+    }
+#endif
+
+    if (unchanged)
+    {
+      filter->suppressed++;
+      return false;
+    }
+  }
+
+  memcpy(filter->last, words, sizeof(words));
+  filter->last_us = now_us;
+  filter->valid = true;
+  filter->sent++;
+  return true;
+}
@@ -1,33 +1,130 @@
 #include "device_callbacks.h"
 #include "bsp/board_api.h"
+#include "latency_stats.h"
+#include "report_mailbox.h"
+#include "output_relay.h"
+#include "command.h"
+#include "event_loop.h"
+#include "sof_align.h"
+#include "boot_timeline.h"
+#include "usb_personality.h"
+#include "device/dcd.h"
 
 extern uint32_t blink_interval_ms;
+//--------------------------------------------------------------------
+// Device state
+//--------------------------------------------------------------------
+void tud_mount_cb(void)
+{
+  boot_mark(BOOT_PC_MOUNTED);
+  usb_personality_mounted();
+}
+
 //--------------------------------------------------------------------
 // Device CDC
 //--------------------------------------------------------------------
 void tud_cdc_rx_cb(uint8_t itf)
 {
-  // allocate buffer for the data in the stack
-  uint8_t buf[CFG_TUD_CDC_RX_BUFSIZE];
+  if (itf == 0)
+  {
+    // Parsed from the main loop, see command.c
+    command_rx_notify();
+  }
+  else
+  {
+    // The telemetry interface takes no input
+    tud_cdc_n_read_flush(itf);
+  }
+}
 
-  printf("RX CDC %d\n", itf);
+//--------------------------------------------------------------------
+// Device events
+//--------------------------------------------------------------------
+// Invoked whenever an event is queued for tud_task(), mostly from the USB IRQ
+void tud_event_hook_cb(uint8_t rhport, uint32_t eventid, bool in_isr)
+{
+  (void)rhport;
+  (void)in_isr;
+  if (eventid == DCD_EVENT_SOF)
+  {
+    sof_align_sof();
+  }
+  event_loop_signal(EVENT_DEVICE);
+}
 
-  // read the available data
-  // | IMPORTANT: also do this for CDC0 because otherwise
-  // | you won't be able to print anymore to CDC0
-  // | next time this function is called
-  uint32_t count = tud_cdc_n_read(itf, buf, sizeof(buf));
+//--------------------------------------------------------------------
+// Device XInput
+//--------------------------------------------------------------------
+// Invoked when the IN report queued on interface itf has been read by the PC
+void tud_xinput_report_complete_cb(uint8_t itf, uint8_t const *report, uint16_t len)
+{
+  (void)report;
+  (void)len;
+  if (itf >= PT_XINPUT_PADS)
+  {
+    return;
+  }
+  latency_stats_completed(itf);
+  sof_align_completed(itf);
 
-  // check if the data was received on the second cdc interface
-  if (itf == 0)
+  // The endpoint is free again, send the newest state if one is waiting.
+  // SOF-aligned scheduling waits for the next commit point instead
+  if (!sof_align_active())
   {
-    // process the received data
-    buf[count] = 0; // null-terminate the string
-    // now echo data back to the console on CDC 0
-    printf("Received on CDC 1: %s\n", buf);
+    report_mailbox_flush(&report_mailbox[itf]);
+  }
+}
+
+// Invoked when the PC sent an OUT report (rumble or LED) on interface itf
+void tud_xinput_report_received_cb(uint8_t itf, uint8_t const *report, uint16_t len)
+{
+  output_relay_post(itf, report, len);
+  event_loop_signal(EVENT_RELAY);
+}
 
-    // and echo back OK on CDC 1
-    tud_cdc_n_write(itf, (uint8_t const *)"OK\r\n", 4);
-    tud_cdc_n_write_flush(itf);
+//--------------------------------------------------------------------
+// Device HID gamepad
+//--------------------------------------------------------------------
+// Invoked when the IN report queued on HID pad instance has been read by the PC
+void tud_hid_report_complete_cb(uint8_t instance, uint8_t const *report, uint16_t len)
+{
+  (void)report;
+  (void)len;
+  if (instance >= PT_XINPUT_PADS)
+  {
+    return;
   }
+
+  // Timed like the XInput endpoint when it is the only one
+  if (usb_personality_active() == USB_PERSONALITY_HID)
+  {
+    latency_stats_completed(instance);
+    sof_align_completed(instance);
+  }
+  if (!sof_align_active())
+  {
+    report_mailbox_flush(&report_mailbox[instance]);
+  }
+}
+
+// The HID pads have no feature or output reports
+uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t *buffer,
+                               uint16_t reqlen)
+{
+  (void)instance;
+  (void)report_id;
+  (void)report_type;
+  (void)buffer;
+  (void)reqlen;
+  return 0;
+}
+
+void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t const *buffer,
+                           uint16_t bufsize)
+{
+  (void)instance;
+  (void)report_id;
+  (void)report_type;
+  (void)buffer;
+  (void)bufsize;
 }
@@ -0,0 +1,94 @@
+#include "event_loop.h"
+
+event_stats_t event_stats;
+
+#if PT_EVENT_LOOP
+
+#include <stddef.h>
+
+#include "pico/platform.h"
+#include "pico/time.h"
+#include "hardware/sync.h"
+
+// A flag is set by whoever signals and cleared by the one core that consumes
+// the event. Clearing happens before the task runs, so a signal that races
+// with the task is seen on the next pass instead of being lost. Only plain
+// loads and stores are used since the M0+ has no exclusive access.
+static atomic_bool pending[EVENT_COUNT];
+static uint32_t pending_since_us[EVENT_COUNT];
+
+static repeating_timer_t tick_timer;
+
+static bool tick_cb(repeating_timer_t *timer)
+{
+  (void)timer;
+  event_loop_signal(EVENT_TICK);
+  return true;
+}
+
+void event_loop_init(void)
+{
+  add_repeating_timer_ms(-PT_EVENT_TICK_MS, tick_cb, NULL, &tick_timer);
+
+  for (uint8_t i = 0; i < EVENT_COUNT; i++)
+  {
+    event_loop_signal(i);
+  }
+}
+
+void event_loop_signal(uint8_t event)
+{
+  if (!atomic_load_explicit(&pending[event], memory_order_relaxed))
+  {
+    pending_since_us[event] = time_us_32();
+    atomic_store_explicit(&pending[event], true, memory_order_release);
+  }
+
+  // Wakes the other core out of WFE. Interrupts on the signalling core set
+  // its own event register on exception return already
+  __sev();
+}
+
+bool event_loop_take(uint8_t event)
+{
+  if (!atomic_load_explicit(&pending[event], memory_order_acquire))
+  {
+    return false;
+  }
+  atomic_store_explicit(&pending[event], false, memory_order_relaxed);
+
+  event_latency_t *lat = &event_stats.latency[event];
+  uint32_t us = time_us_32() - pending_since_us[event];
+  if (us > lat->max_us)
+  {
+    lat->max_us = us;
+  }
+  lat->total_us += us;
+  lat->count++;
+  return true;
+}
+
+void event_loop_sleep(uint32_t mask, bool busy)
+{
+  if (busy)
+  {
+    return;
+  }
+  for (uint8_t i = 0; i < EVENT_COUNT; i++)
+  {
+    if ((mask & EVENT_BIT(i)) && atomic_load_explicit(&pending[i], memory_order_relaxed))
+    {
+      return;
+    }
+  }
+
+  // An IRQ or __sev() that lands between the checks above and the WFE
+  // leaves the event register set, so the WFE returns right away
+  uint32_t start = time_us_32();
+  __wfe();
+  uint32_t core = get_core_num();
+  event_stats.slept_us[core] += time_us_32() - start;
+  event_stats.sleeps[core]++;
+}
+
+#endif
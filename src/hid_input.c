@@ -0,0 +1,164 @@
+#include "hid_input.h"
+
+hid_input_stats_t hid_input_stats[PT_HID_INTERFACES];
+
+#if PT_HID_HOST
+
+#include "pico/time.h"
+
+#include "hid_program.h"
+#include "pad_slot.h"
+
+typedef struct
+{
+  hid_program_t program;
+  hid_pad_t pad;  // last decoded state
+} hid_itf_t;
+
+// Mouse movement turned into a right stick deflection, per device
+typedef struct
+{
+  int16_t rx;
+  int16_t ry;
+  uint32_t moved_us;
+  bool moving;
+} mouse_stick_t;
+
+static hid_itf_t itfs[PT_HID_INTERFACES];
+static mouse_stick_t mouse[PAD_SLOT_MAX_ADDR + 1];
+
+static int16_t clamp16(int32_t v)
+{
+  return (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+}
+
+// The axis with the larger deflection wins
+static int16_t stronger(int16_t a, int16_t b)
+{
+  return (b < 0 ? -(int32_t)b : b) > (a < 0 ? -(int32_t)a : a) ? b : a;
+}
+
+static int find(uint8_t dev_addr, uint8_t idx)
+{
+  for (int i = 0; i < PT_HID_INTERFACES; i++)
+  {
+    if (hid_input_stats[i].dev_addr == dev_addr && hid_input_stats[i].idx == idx)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static void merge(uint8_t dev_addr, xinput_report_t *out)
+{
+  *out = (xinput_report_t){0};
+  out->bSize = 0x14;
+
+  for (int i = 0; i < PT_HID_INTERFACES; i++)
+  {
+    if (hid_input_stats[i].dev_addr != dev_addr)
+    {
+      continue;
+    }
+    hid_pad_t const *p = &itfs[i].pad;
+    out->bmButtons |= p->buttons;
+    out->bLeftTrigger = p->left_trigger > out->bLeftTrigger ? p->left_trigger : out->bLeftTrigger;
+    out->bRightTrigger = p->right_trigger > out->bRightTrigger ? p->right_trigger : out->bRightTrigger;
+    out->wThumbLeftX = stronger(out->wThumbLeftX, p->thumb_lx);
+    out->wThumbLeftY = stronger(out->wThumbLeftY, p->thumb_ly);
+    out->wThumbRightX = stronger(out->wThumbRightX, p->thumb_rx);
+    out->wThumbRightY = stronger(out->wThumbRightY, p->thumb_ry);
+  }
+
+  mouse_stick_t const *m = &mouse[dev_addr];
+  out->wThumbRightX = stronger(out->wThumbRightX, m->rx);
+  out->wThumbRightY = stronger(out->wThumbRightY, m->ry);
+}
+
+bool hid_input_mount(uint8_t dev_addr, uint8_t idx, const uint8_t *desc, uint16_t len)
+{
+  int i = find(0, 0);
+  if (i < 0 || dev_addr > PAD_SLOT_MAX_ADDR)
+  {
+    return false;
+  }
+
+  uint8_t ops = hid_program_compile(desc, len, &itfs[i].program);
+  if (ops == 0)
+  {
+    return false;
+  }
+  itfs[i].pad = (hid_pad_t){0};
+  hid_input_stats[i] = (hid_input_stats_t){.dev_addr = dev_addr, .idx = idx, .ops = ops};
+  mouse[dev_addr] = (mouse_stick_t){0};
+  return true;
+}
+
+bool hid_input_umount(uint8_t dev_addr, uint8_t idx)
+{
+  int i = find(dev_addr, idx);
+  if (i < 0)
+  {
+    return false;
+  }
+  hid_input_stats[i].dev_addr = 0;
+  hid_input_stats[i].idx = 0;
+
+  for (int j = 0; j < PT_HID_INTERFACES; j++)
+  {
+    if (hid_input_stats[j].dev_addr == dev_addr)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool hid_input_report(uint8_t dev_addr, uint8_t idx, const uint8_t *report, uint16_t len, xinput_report_t *out)
+{
+  int i = find(dev_addr, idx);
+  if (i < 0 || dev_addr == 0)
+  {
+    return false;
+  }
+
+  hid_pad_t *pad = &itfs[i].pad;
+  if (!hid_program_decode(&itfs[i].program, report, len, pad))
+  {
+    hid_input_stats[i].ignored++;
+    return false;
+  }
+  hid_input_stats[i].reports++;
+
+  if (pad->mouse_x || pad->mouse_y)
+  {
+    mouse_stick_t *m = &mouse[dev_addr];
+    m->rx = clamp16((int32_t)pad->mouse_x * PT_HID_MOUSE_GAIN);
+    m->ry = clamp16(-(int32_t)pad->mouse_y * PT_HID_MOUSE_GAIN);
+    m->moved_us = time_us_32();
+    m->moving = true;
+  }
+
+  merge(dev_addr, out);
+  return true;
+}
+
+bool hid_input_idle(uint8_t *dev_addr, xinput_report_t *out)
+{
+  uint32_t now = time_us_32();
+  for (uint8_t addr = 1; addr <= PAD_SLOT_MAX_ADDR; addr++)
+  {
+    mouse_stick_t *m = &mouse[addr];
+    if (m->moving && now - m->moved_us >= PT_HID_MOUSE_IDLE_MS * 1000u)
+    {
+      *m = (mouse_stick_t){0};
+      *dev_addr = addr;
+      merge(addr, out);
+      return true;
+    }
+  }
+  return false;
+}
+
+#endif
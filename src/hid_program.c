@@ -0,0 +1,678 @@
+#include <string.h>
+
+#include "hid_program.h"
+
+// Item tags, type included (HID 1.11 section 6.2.2)
+#define ITEM_INPUT 0x80
+#define ITEM_COLLECTION 0xA0
+#define ITEM_END_COLLECTION 0xC0
+#define ITEM_USAGE_PAGE 0x04
+#define ITEM_LOGICAL_MIN 0x14
+#define ITEM_LOGICAL_MAX 0x24
+#define ITEM_REPORT_SIZE 0x74
+#define ITEM_REPORT_ID 0x84
+#define ITEM_REPORT_COUNT 0x94
+#define ITEM_PUSH 0xA4
+#define ITEM_POP 0xB4
+#define ITEM_USAGE 0x08
+#define ITEM_USAGE_MIN 0x18
+#define ITEM_USAGE_MAX 0x28
+#define ITEM_LONG 0xFE
+
+#define INPUT_CONSTANT 0x01
+#define INPUT_VARIABLE 0x02
+#define INPUT_RELATIVE 0x04
+
+#define PAGE_DESKTOP 0x01
+#define PAGE_SIMULATION 0x02
+#define PAGE_KEYBOARD 0x07
+#define PAGE_BUTTON 0x09
+
+#define DESKTOP_MOUSE 0x02
+#define DESKTOP_JOYSTICK 0x04
+#define DESKTOP_GAMEPAD 0x05
+#define DESKTOP_KEYBOARD 0x06
+#define DESKTOP_X 0x30
+#define DESKTOP_RZ 0x35
+#define DESKTOP_HAT 0x39
+#define SIMULATION_ACCELERATOR 0xC4
+#define SIMULATION_BRAKE 0xC5
+
+#define USAGE(page, id) (((uint32_t)(page) << 16) | (id))
+
+#define MAX_USAGES 16
+#define MAX_PUSH 4
+#define MAX_REPORT_IDS 8
+
+// wButtons bits of the XInput report
+enum
+{
+  BIT_DPAD_UP = 0,
+  BIT_DPAD_DOWN,
+  BIT_DPAD_LEFT,
+  BIT_DPAD_RIGHT,
+  BIT_START,
+  BIT_BACK,
+  BIT_LS,
+  BIT_RS,
+  BIT_LB,
+  BIT_RB,
+  BIT_GUIDE,
+  BIT_A = 12,
+  BIT_B,
+  BIT_X,
+  BIT_Y,
+};
+
+// What a button does. 1..16 set wButtons bit (action - 1), the rest drive
+// the triggers or push the left stick to one side
+enum
+{
+  ACT_NONE = 0,
+  ACT_LT = 0x20,
+  ACT_RT,
+  ACT_LEFT,
+  ACT_RIGHT,
+  ACT_DOWN,
+  ACT_UP,
+};
+
+#define ACT_BUTTON(bit) ((bit) + 1)
+
+// Button page usages 1..16 of a generic pad, in the DirectInput order most
+// of them share
+static const uint8_t pad_actions[17] = {
+    [1] = ACT_BUTTON(BIT_A), [2] = ACT_BUTTON(BIT_B), [3] = ACT_BUTTON(BIT_X), [4] = ACT_BUTTON(BIT_Y),
+    [5] = ACT_BUTTON(BIT_LB), [6] = ACT_BUTTON(BIT_RB), [7] = ACT_LT, [8] = ACT_RT,
+    [9] = ACT_BUTTON(BIT_BACK), [10] = ACT_BUTTON(BIT_START), [11] = ACT_BUTTON(BIT_LS), [12] = ACT_BUTTON(BIT_RS),
+    [13] = ACT_BUTTON(BIT_GUIDE),
+};
+
+// Left, right, middle, back, forward
+static const uint8_t mouse_actions[17] = {
+    [1] = ACT_RT, [2] = ACT_LT, [3] = ACT_BUTTON(BIT_RS), [4] = ACT_BUTTON(BIT_LB), [5] = ACT_BUTTON(BIT_RB),
+};
+
+// Keyboard page usages, WASD moves the left stick
+static const uint8_t key_actions[256] = {
+    [0x04] = ACT_LEFT,                  // A
+    [0x06] = ACT_BUTTON(BIT_B),         // C
+    [0x07] = ACT_RIGHT,                 // D
+    [0x08] = ACT_BUTTON(BIT_RB),        // E
+    [0x09] = ACT_BUTTON(BIT_Y),         // F
+    [0x14] = ACT_BUTTON(BIT_LB),        // Q
+    [0x15] = ACT_BUTTON(BIT_X),         // R
+    [0x16] = ACT_DOWN,                  // S
+    [0x19] = ACT_BUTTON(BIT_RS),        // V
+    [0x1A] = ACT_UP,                    // W
+    [0x28] = ACT_BUTTON(BIT_START),     // Enter
+    [0x29] = ACT_BUTTON(BIT_START),     // Escape
+    [0x2B] = ACT_BUTTON(BIT_BACK),      // Tab
+    [0x2C] = ACT_BUTTON(BIT_A),         // Space
+    [0x4F] = ACT_BUTTON(BIT_DPAD_RIGHT),
+    [0x50] = ACT_BUTTON(BIT_DPAD_LEFT),
+    [0x51] = ACT_BUTTON(BIT_DPAD_DOWN),
+    [0x52] = ACT_BUTTON(BIT_DPAD_UP),
+    [0xE0] = ACT_LT,                    // Left Ctrl
+    [0xE1] = ACT_BUTTON(BIT_LS),        // Left Shift
+    [0xE2] = ACT_RT,                    // Left Alt
+};
+
+// Hat directions clockwise from north
+#define UP (1u << BIT_DPAD_UP)
+#define DOWN (1u << BIT_DPAD_DOWN)
+#define LEFT (1u << BIT_DPAD_LEFT)
+#define RIGHT (1u << BIT_DPAD_RIGHT)
+static const uint16_t hat_dpad[8] = {UP, UP | RIGHT, RIGHT, DOWN | RIGHT, DOWN, DOWN | LEFT, LEFT, UP | LEFT};
+
+//--------------------------------------------------------------------+
+// Compiler
+//--------------------------------------------------------------------+
+
+typedef struct
+{
+  uint16_t page;
+  int32_t logical_min;
+  int32_t logical_max;
+  uint32_t logical_max_raw;  // as stored, for maxima that only fit unsigned
+  uint8_t report_size;
+  uint8_t report_id;
+  uint16_t report_count;
+} globals_t;
+
+typedef struct
+{
+  hid_program_t *prog;
+  uint8_t app;  // Generic Desktop usage of the enclosing application collection
+  uint8_t ids[MAX_REPORT_IDS];
+  uint16_t offsets[MAX_REPORT_IDS];  // input bits per report ID so far
+  uint8_t id_count;
+} compiler_t;
+
+static uint16_t *input_offset(compiler_t *c, uint8_t id)
+{
+  for (uint8_t i = 0; i < c->id_count; i++)
+  {
+    if (c->ids[i] == id)
+    {
+      return &c->offsets[i];
+    }
+  }
+  if (c->id_count == MAX_REPORT_IDS)
+  {
+    return NULL;
+  }
+  c->ids[c->id_count] = id;
+  c->offsets[c->id_count] = 0;
+  return &c->offsets[c->id_count++];
+}
+
+static hid_op_t *emit(compiler_t *c, uint8_t kind, uint8_t target, globals_t const *g, uint16_t offset)
+{
+  hid_program_t *prog = c->prog;
+  if (prog->count == HID_PROGRAM_MAX_OPS)
+  {
+    return NULL;
+  }
+  hid_op_t *op = &prog->op[prog->count++];
+  *op = (hid_op_t){
+      .offset = offset, .size = g->report_size, .count = 1, .kind = kind, .target = target,
+      .report_id = g->report_id, .min = g->logical_min};
+  return op;
+}
+
+// A one-bit button, folded into the previous op when it directly follows it
+static void emit_bit(compiler_t *c, uint8_t map, uint8_t usage, globals_t const *g, uint16_t offset)
+{
+  hid_program_t *prog = c->prog;
+  hid_op_t *last = prog->count ? &prog->op[prog->count - 1] : NULL;
+  if (last && last->kind == HID_OP_BITS && last->target == map && last->report_id == g->report_id &&
+      last->offset + last->count == offset && last->usage + last->count == usage && last->count < 32)
+  {
+    last->count++;
+    return;
+  }
+
+  hid_op_t *op = emit(c, HID_OP_BITS, map, g, offset);
+  if (op)
+  {
+    op->usage = usage;
+  }
+}
+
+static void compile_variable(compiler_t *c, uint32_t usage, uint8_t flags, globals_t const *g, uint16_t offset)
+{
+  uint16_t page = (uint16_t)(usage >> 16);
+  uint16_t id = (uint16_t)usage;
+  uint8_t buttons = c->app == DESKTOP_MOUSE ? HID_MAP_MOUSE : HID_MAP_PAD;
+  uint32_t span = (uint32_t)g->logical_max - (uint32_t)g->logical_min;
+
+  if (page == PAGE_DESKTOP && (flags & INPUT_RELATIVE))
+  {
+    if (id == DESKTOP_X || id == DESKTOP_X + 1)
+    {
+      emit(c, HID_OP_MOUSE, (uint8_t)(HID_CTRL_MOUSE_X + id - DESKTOP_X), g, offset);
+    }
+  }
+  else if ((page == PAGE_DESKTOP && id >= DESKTOP_X && id <= DESKTOP_RZ) ||
+           (page == PAGE_SIMULATION && (id == SIMULATION_ACCELERATOR || id == SIMULATION_BRAKE)))
+  {
+    // Desktop axes keep their usage as target until compile_finish() knows
+    // which of them the device has
+    uint8_t target = page == PAGE_SIMULATION ? (id == SIMULATION_BRAKE ? HID_CTRL_LT : HID_CTRL_RT) : (uint8_t)id;
+    hid_op_t *op = span ? emit(c, HID_OP_AXIS, target, g, offset) : NULL;
+    if (op)
+    {
+      op->usage = page == PAGE_DESKTOP ? (uint8_t)id : 0;
+      op->span = span;
+      op->scale = 0xFFFFFFFFu / span;
+    }
+  }
+  else if (page == PAGE_DESKTOP && id == DESKTOP_HAT)
+  {
+    // Eight directions, or four on hats that only report the main ones
+    hid_op_t *op = (span == 3 || span == 7) ? emit(c, HID_OP_HAT, 0, g, offset) : NULL;
+    if (op)
+    {
+      op->count = (uint8_t)(span + 1);
+    }
+  }
+  else if (g->report_size == 1 && id <= 0xFF && (page == PAGE_BUTTON || page == PAGE_KEYBOARD))
+  {
+    emit_bit(c, page == PAGE_KEYBOARD ? HID_MAP_KEYS : buttons, (uint8_t)id, g, offset);
+  }
+}
+
+static void compile_input(compiler_t *c, uint8_t flags, globals_t const *g, uint32_t const *usages,
+                          uint8_t usage_count, uint32_t usage_min, uint32_t usage_max)
+{
+  uint16_t *offset = input_offset(c, g->report_id);
+  if (!offset)
+  {
+    return;
+  }
+  uint16_t start = *offset;
+  *offset = (uint16_t)(start + g->report_size * g->report_count);
+
+  bool usable = c->app == DESKTOP_JOYSTICK || c->app == DESKTOP_GAMEPAD || c->app == DESKTOP_KEYBOARD ||
+                c->app == DESKTOP_MOUSE;
+  if (!usable || (flags & INPUT_CONSTANT) || g->report_size == 0 || g->report_size > 32)
+  {
+    return;
+  }
+
+  if (flags & INPUT_VARIABLE)
+  {
+    for (uint16_t i = 0; i < g->report_count; i++)
+    {
+      uint32_t usage;
+      if (usage_count)
+      {
+        usage = usages[i < usage_count ? i : usage_count - 1];
+      }
+      else if (usage_max >= usage_min && usage_min + i <= usage_max)
+      {
+        usage = usage_min + i;
+      }
+      else
+      {
+        continue;
+      }
+      compile_variable(c, usage, flags, g, (uint16_t)(start + i * g->report_size));
+    }
+    return;
+  }
+
+  // Array of pressed buttons or keys, each slot holds usage_min + value - logical_min
+  uint32_t first = usage_count ? usages[0] : usage_min;
+  uint16_t page = (uint16_t)(first >> 16);
+  if ((page == PAGE_KEYBOARD || page == PAGE_BUTTON) && (first & 0xFFFF) <= 0xFF)
+  {
+    uint8_t map = page == PAGE_KEYBOARD ? HID_MAP_KEYS : c->app == DESKTOP_MOUSE ? HID_MAP_MOUSE : HID_MAP_PAD;
+    hid_op_t *op = emit(c, HID_OP_ARRAY, map, g, start);
+    if (op)
+    {
+      op->count = g->report_count > 0xFF ? 0xFF : (uint8_t)g->report_count;
+      op->usage = (uint8_t)first;
+    }
+  }
+}
+
+// Sticks and triggers for the Generic Desktop axes. X/Y is the left stick.
+// Pads with both Z and Rz put the right stick there and the triggers on
+// Rx/Ry, the others the other way round
+static void compile_finish(compiler_t *c)
+{
+  hid_program_t *prog = c->prog;
+  uint8_t have = 0;
+  for (uint8_t i = 0; i < prog->count; i++)
+  {
+    if (prog->op[i].kind == HID_OP_AXIS && prog->op[i].usage)
+    {
+      have |= (uint8_t)(1u << (prog->op[i].usage - DESKTOP_X));
+    }
+  }
+
+  bool z_rz = (have & 0x24) == 0x24;
+  // X, Y, Z, Rx, Ry, Rz
+  static const uint8_t controls[2][6] = {
+      {HID_CTRL_LX, HID_CTRL_LY, HID_CTRL_LT, HID_CTRL_RX, HID_CTRL_RY, HID_CTRL_RT},
+      {HID_CTRL_LX, HID_CTRL_LY, HID_CTRL_RX, HID_CTRL_LT, HID_CTRL_RT, HID_CTRL_RY},
+  };
+  for (uint8_t i = 0; i < prog->count; i++)
+  {
+    hid_op_t *op = &prog->op[i];
+    if (op->kind == HID_OP_AXIS && op->usage)
+    {
+      op->target = controls[z_rz][op->usage - DESKTOP_X];
+      op->usage = 0;
+    }
+  }
+
+  prog->report_ids = c->id_count > 1 || (c->id_count == 1 && c->ids[0] != 0);
+  prog->report_bytes = 0;
+  for (uint8_t i = 0; i < c->id_count; i++)
+  {
+    uint16_t bytes = (uint16_t)((c->offsets[i] + 7) / 8 + (prog->report_ids ? 1 : 0));
+    if (bytes > prog->report_bytes)
+    {
+      prog->report_bytes = bytes;
+    }
+  }
+}
+
+static uint32_t item_data(const uint8_t *p, uint8_t size)
+{
+  uint32_t v = 0;
+  for (uint8_t i = 0; i < size; i++)
+  {
+    v |= (uint32_t)p[i] << (8 * i);
+  }
+  return v;
+}
+
+static int32_t item_signed(uint32_t v, uint8_t size)
+{
+  if (size == 1)
+  {
+    return (int8_t)v;
+  }
+  if (size == 2)
+  {
+    return (int16_t)v;
+  }
+  return (int32_t)v;
+}
+
+uint8_t hid_program_compile(const uint8_t *desc, uint16_t len, hid_program_t *prog)
+{
+  memset(prog, 0, sizeof(*prog));
+  compiler_t c = {.prog = prog};
+
+  globals_t g = {0};
+  globals_t stack[MAX_PUSH];
+  uint8_t depth = 0;
+  uint8_t collections = 0;
+  uint8_t app_depth = 0;
+
+  uint32_t usages[MAX_USAGES];
+  uint8_t usage_count = 0;
+  uint32_t usage_min = 1, usage_max = 0;
+
+  uint16_t i = 0;
+  while (i < len)
+  {
+    uint8_t prefix = desc[i];
+    if (prefix == ITEM_LONG)
+    {
+      i = (uint16_t)(i + 3 + (i + 1 < len ? desc[i + 1] : 0));
+      continue;
+    }
+
+    uint8_t size = (prefix & 3) == 3 ? 4 : (prefix & 3);
+    if (i + 1 + size > len)
+    {
+      break;
+    }
+    uint32_t data = item_data(&desc[i + 1], size);
+    uint8_t tag = prefix & 0xFC;
+    i = (uint16_t)(i + 1 + size);
+
+    switch (tag)
+    {
+    case ITEM_USAGE_PAGE:
+      g.page = (uint16_t)data;
+      break;
+    case ITEM_LOGICAL_MIN:
+      g.logical_min = item_signed(data, size);
+      break;
+    case ITEM_LOGICAL_MAX:
+      g.logical_max = item_signed(data, size);
+      g.logical_max_raw = data;
+      break;
+    case ITEM_REPORT_SIZE:
+      g.report_size = (uint8_t)data;
+      break;
+    case ITEM_REPORT_ID:
+      g.report_id = (uint8_t)data;
+      break;
+    case ITEM_REPORT_COUNT:
+      g.report_count = (uint16_t)data;
+      break;
+    case ITEM_PUSH:
+      if (depth < MAX_PUSH)
+      {
+        stack[depth++] = g;
+      }
+      break;
+    case ITEM_POP:
+      if (depth)
+      {
+        g = stack[--depth];
+      }
+      break;
+
+    case ITEM_USAGE:
+      if (usage_count < MAX_USAGES)
+      {
+        usages[usage_count++] = size == 4 ? data : USAGE(g.page, data);
+      }
+      break;
+    case ITEM_USAGE_MIN:
+      usage_min = size == 4 ? data : USAGE(g.page, data);
+      break;
+    case ITEM_USAGE_MAX:
+      usage_max = size == 4 ? data : USAGE(g.page, data);
+      break;
+
+    case ITEM_COLLECTION:
+      collections++;
+      if (data == 0x01 && c.app == 0)
+      {
+        // Application collection, its usage says what the fields inside are
+        uint32_t usage = usage_count ? usages[0] : 0;
+        c.app = (usage >> 16) == PAGE_DESKTOP ? (uint8_t)usage : 0xFF;
+        app_depth = collections;
+      }
+      break;
+    case ITEM_END_COLLECTION:
+      if (collections && collections-- == app_depth)
+      {
+        c.app = 0;
+      }
+      break;
+    case ITEM_INPUT:
+    {
+      // A logical maximum that only fits unsigned, e.g. 0xFF in one byte
+      globals_t field = g;
+      if (field.logical_max < field.logical_min && field.logical_min >= 0)
+      {
+        field.logical_max = (int32_t)field.logical_max_raw;
+      }
+      compile_input(&c, (uint8_t)data, &field, usages, usage_count, usage_min, usage_max);
+      break;
+    }
+    default:
+      break;
+    }
+
+    // Local items only last until the next main item
+    if ((prefix & 0x0C) == 0x00)
+    {
+      usage_count = 0;
+      usage_min = 1;
+      usage_max = 0;
+    }
+  }
+
+  compile_finish(&c);
+  return prog->count;
+}
+
+//--------------------------------------------------------------------+
+// Decoder
+//--------------------------------------------------------------------+
+
+// Little-endian bit field, bits past the end of the report read as 0
+static uint32_t extract(const uint8_t *data, uint16_t len, uint16_t offset, uint8_t size)
+{
+  uint16_t byte = offset >> 3;
+  uint8_t shift = offset & 7;
+  uint8_t bytes = (uint8_t)((shift + size + 7) >> 3);
+  uint64_t raw = 0;
+  for (uint8_t i = 0; i < bytes && byte + i < len; i++)
+  {
+    raw |= (uint64_t)data[byte + i] << (8 * i);
+  }
+  raw >>= shift;
+  return size == 32 ? (uint32_t)raw : (uint32_t)raw & ((1u << size) - 1);
+}
+
+static int32_t extract_signed(const uint8_t *data, uint16_t len, hid_op_t const *op)
+{
+  uint32_t v = extract(data, len, op->offset, op->size);
+  if (op->min < 0 && op->size < 32 && (v & (1u << (op->size - 1))))
+  {
+    v |= ~0u << op->size;
+  }
+  return (int32_t)v;
+}
+
+static void act(hid_pad_t *pad, uint8_t *dirs, uint8_t action)
+{
+  if (action == ACT_NONE)
+  {
+    return;
+  }
+  if (action <= 16)
+  {
+    pad->buttons |= (uint16_t)(1u << (action - 1));
+  }
+  else if (action == ACT_LT)
+  {
+    pad->left_trigger = 0xFF;
+  }
+  else if (action == ACT_RT)
+  {
+    pad->right_trigger = 0xFF;
+  }
+  else
+  {
+    *dirs |= (uint8_t)(1u << (action - ACT_LEFT));
+  }
+}
+
+static uint8_t action_of(uint8_t map, uint32_t usage)
+{
+  if (map == HID_MAP_KEYS)
+  {
+    return usage <= 0xFF ? key_actions[usage] : ACT_NONE;
+  }
+  if (usage > 16)
+  {
+    return ACT_NONE;
+  }
+  return map == HID_MAP_MOUSE ? mouse_actions[usage] : pad_actions[usage];
+}
+
+static int16_t clamp16(int32_t v)
+{
+  return (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+}
+
+bool hid_program_decode(const hid_program_t *prog, const uint8_t *report, uint16_t len, hid_pad_t *pad)
+{
+  uint8_t id = 0;
+  if (prog->report_ids)
+  {
+    if (len == 0)
+    {
+      return false;
+    }
+    id = report[0];
+    report++;
+    len--;
+  }
+
+  hid_pad_t out = {0};
+  uint8_t dirs = 0;
+  bool matched = false;
+
+  for (uint8_t i = 0; i < prog->count; i++)
+  {
+    hid_op_t const *op = &prog->op[i];
+    if (op->report_id != id)
+    {
+      continue;
+    }
+    matched = true;
+
+    switch (op->kind)
+    {
+    case HID_OP_AXIS:
+    {
+      uint32_t v = (uint32_t)extract_signed(report, len, op) - (uint32_t)op->min;
+      uint32_t u = ((v > op->span ? op->span : v) * op->scale) >> 16;
+      switch (op->target)
+      {
+      case HID_CTRL_LX:
+        out.thumb_lx = (int16_t)((int32_t)u - 32768);
+        break;
+      case HID_CTRL_LY:
+        out.thumb_ly = (int16_t)(32767 - (int32_t)u);
+        break;
+      case HID_CTRL_RX:
+        out.thumb_rx = (int16_t)((int32_t)u - 32768);
+        break;
+      case HID_CTRL_RY:
+        out.thumb_ry = (int16_t)(32767 - (int32_t)u);
+        break;
+      case HID_CTRL_LT:
+        out.left_trigger = (uint8_t)(u >> 8);
+        break;
+      case HID_CTRL_RT:
+        out.right_trigger = (uint8_t)(u >> 8);
+        break;
+      }
+      break;
+    }
+
+    case HID_OP_MOUSE:
+      if (op->target == HID_CTRL_MOUSE_X)
+      {
+        out.mouse_x = clamp16(extract_signed(report, len, op));
+      }
+      else
+      {
+        out.mouse_y = clamp16(extract_signed(report, len, op));
+      }
+      break;
+
+    case HID_OP_HAT:
+    {
+      uint32_t dir = ((uint32_t)extract_signed(report, len, op) - (uint32_t)op->min) * (8u / op->count);
+      if (dir < 8)
+      {
+        out.buttons |= hat_dpad[dir];
+      }
+      break;
+    }
+
+    case HID_OP_BITS:
+    {
+      uint32_t bits = extract(report, len, op->offset, op->count);
+      for (uint8_t b = 0; bits; b++, bits >>= 1)
+      {
+        if (bits & 1)
+        {
+          act(&out, &dirs, action_of(op->target, op->usage + b));
+        }
+      }
+      break;
+    }
+
+    case HID_OP_ARRAY:
+      for (uint8_t s = 0; s < op->count; s++)
+      {
+        // 0 is the usual "nothing pressed", unless the usages start at 0
+        uint32_t v = extract(report, len, (uint16_t)(op->offset + s * op->size), op->size) - (uint32_t)op->min;
+        if (v < 0x100 && (v > 0 || op->usage != 0))
+        {
+          act(&out, &dirs, action_of(op->target, op->usage + v));
+        }
+      }
+      break;
+    }
+  }
+
+  if (!matched)
+  {
+    return false;
+  }
+
+  // Opposite keys cancel out
+  out.thumb_lx = clamp16(out.thumb_lx + ((dirs & 2) ? 32767 : 0) - ((dirs & 1) ? 32767 : 0));
+  out.thumb_ly = clamp16(out.thumb_ly + ((dirs & 8) ? 32767 : 0) - ((dirs & 4) ? 32767 : 0));
+  *pad = out;
+  return true;
+}
@@ -2,6 +2,11 @@
 #include "tusb.h"
 #include "bsp/board_api.h"
 #include "pico/bootrom.h"
+#include "host_poll.h"
+#include "event_loop.h"
+#include "boot_timeline.h"
+#include "pad_cache.h"
+#include "host/hcd.h"
 #include <stdio.h>
 
 extern uint32_t blink_interval_ms;
@@ -22,4 +27,26 @@ void tuh_umount_cb(uint8_t daddr) {
   (void)daddr;
   blink_interval_ms = 1000;
 
+}
+// Invoked whenever an event is queued for tuh_task(), mostly from the PIO USB frame timer
+void tuh_event_hook_cb(uint8_t rhport, uint32_t eventid, bool in_isr) {
+  (void)rhport;
+  (void)in_isr;
+  if (eventid == HCD_EVENT_DEVICE_ATTACH) {
+    boot_mark(BOOT_PAD_ATTACHED);
+    pad_cache_attach();
+  }
+  event_loop_signal(EVENT_HOST);
+}
+bool tuh_enum_descriptor_device_cb(uint8_t daddr, tusb_desc_device_t const* desc_device) {
+  pad_cache_device(daddr, desc_device);
+  return true;
+}
+bool tuh_enum_descriptor_configuration_cb(uint8_t daddr, uint8_t cfg_index, tusb_desc_configuration_t const* desc_config) {
+  (void)cfg_index;
+  pad_cache_config(daddr, desc_config);
+  // The descriptor sits in the enumeration buffer the drivers open their
+  // endpoints from, so the poll interval can be overridden right here
+  host_poll_patch_config(daddr, (tusb_desc_configuration_t*)(uintptr_t)desc_config);
+  return true;
 }
\ No newline at end of file
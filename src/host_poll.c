@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/time.h"
+
+#include "host_poll.h"
+#include "pad_slot.h"
+
+host_poll_stats_t host_poll_stats[PT_XINPUT_PADS];
+
+// Intervals seen during enumeration, before the pad has a slot
+static uint8_t native_interval[PAD_SLOT_MAX_ADDR + 1];
+static uint8_t patched_interval[PAD_SLOT_MAX_ADDR + 1];
+
+void host_poll_patch_config(uint8_t daddr, tusb_desc_configuration_t *desc_config)
+{
+  uint8_t *p = (uint8_t *)desc_config;
+  uint8_t const *end = p + tu_le16toh(desc_config->wTotalLength);
+  uint8_t itf_class = 0;
+
+  p = (uint8_t *)tu_desc_next(p);
+  while (p < end && tu_desc_len(p) >= 2)
+  {
+    if (tu_desc_type(p) == TUSB_DESC_INTERFACE)
+    {
+      itf_class = ((tusb_desc_interface_t const *)p)->bInterfaceClass;
+    }
+    else if (tu_desc_type(p) == TUSB_DESC_ENDPOINT && itf_class == TUSB_CLASS_VENDOR_SPECIFIC)
+    {
+      tusb_desc_endpoint_t *ep = (tusb_desc_endpoint_t *)p;
+      if (ep->bmAttributes.xfer == TUSB_XFER_INTERRUPT && tu_edpt_dir(ep->bEndpointAddress) == TUSB_DIR_IN)
+      {
+        if (daddr <= PAD_SLOT_MAX_ADDR)
+        {
+          native_interval[daddr] = ep->bInterval;
+        }
+#if PT_HOST_POLL_INTERVAL_MS
+        // Only ever poll faster than the pad asked for
+        if (ep->bInterval > PT_HOST_POLL_INTERVAL_MS)
+        {
+          printf("Poll interval of %u:%02X %u -> %u ms\n", daddr, ep->bEndpointAddress, ep->bInterval,
+                 PT_HOST_POLL_INTERVAL_MS);
+          ep->bInterval = PT_HOST_POLL_INTERVAL_MS;
+        }
+#endif
+        if (daddr <= PAD_SLOT_MAX_ADDR)
+        {
+          patched_interval[daddr] = ep->bInterval;
+        }
+      }
+    }
+    p = (uint8_t *)tu_desc_next(p);
+  }
+}
+
+void host_poll_mounted(uint8_t slot, uint8_t daddr)
+{
+  if (slot >= PT_XINPUT_PADS)
+  {
+    return;
+  }
+
+  host_poll_stats_t *s = &host_poll_stats[slot];
+  memset(s, 0, sizeof(*s));
+  if (daddr <= PAD_SLOT_MAX_ADDR)
+  {
+    s->native_interval = native_interval[daddr];
+    s->interval = patched_interval[daddr];
+  }
+  s->window_start_us = time_us_32();
+}
+
+void host_poll_completed(uint8_t slot, bool success)
+{
+  if (slot >= PT_XINPUT_PADS)
+  {
+    return;
+  }
+
+  host_poll_stats_t *s = &host_poll_stats[slot];
+  if (!success)
+  {
+    s->failed++;
+    return;
+  }
+
+  uint32_t now = time_us_32();
+  if (s->received)
+  {
+    uint32_t gap = now - s->last_us;
+    if (gap > s->window_max_gap_us)
+    {
+      s->window_max_gap_us = gap;
+    }
+  }
+  s->last_us = now;
+  s->received++;
+  s->window_count++;
+
+  // Publish once per second so the rate reads as reports per second
+  if (now - s->window_start_us >= 1000000)
+  {
+    s->rate_hz = (uint32_t)((uint64_t)s->window_count * 1000000 / (now - s->window_start_us));
+    s->max_gap_us = s->window_max_gap_us;
+    s->window_count = 0;
+    s->window_max_gap_us = 0;
+    s->window_start_us = now;
+  }
+}
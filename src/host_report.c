@@ -0,0 +1,36 @@
+#include "host_report.h"
+#include "host_poll.h"
+#include "pad_cache.h"
+#include "pad_slot.h"
+#include "report_translate.h"
+#include "stage_profile.h"
+#include "xinput_host.h"
+
+// Application callback invoked when XInput report is received
+// For passthrough, we send a device report for every report we receive
+void tuh_xinput_report_received_cb(uint8_t dev_addr, uint8_t instance, xinputh_interface_t const *xid_itf, uint16_t len)
+{
+  (void)len; // unused
+  const xinput_gamepad_t *p = &xid_itf->pad;
+  uint8_t slot = pad_slot_lookup(dev_addr, instance);
+  host_poll_completed(slot, xid_itf->last_xfer_result == XFER_RESULT_SUCCESS);
+  if (xid_itf->last_xfer_result == XFER_RESULT_SUCCESS && slot != PAD_SLOT_NONE)
+  {
+    if (xid_itf->connected && xid_itf->new_pad_data)
+    {
+      report_frame_t frame;
+      report_frame_stamp(&frame);
+      frame.slot = slot;
+      uint32_t t = stage_profile_now();
+
+      // Create a report to send to the PC.
+      report_translate(p, &frame.report);
+      report_frame_keep_raw(&frame);
+      stage_profile_record(PROFILE_TRANSLATE, t);
+
+      report_process(&frame);
+    }
+  }
+  pad_cache_report(slot);
+  tuh_xinput_receive_report(dev_addr, instance);
+}
@@ -0,0 +1,43 @@
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include <stdint.h>
+
+#include "passthrough_config.h"
+
+// Milestones from power-on to the first report reaching the PC, in the
+// order they normally happen
+enum
+{
+  BOOT_CLOCK = 0,     // system clock switched to 240 MHz
+  BOOT_BOARD,         // board_init() done
+  BOOT_SETTINGS,      // settings loaded from flash
+  BOOT_DEVICE_STACK,  // device tusb_init() done
+  BOOT_HOST_STACK,    // PIO USB host tusb_init() done
+  BOOT_STDIO,         // stdio_usb_init() done
+  BOOT_LOOP,          // main loop entered
+  BOOT_PC_MOUNTED,    // the PC configured the device
+  BOOT_PAD_ATTACHED,  // first device attached to the host port
+  BOOT_PAD_MOUNTED,   // first XInput pad mounted
+  BOOT_FIRST_REPORT,  // first report handed to the device stack
+  BOOT_PHASE_COUNT,
+};
+
+// time_us_32() of every milestone, 0 until it is reached. The timer runs
+// from reset, so these are microseconds since power-on
+extern uint32_t boot_timeline[BOOT_PHASE_COUNT];
+
+extern const char *const boot_phase_names[BOOT_PHASE_COUNT];
+
+#if PT_BOOT_TIMELINE
+
+// Record a milestone the first time it is reached. Safe from IRQs and either core
+void boot_mark(uint8_t phase);
+
+#else
+
+static inline void boot_mark(uint8_t phase) { (void)phase; }
+
+#endif
+
+#endif
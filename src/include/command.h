@@ -0,0 +1,41 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "passthrough_config.h"
+
+// Line-based command protocol on CDC interface 0. Bytes are fed in as they
+// arrive, in chunks of any size, and every complete line is executed from
+// the main loop. Nothing is allocated and a line longer than
+// PT_COMMAND_LINE_MAX - 1 characters is discarded as a whole.
+typedef struct
+{
+  char line[PT_COMMAND_LINE_MAX];
+  uint16_t len;
+  bool overflow;  // the current line outgrew the buffer, skip it
+} command_parser_t;
+
+void command_parser_reset(command_parser_t *parser);
+
+// Feed up to len bytes. Stops after the first complete line and returns the
+// number of bytes consumed, *line_ready tells whether parser->line now holds
+// a NUL-terminated line
+uint32_t command_parser_feed(command_parser_t *parser, const uint8_t *data, uint32_t len, bool *line_ready);
+
+// Split a line into whitespace separated tokens in place, returns the count.
+// A line with more than max_args tokens returns max_args + 1, argv then
+// holds the first max_args of them
+uint8_t command_tokenize(char *line, char **argv, uint8_t max_args);
+
+// Execute one line
+void command_execute(char *line);
+
+// Invoked from tud_cdc_rx_cb, only records that there is something to read
+void command_rx_notify(void);
+
+// Main loop. Read pending input and run every complete line
+void command_task(void);
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "passthrough_config.h"
+#include "settings.h"
+
+// Log-structured settings store in the last PT_CONFIG_STORE_SECTORS sectors
+// of flash. Every save appends one page-sized, CRC-checked record with a
+// higher sequence number. When the log reaches the end of a sector the next
+// sector is erased and writing continues there, so erases rotate over the
+// whole region and the previous record always survives a torn write.
+typedef struct
+{
+  uint32_t seq;      // sequence number of the newest record, 0 if none
+  uint32_t writes;   // records written since boot
+  uint32_t erases;   // sectors erased since boot
+  uint32_t failed;   // flash operations that could not lock out the other core
+  bool loaded;       // settings came from flash at boot
+  bool pending;      // a save waits for the report path to go idle
+  uint32_t macro_writes;  // macro recordings written since boot
+  bool macro_pending;     // a macro save waits for the report path to go idle
+} config_store_stats_t;
+
+extern config_store_stats_t config_store_stats;
+
+// Find the newest valid record with a single scan of the region and copy it
+// into out. Returns false and leaves out untouched if there is none. Reads
+// through XIP only, so it is safe to call before anything else is running
+bool config_store_load(settings_t *out);
+
+// Request that the current settings are written. The write itself happens
+// in config_store_task() once no report has been forwarded for a while
+void config_store_save(void);
+
+// Device core loop. Performs a pending save when the report path is idle
+void config_store_task(void);
+
+// The macro recording lives in its own PT_MACRO_FLASH_SECTORS right below
+// the settings, as one CRC-checked blob that is rewritten on every save.
+// Request that data[0..len) is written, the buffer must stay untouched and
+// a multiple of FLASH_PAGE_SIZE long until macro_pending clears
+void config_store_save_macro(const uint8_t *data, uint32_t len);
+
+// Copy the saved recording into data at boot. Returns its length, 0 if
+// there is none or it does not fit into max bytes
+uint32_t config_store_load_macro(uint8_t *data, uint32_t max);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef DELTA_FILTER_H
+#define DELTA_FILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "passthrough_config.h"
+#include "xinput_device.h"
+
+#define DELTA_REPORT_WORDS ((sizeof(xinput_report_t) + 3) / 4)
+
+// Suppresses reports whose payload matches the last one forwarded
+typedef struct
+{
+  uint32_t last[DELTA_REPORT_WORDS];  // last forwarded report
+  uint32_t last_us;                   // when it was forwarded
+  bool valid;
+  uint32_t sent;
+  uint32_t suppressed;
+} delta_filter_t;
+
+// One filter per XInput device interface
+extern delta_filter_t delta_filter[PT_XINPUT_PADS];
+
+void delta_filter_reset(delta_filter_t *filter);
+
+// Returns true if the report should be forwarded. A report is held back when
+// it equals the last forwarded one, or differs only by stick movements of at
+// most PT_DELTA_STICK_THRESHOLD, unless PT_DELTA_KEEPALIVE_MS have passed.
+bool delta_filter_check(delta_filter_t *filter, const xinput_report_t *report, uint32_t now_us);
+
+#endif
@@ -17,4 +17,16 @@ void tud_resume_cb(void);
 
 void tud_cdc_rx_cb(uint8_t itf);
 
+// Invoked when an event is queued for tud_task()
+void tud_event_hook_cb(uint8_t rhport, uint32_t eventid, bool in_isr);
+
+// Invoked when an XInput IN report has been sent to the PC
+void tud_xinput_report_complete_cb(uint8_t itf, uint8_t const *report, uint16_t len);
+
+// Invoked when the PC sent an XInput OUT report
+void tud_xinput_report_received_cb(uint8_t itf, uint8_t const *report, uint16_t len);
+
+// Invoked when a HID gamepad IN report has been sent to the PC
+void tud_hid_report_complete_cb(uint8_t instance, uint8_t const *report, uint16_t len);
+
 #endif
@@ -0,0 +1,74 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "passthrough_config.h"
+
+// Work the main loops wait for. Each event is consumed by exactly one core
+enum
+{
+  EVENT_DEVICE = 0,  // tud_task() has queued work, set from the USB IRQ
+  EVENT_HOST,        // tuh_task() has queued work, set from the PIO USB frame timer
+  EVENT_RING,        // core1 pushed a report into a report ring
+  EVENT_RELAY,       // the PC posted a rumble or LED request
+  EVENT_TICK,        // periodic timer for the self-timed tasks
+  EVENT_COUNT,
+};
+
+#define EVENT_BIT(event) (1u << (event))
+
+// Time from an event being signalled until the loop starts serving it
+typedef struct
+{
+  uint32_t count;
+  uint32_t max_us;
+  uint32_t total_us;
+} event_latency_t;
+
+typedef struct
+{
+  event_latency_t latency[EVENT_COUNT];
+  uint32_t sleeps[2];    // times each core went to sleep
+  uint64_t slept_us[2];  // time each core spent asleep
+} event_stats_t;
+
+extern event_stats_t event_stats;
+
+#if PT_EVENT_LOOP
+
+// Start the tick timer and schedule a first pass of every task, call once
+// from core0
+void event_loop_init(void);
+
+// Mark an event pending and wake the other core. Safe from IRQs and either core
+void event_loop_signal(uint8_t event);
+
+// Consume a pending event. Returns true if the matching task should run
+bool event_loop_take(uint8_t event);
+
+// Sleep with WFE until an interrupt or the other core signals, unless one of
+// the events in mask is already pending or busy is set
+void event_loop_sleep(uint32_t mask, bool busy);
+
+#else
+
+// Busy-polling loop, every task runs on every pass
+static inline void event_loop_init(void) {}
+static inline void event_loop_signal(uint8_t event) { (void)event; }
+static inline bool event_loop_take(uint8_t event)
+{
+  (void)event;
+  return true;
+}
+static inline void event_loop_sleep(uint32_t mask, bool busy)
+{
+  (void)mask;
+  (void)busy;
+}
+
+#endif
+
+#endif
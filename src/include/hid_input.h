@@ -0,0 +1,46 @@
+#ifndef HID_INPUT_H
+#define HID_INPUT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "passthrough_config.h"
+#include "xinput_device.h"
+
+// HID pads, keyboards and mice passed through as XInput pads. The report
+// descriptor of every HID interface is compiled once at mount into a
+// field-extraction program (hid_program.h) that each report then runs
+// through. All interfaces of one device drive the same pad, so a keyboard
+// and mouse on one receiver add up: mouse movement deflects the right
+// stick until the mouse has rested for PT_HID_MOUSE_IDLE_MS.
+typedef struct
+{
+  uint8_t dev_addr;  // 0 when the entry is free
+  uint8_t idx;       // HID interface of the device
+  uint8_t ops;       // size of its program
+  uint32_t reports;  // reports decoded
+  uint32_t ignored;  // reports with an ID the program has no ops for
+} hid_input_stats_t;
+
+extern hid_input_stats_t hid_input_stats[PT_HID_INTERFACES];
+
+#if PT_HID_HOST
+
+// Compile the report descriptor of a new interface. Returns false if it has
+// nothing a pad could use, its reports are not requested then
+bool hid_input_mount(uint8_t dev_addr, uint8_t idx, const uint8_t *desc, uint16_t len);
+
+// Forget an interface. Returns true if it was the last one of its device
+bool hid_input_umount(uint8_t dev_addr, uint8_t idx);
+
+// Decode a report and merge it with the other interfaces of the device.
+// Returns true if out holds a new state for the device's pad
+bool hid_input_report(uint8_t dev_addr, uint8_t idx, const uint8_t *report, uint16_t len, xinput_report_t *out);
+
+// Host core, polled. Returns true with the new state of a device whose mouse
+// came to rest, right stick centred
+bool hid_input_idle(uint8_t *dev_addr, xinput_report_t *out);
+
+#endif
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef HID_PROGRAM_H
+#define HID_PROGRAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Longest program, a 16-button pad with a hat and six axes takes 8 ops, a
+// boot keyboard 2
+#define HID_PROGRAM_MAX_OPS 32
+
+// Kinds of op
+enum
+{
+  HID_OP_AXIS = 0,  // absolute value scaled onto a stick or trigger
+  HID_OP_MOUSE,     // relative value summed into the mouse deltas
+  HID_OP_HAT,       // hat switch onto the d-pad
+  HID_OP_BITS,      // count one-bit buttons with consecutive usages
+  HID_OP_ARRAY,     // count slots holding the usage of a pressed button
+};
+
+// Targets of AXIS and MOUSE ops
+enum
+{
+  HID_CTRL_LX = 0,
+  HID_CTRL_LY,
+  HID_CTRL_RX,
+  HID_CTRL_RY,
+  HID_CTRL_LT,
+  HID_CTRL_RT,
+  HID_CTRL_MOUSE_X,
+  HID_CTRL_MOUSE_Y,
+};
+
+// Button tables of BITS and ARRAY ops
+enum
+{
+  HID_MAP_PAD = 0,  // button page of a joystick or gamepad
+  HID_MAP_MOUSE,    // button page of a mouse
+  HID_MAP_KEYS,     // keyboard page
+};
+
+// One field extraction, compiled from a report descriptor
+typedef struct
+{
+  uint16_t offset;    // bit offset of the first value, after the report ID
+  uint8_t size;       // bits per value, 1..32
+  uint8_t count;      // values, 1 for AXIS and MOUSE, directions for HAT
+  uint8_t kind;       // HID_OP_*
+  uint8_t target;     // HID_CTRL_* or HID_MAP_*
+  uint8_t report_id;  // 0 when the device uses no report IDs
+  uint8_t usage;      // BITS and ARRAY: usage of the first value
+  int32_t min;        // logical minimum
+  uint32_t span;      // AXIS: logical maximum - minimum
+  uint32_t scale;     // AXIS: Q16 factor from value - min to 0..65535, span * scale < 2^32
+} hid_op_t;
+
+typedef struct
+{
+  uint8_t count;
+  bool report_ids;        // every report starts with a report ID
+  uint16_t report_bytes;  // longest input report, ID included
+  hid_op_t op[HID_PROGRAM_MAX_OPS];
+} hid_program_t;
+
+// Decoded state in XInput terms. Buttons use the wButtons layout of the
+// XInput report, sticks are Y-up
+typedef struct
+{
+  uint16_t buttons;
+  uint8_t left_trigger;
+  uint8_t right_trigger;
+  int16_t thumb_lx;
+  int16_t thumb_ly;
+  int16_t thumb_rx;
+  int16_t thumb_ry;
+  int16_t mouse_x;  // relative movement of this report, Y down
+  int16_t mouse_y;
+} hid_pad_t;
+
+// Compile the input fields of the joystick, gamepad, keyboard and mouse
+// collections of a report descriptor. Everything else is left out. Returns
+// the number of ops, 0 if the device has nothing a pad could use
+uint8_t hid_program_compile(const uint8_t *desc, uint16_t len, hid_program_t *prog);
+
+// Run the program over one input report. Returns false, leaving pad alone,
+// if the report has an ID the program has no ops for
+bool hid_program_decode(const hid_program_t *prog, const uint8_t *report, uint16_t len, hid_pad_t *pad);
+
+#endif
@@ -9,7 +9,13 @@ void tuh_mount_cb(uint8_t daddr);
 // Invoked when a device is unmounted
 void tuh_umount_cb(uint8_t daddr);
 
-void tuh_enum_descriptor_device_cb(uint8_t daddr, tusb_desc_device_t const* desc_device);
+bool tuh_enum_descriptor_device_cb(uint8_t daddr, tusb_desc_device_t const* desc_device);
+
+// Invoked when an event is queued for tuh_task()
+void tuh_event_hook_cb(uint8_t rhport, uint32_t eventid, bool in_isr);
+
+// Invoked with the configuration descriptor before the class drivers parse it
+bool tuh_enum_descriptor_configuration_cb(uint8_t daddr, uint8_t cfg_index, tusb_desc_configuration_t const* desc_config);
 
 void tuh_descriptor_get_device_cb(tuh_xfer_t* xfer);
 
@@ -0,0 +1,39 @@
+#ifndef HOST_POLL_H
+#define HOST_POLL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "passthrough_config.h"
+#include "tusb.h"
+
+// Rate at which a pad's IN endpoint actually delivers reports, measured on
+// the host core for every completed transfer
+typedef struct
+{
+  uint32_t received;     // transfers that completed successfully
+  uint32_t failed;       // transfers that completed with an error
+  uint32_t rate_hz;      // successful transfers during the last full second
+  uint32_t max_gap_us;   // longest gap between two of them in that second
+  uint8_t interval;      // bInterval in use, 0 until the pad is mounted
+  uint8_t native_interval;  // bInterval the pad asked for
+  uint32_t last_us;
+  uint32_t window_start_us;
+  uint32_t window_count;
+  uint32_t window_max_gap_us;
+} host_poll_stats_t;
+
+extern host_poll_stats_t host_poll_stats[PT_XINPUT_PADS];
+
+// Shorten the bInterval of every vendor-class interrupt IN endpoint in a
+// configuration descriptor to PT_HOST_POLL_INTERVAL_MS. The descriptor is
+// patched in place before the class drivers open their endpoints
+void host_poll_patch_config(uint8_t daddr, tusb_desc_configuration_t *desc_config);
+
+// A pad was mounted on slot, start measuring from scratch
+void host_poll_mounted(uint8_t slot, uint8_t daddr);
+
+// An IN transfer of the pad on slot completed
+void host_poll_completed(uint8_t slot, bool success);
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef HOST_REPORT_H
+#define HOST_REPORT_H
+
+#include "report_frame.h"
+
+// The XInput report callback of the host core (host_report.c). It only
+// reaches the SDK through TinyUSB's types and the headers of the firmware's
+// own modules, so tools/translate_sim builds it against a fake host stack.
+
+// Run a translated report through the pipeline and submit it to the device
+// stack, host core. Provided by passthrough.c
+void report_process(report_frame_t *frame);
+
+#endif
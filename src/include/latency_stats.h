@@ -0,0 +1,70 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "passthrough_config.h"
+#include "tusb.h"
+
+// Latency stages measured along the report path
+enum
+{
+  LATENCY_RX_TO_QUEUE = 0,    // host callback -> tud_xinput_n_report accepted
+  LATENCY_QUEUE_TO_COMPLETE,  // tud_xinput_n_report accepted -> IN transfer done
+  LATENCY_RX_TO_COMPLETE,     // host callback -> IN transfer done
+  LATENCY_STAGE_COUNT,
+};
+
+// Fixed-bucket histogram, bucket i counts samples in
+// [i * PT_LATENCY_BUCKET_US, (i + 1) * PT_LATENCY_BUCKET_US), the last
+// bucket also collects everything beyond the range
+typedef struct
+{
+  uint32_t count;
+  uint32_t min_us;
+  uint32_t max_us;
+  uint32_t p99_us; // upper edge of the bucket holding the 99th percentile
+  uint32_t buckets[PT_LATENCY_BUCKETS];
+} latency_hist_t;
+
+typedef struct
+{
+  latency_hist_t stage[LATENCY_STAGE_COUNT];
+} latency_stats_t;
+
+#if PT_LATENCY_STATS
+
+void latency_stats_reset(void);
+
+// Record that a frame received at rx_us was accepted by an XInput interface
+void latency_stats_queued(uint8_t itf, uint32_t rx_us);
+
+// Record that the IN transfer of the last frame queued on itf completed
+void latency_stats_completed(uint8_t itf);
+
+// Copy the current histograms out, p99 is computed during the copy
+void latency_stats_snapshot(latency_stats_t *out);
+
+// Serve PT_VENDOR_REQUEST_LATENCY, returns false for any other request
+bool latency_stats_control_xfer(uint8_t rhport, tusb_control_request_t const *request);
+
+#else
+
+static inline void latency_stats_reset(void) {}
+static inline void latency_stats_queued(uint8_t itf, uint32_t rx_us)
+{
+  (void)itf;
+  (void)rx_us;
+}
+static inline void latency_stats_completed(uint8_t itf) { (void)itf; }
+static inline bool latency_stats_control_xfer(uint8_t rhport, tusb_control_request_t const *request)
+{
+  (void)rhport;
+  (void)request;
+  return false;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef MACRO_H
+#define MACRO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "passthrough_config.h"
+#include "report_frame.h"
+
+// Replayed events later than this count as missed in macro_stats
+#define MACRO_LATE_LIMIT_US 100
+
+typedef enum
+{
+  MACRO_IDLE = 0,
+  MACRO_RECORDING,
+  MACRO_REPLAYING,
+} macro_state_t;
+
+extern const char *const macro_state_names[];
+
+// Input macros. Recording keeps the processed state of one pad, as it is
+// about to go to the PC, in a RAM buffer of PT_MACRO_BUFFER_SIZE bytes. Only
+// the fields that changed are stored, delta-encoded with the time since the
+// previous change (macro_codec.h), so a pad that streams unchanged reports
+// costs nothing. Replay steps through the recording with one-shot alarms of
+// the default alarm pool and sends each state through the normal device path
+// at its recorded offset, while live reports of the replayed slot are held
+// back. The recording can be saved to flash and is loaded again at boot.
+typedef struct
+{
+  uint32_t events;    // events in the recording
+  uint32_t bytes;     // length of the recording
+  uint32_t captured;  // reports seen while recording, stored or not
+  bool full;          // recording stopped because the buffer ran out
+  uint32_t replayed;  // events sent by the last replay
+  uint32_t held_back; // live reports dropped during replays
+  uint32_t late_min_us; // alarm target -> report posted
+  uint32_t late_max_us;
+  uint64_t late_total_us;
+  uint32_t late_over; // events posted more than MACRO_LATE_LIMIT_US late
+} macro_stats_t;
+
+extern macro_stats_t macro_stats;
+
+#if PT_MACRO
+
+// Load the saved recording, device core
+void macro_init(void);
+
+macro_state_t macro_state(void);
+
+// Device core. Start a new recording of slot, dropping the old one. Fails
+// while recording or replaying, or while the old one is being saved
+bool macro_record_start(uint8_t slot);
+
+// Device core. End the recording or replay in progress
+void macro_stop(void);
+
+// Device core. Replay the recording on slot, fails when there is none or
+// something is in progress
+bool macro_replay_start(uint8_t slot);
+
+// Device core. Write the recording to flash once the pads are idle
+bool macro_save(void);
+
+// Host core, for every processed frame. Records it if its slot is being
+// recorded. Returns false if the frame must not be sent because its slot is
+// being replayed
+bool macro_capture(const report_frame_t *frame);
+
+// Device core loop. Returns the next replayed frame once it is due
+bool macro_task(report_frame_t *frame);
+
+#else
+
+static inline void macro_init(void) {}
+static inline bool macro_capture(const report_frame_t *frame)
+{
+  (void)frame;
+  return true;
+}
+static inline bool macro_task(report_frame_t *frame)
+{
+  (void)frame;
+  return false;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef MACRO_CODEC_H
+#define MACRO_CODEC_H
+
+// Timeline format of recorded macros. Shared between the firmware and
+// tools/macro_codec_bench, so it only depends on the C standard library.
+//
+// A recording is a sequence of events, each the change from the state the
+// previous events produced (all zero at the start):
+//   dt_us (varint) | mask | one value per bit set in mask, in bit order
+// dt_us is the time since the previous event, the first one counts from the
+// start of the recording. Mask bits are MACRO_FIELD_*, bit 7 is reserved.
+// Buttons carry the XOR with the previous buttons, triggers and sticks the
+// zigzag-coded difference to their previous value. Varints are LEB128, 7
+// bits per byte, least significant first. An event with an empty mask
+// changes nothing and only marks time, e.g. the end of a recording.
+
+#include <stdint.h>
+
+#include "telemetry_proto.h"
+
+enum
+{
+  MACRO_FIELD_BUTTONS = 0,
+  MACRO_FIELD_LT,
+  MACRO_FIELD_RT,
+  MACRO_FIELD_LX,
+  MACRO_FIELD_LY,
+  MACRO_FIELD_RX,
+  MACRO_FIELD_RY,
+  MACRO_FIELD_COUNT,
+};
+
+// Longest event: dt 5, mask 1, buttons 3, triggers 2 x 2, sticks 4 x 3
+#define MACRO_EVENT_MAX 25
+
+// Encoder or decoder position in a recording
+typedef struct
+{
+  telemetry_pad_t pad;  // state after the last event
+  uint32_t t_us;        // time of the last event
+} macro_codec_t;
+
+// Start a recording, or its replay, at t_us with every field zero
+void macro_codec_reset(macro_codec_t *c, uint32_t t_us);
+
+// Encode the change from the codec state to pad at t_us into out, which must
+// hold MACRO_EVENT_MAX bytes. Returns the length of the event, 0 if nothing
+// changed and nothing was written
+uint8_t macro_encode(macro_codec_t *c, uint32_t t_us, telemetry_pad_t const *pad, uint8_t *out);
+
+// Encode an event that only marks t_us. Returns its length
+uint8_t macro_encode_mark(macro_codec_t *c, uint32_t t_us, uint8_t *out);
+
+// Decode the event at in and apply it to the codec state. Returns the bytes
+// it took, 0 if it is truncated or malformed, leaving the state alone
+uint8_t macro_decode(macro_codec_t *c, uint8_t const *in, uint32_t len);
+
+#endif
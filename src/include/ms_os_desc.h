@@ -0,0 +1,43 @@
+#ifndef MS_OS_DESC_H
+#define MS_OS_DESC_H
+
+#include <stdint.h>
+
+#include "passthrough_config.h"
+
+// Microsoft OS descriptors that bind the XInput interfaces to the XUSB10
+// driver without an INF. Windows 8.1 and later read the MS OS 2.0
+// descriptor set announced in the BOS in one request during enumeration.
+// Older versions fall back to the MS OS 1.0 0xEE string and the compat ID
+// request, which are kept for them.
+// https://learn.microsoft.com/en-us/windows-hardware/drivers/usbcon/microsoft-os-2-0-descriptors-specification
+
+// Vendor codes of the descriptor requests (bmRequestType 0xC0). Both share
+// one code, the wIndex tells them apart
+#define MS_OS_1_0_VENDOR_CODE 0x90
+#define MS_OS_2_0_VENDOR_CODE 0x90
+
+// wIndex of the MS OS 1.0 extended compat ID request
+#define MS_OS_1_0_COMPAT_ID_INDEX 0x0004
+
+// wIndex of the MS OS 2.0 descriptor set request
+#define MS_OS_2_0_DESCRIPTOR_INDEX 0x0007
+
+// MS OS 1.0 extended compat ID: 16 byte header, 24 bytes per XInput interface
+#define MS_OS_1_0_COMPAT_ID_LEN (16 + 24 * PT_XINPUT_PADS)
+
+// MS OS 2.0 descriptor set: set header, one configuration subset and per
+// XInput interface a function subset holding its compatible ID
+#define MS_OS_2_0_SET_LEN (10 + 8 + (8 + 20) * PT_XINPUT_PADS)
+
+// BOS with the USB 2.0 extension, and the MS OS 2.0 platform capability
+// if there are XInput interfaces
+#define USB_BOS_PLAIN_LEN (5 + 7)
+#define USB_BOS_MS_OS_LEN (USB_BOS_PLAIN_LEN + 28)
+
+extern const uint8_t ms_os_1_0_compat_id[MS_OS_1_0_COMPAT_ID_LEN];
+extern const uint8_t ms_os_2_0_set[MS_OS_2_0_SET_LEN];
+extern const uint8_t usb_bos_plain[USB_BOS_PLAIN_LEN];
+extern const uint8_t usb_bos_ms_os[USB_BOS_MS_OS_LEN];
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef OUTPUT_RELAY_H
+#define OUTPUT_RELAY_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "passthrough_config.h"
+
+// Coalescing queue that carries rumble and LED requests from the PC (device
+// core) to the physical controllers (host core). Each request is a single
+// 32-bit word tagged with a sequence number, the device core only stores and
+// the host core only loads, so a newer request simply replaces an older one
+// that has not been forwarded yet.
+typedef struct
+{
+  atomic_uint rumble;    // seq << 16 | left << 8 | right, written by the device core
+  atomic_uint led;       // seq << 8 | quadrant, written by the device core
+  uint32_t rumble_seq;   // device core: sequence number of the last rumble posted
+  uint32_t led_seq;      // device core: sequence number of the last LED posted
+  uint32_t rumble_sent;  // host core: last rumble word forwarded
+  uint32_t led_sent;     // host core: last LED word forwarded
+  bool busy;             // host core: an OUT transfer to the pad is in flight
+  uint32_t forwarded;    // host core: requests sent to the pad
+  uint32_t coalesced;    // host core: requests replaced before they were sent
+} output_relay_t;
+
+extern output_relay_t output_relay[PT_XINPUT_PADS];
+
+// Device core. Decode an OUT report from the PC and queue it for the pad
+void output_relay_post(uint8_t slot, uint8_t const *report, uint16_t len);
+
+// Host core. Forward the newest pending request of every idle pad
+void output_relay_task(void);
+
+// Host core. Re-send the current state to a freshly mounted pad
+void output_relay_mounted(uint8_t slot);
+
+// Host core. An OUT transfer was started outside the relay, hold requests
+// for the pad back until output_relay_sent()
+void output_relay_claim(uint8_t slot);
+
+// Host core. The OUT transfer to a pad finished
+void output_relay_sent(uint8_t slot);
+
+#endif
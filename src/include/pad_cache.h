@@ -0,0 +1,42 @@
+#ifndef PAD_CACHE_H
+#define PAD_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "passthrough_config.h"
+#include "tusb.h"
+
+// Remembers the device descriptor and a fingerprint of the configuration
+// descriptor of the last PT_XINPUT_PADS pads. A pad whose descriptors match
+// an entry is known to be the same model and firmware as before, so its
+// mount skips the blocking LED/rumble reset and starts streaming reports
+// first. Also times every connection from attach to the first report.
+typedef struct
+{
+  uint32_t connects;        // pads mounted on this slot
+  uint32_t fast_connects;   // of those, recognised from the cache
+  uint32_t mount_us;        // last connection: attach -> XInput mount callback
+  uint32_t first_report_us; // last connection: attach -> first report
+  uint32_t best_us;         // fastest attach -> first report seen
+  bool last_fast;           // the last connection took the fast path
+} pad_connect_stats_t;
+
+extern pad_connect_stats_t pad_connect_stats[PT_XINPUT_PADS];
+
+// Host IRQ. A device was attached to the root port
+void pad_cache_attach(void);
+
+// Enumeration callbacks. Note the descriptors of daddr and compare them
+// against the cache, which only takes them once daddr mounts as a pad
+void pad_cache_device(uint8_t daddr, tusb_desc_device_t const *desc);
+void pad_cache_config(uint8_t daddr, tusb_desc_configuration_t const *desc);
+
+// The XInput interface of daddr was mounted on slot. Returns true if the
+// pad may take the fast path
+bool pad_cache_mounted(uint8_t slot, uint8_t daddr);
+
+// A report of the pad on slot was received
+void pad_cache_report(uint8_t slot);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef PAD_SLOT_H
+#define PAD_SLOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "passthrough_config.h"
+#include "tusb.h"
+
+#define PAD_SLOT_NONE 0xFF
+
+// Largest dev_addr TinyUSB hands out, the hub itself takes an address too
+#define PAD_SLOT_MAX_ADDR (CFG_TUH_DEVICE_MAX + CFG_TUH_HUB)
+
+// Controllers with several pads behind one device (e.g. wireless receivers)
+// expose one instance per pad
+#define PAD_SLOT_MAX_INSTANCES 4
+
+// All HID interfaces of a device drive one pad, they share this instance
+#define PAD_SLOT_HID PAD_SLOT_MAX_INSTANCES
+
+// Maps each mounted (dev_addr, instance) to one of the PT_XINPUT_PADS device
+// interfaces. Only the host core touches it.
+extern uint8_t pad_slot_map[PAD_SLOT_MAX_ADDR + 1][PAD_SLOT_MAX_INSTANCES + 1];
+
+void pad_slot_init(void);
+
+// Assign a slot on mount. A controller that comes back at the same address
+// and instance gets its previous slot if that one is still free. Returns
+// PAD_SLOT_NONE when every slot is taken.
+uint8_t pad_slot_acquire(uint8_t dev_addr, uint8_t instance);
+
+// Free the slot on unmount, returns the slot that was released
+uint8_t pad_slot_release(uint8_t dev_addr, uint8_t instance);
+
+// Reverse lookup, returns false if nothing is mounted on the slot
+bool pad_slot_owner(uint8_t slot, uint8_t *dev_addr, uint8_t *instance);
+
+// O(1) lookup for the report callback
+static inline uint8_t pad_slot_lookup(uint8_t dev_addr, uint8_t instance)
+{
+  if (dev_addr > PAD_SLOT_MAX_ADDR || instance > PAD_SLOT_HID)
+  {
+    return PAD_SLOT_NONE;
+  }
+  return pad_slot_map[dev_addr][instance];
+}
+
+#endif
@@ -0,0 +1,279 @@
+#ifndef PASSTHROUGH_CONFIG_H
+#define PASSTHROUGH_CONFIG_H
+
+// Compile-time switches for the passthrough application.
+// Every option can be overridden from CMake with target_compile_definitions.
+
+//--------------------------------------------------------------------+
+// Core layout
+//--------------------------------------------------------------------+
+
+// Run the PIO USB host stack on core1 and hand translated reports to core0
+// through a single-producer/single-consumer ring
+#ifndef PT_DUAL_CORE
+#define PT_DUAL_CORE 0
+#endif
+
+// Sleep with WFE between events instead of polling every task as fast as
+// possible. USB interrupts, the PIO USB frame timer and the other core wake
+// the loop up again
+#ifndef PT_EVENT_LOOP
+#define PT_EVENT_LOOP 1
+#endif
+
+// Period of the wake-up that drives the LED, telemetry counters and other
+// self-timed tasks
+#ifndef PT_EVENT_TICK_MS
+#define PT_EVENT_TICK_MS 10
+#endif
+
+// Hardware alarms. The RP2040 has four and every claim panics once they are
+// gone, so a claim is a budget item:
+//   - the pico_time default alarm pool (event loop tick, macro replay)
+//   - the alarm pool PIO USB creates for its SOF timer
+//   - PT_SOF_ALIGN's commit alarm
+//   - PT_TURBO's tick alarm
+// Anything else that needs a timer goes into the default pool with
+// add_alarm_at(). With at most four claims the order in which the cores make
+// them does not matter
+#define PT_HARDWARE_ALARMS (2 + PT_SOF_ALIGN + PT_TURBO)
+
+// Number of reports the core1 -> core0 ring can hold, must be a power of two
+#ifndef PT_REPORT_RING_SIZE
+#define PT_REPORT_RING_SIZE 8
+#endif
+
+// When set, core0 only forwards the newest report in the ring and discards
+// any older ones that piled up while it was busy
+#ifndef PT_REPORT_RING_LATEST_WINS
+#define PT_REPORT_RING_LATEST_WINS 1
+#endif
+
+// Number of XInput interfaces presented to the PC. Each mounted controller
+// behind the hub gets its own interface, up to four
+#ifndef PT_XINPUT_PADS
+#define PT_XINPUT_PADS 1
+#endif
+
+// Accept HID gamepads, joysticks, keyboards and mice on the host port too
+// and present each device as an XInput pad, see hid_input.h
+#ifndef PT_HID_HOST
+#define PT_HID_HOST 1
+#endif
+
+// HID interfaces mounted at once, a keyboard/mouse receiver takes two or three
+#ifndef PT_HID_INTERFACES
+#define PT_HID_INTERFACES 4
+#endif
+
+// Right stick deflection per mouse count
+#ifndef PT_HID_MOUSE_GAIN
+#define PT_HID_MOUSE_GAIN 1024
+#endif
+
+// The right stick re-centres once the mouse has not moved for this long
+#ifndef PT_HID_MOUSE_IDLE_MS
+#define PT_HID_MOUSE_IDLE_MS 20
+#endif
+
+// What the device enumerates as until the personality command changes it:
+// 0 XInput, 1 generic HID gamepad, 2 both, see usb_personality.h
+#ifndef PT_USB_PERSONALITY
+#define PT_USB_PERSONALITY 0
+#endif
+
+// How long the device stays off the bus when it switches personality. The
+// PC has to notice the detach, 20 ms is plenty for a full-speed port
+#ifndef PT_USB_DETACH_MS
+#define PT_USB_DETACH_MS 20
+#endif
+
+// Hold reports back and commit the newest one shortly before the PC is
+// expected to poll, instead of sending each one as soon as it arrives
+#ifndef PT_SOF_ALIGN
+#define PT_SOF_ALIGN 0
+#endif
+
+// How long before the expected poll the commit happens
+#ifndef PT_SOF_ALIGN_GUARD_US
+#define PT_SOF_ALIGN_GUARD_US 150
+#endif
+
+// Completions per learning window of the poll phase and period
+#ifndef PT_SOF_ALIGN_WINDOW
+#define PT_SOF_ALIGN_WINDOW 256
+#endif
+
+//--------------------------------------------------------------------+
+// Input processing
+//--------------------------------------------------------------------+
+
+// Stages of the processing pipeline, see pipeline.h. A stage that is off
+// compiles away entirely
+#ifndef PT_STAGE_REMAP
+#define PT_STAGE_REMAP 1
+#endif
+
+#ifndef PT_STAGE_SMOOTH
+#define PT_STAGE_SMOOTH 1
+#endif
+
+#ifndef PT_STAGE_CURVE
+#define PT_STAGE_CURVE 1
+#endif
+
+// Run the stages through a function pointer table that can be reconfigured
+// at runtime instead of the inlined straight-line sequence
+#ifndef PT_PIPELINE_RUNTIME
+#define PT_PIPELINE_RUNTIME 0
+#endif
+
+// Per-button rapid fire driven by a hardware alarm, see turbo.h
+#ifndef PT_TURBO
+#define PT_TURBO 1
+#endif
+
+// Period of the turbo alarm, the resolution of every turbo toggle
+#ifndef PT_TURBO_TICK_US
+#define PT_TURBO_TICK_US 1000
+#endif
+
+// Record and replay input macros, see macro.h
+#ifndef PT_MACRO
+#define PT_MACRO 1
+#endif
+
+// RAM for one recording, a multiple of the 256-byte flash page
+#ifndef PT_MACRO_BUFFER_SIZE
+#define PT_MACRO_BUFFER_SIZE 32768
+#endif
+
+// Flash sectors below the settings that hold the saved recording, one page
+// more than PT_MACRO_BUFFER_SIZE
+#ifndef PT_MACRO_FLASH_SECTORS
+#define PT_MACRO_FLASH_SECTORS 9
+#endif
+
+// Stick response tables hold 2^PT_CURVE_LUT_BITS + 1 entries (8 or 10)
+#ifndef PT_CURVE_LUT_BITS
+#define PT_CURVE_LUT_BITS 8
+#endif
+
+// Poll the pads' interrupt IN endpoint at least every this many frames (1 ms
+// each on the full-speed PIO USB port), 0 keeps the bInterval of the pad
+#ifndef PT_HOST_POLL_INTERVAL_MS
+#define PT_HOST_POLL_INTERVAL_MS 0
+#endif
+
+// Skip reports whose translated payload did not change since the last one
+#ifndef PT_DELTA_SUPPRESS
+#define PT_DELTA_SUPPRESS 0
+#endif
+
+// Forward an unchanged report anyway once this much time has passed
+#ifndef PT_DELTA_KEEPALIVE_MS
+#define PT_DELTA_KEEPALIVE_MS 100
+#endif
+
+// Stick movements up to this many counts are treated as unchanged, 0 = exact
+#ifndef PT_DELTA_STICK_THRESHOLD
+#define PT_DELTA_STICK_THRESHOLD 0
+#endif
+
+// Size of the command line buffer on CDC 0. Lines of up to
+// PT_COMMAND_LINE_MAX - 1 characters are accepted, longer ones are discarded
+#ifndef PT_COMMAND_LINE_MAX
+#define PT_COMMAND_LINE_MAX 96
+#endif
+
+// Record microsecond timestamps of every boot milestone, see boot_timeline.h
+#ifndef PT_BOOT_TIMELINE
+#define PT_BOOT_TIMELINE 1
+#endif
+
+// Recognise a re-plugged pad by its cached descriptors and skip the
+// blocking LED/rumble reset when mounting it
+#ifndef PT_FAST_RECONNECT
+#define PT_FAST_RECONNECT 1
+#endif
+
+// Flash sectors at the end of flash that hold the settings log, at least 2
+#ifndef PT_CONFIG_STORE_SECTORS
+#define PT_CONFIG_STORE_SECTORS 2
+#endif
+
+// A save is written once no report has been forwarded for this long
+#ifndef PT_CONFIG_STORE_IDLE_MS
+#define PT_CONFIG_STORE_IDLE_MS 1000
+#endif
+
+// How long a save may wait for the other core to be parked
+#ifndef PT_CONFIG_STORE_LOCKOUT_MS
+#define PT_CONFIG_STORE_LOCKOUT_MS 100
+#endif
+
+//--------------------------------------------------------------------+
+// Instrumentation
+//--------------------------------------------------------------------+
+
+// Keep end-to-end latency histograms of the report path. When 0 every hook
+// compiles to nothing
+#ifndef PT_LATENCY_STATS
+#define PT_LATENCY_STATS 1
+#endif
+
+// Histogram geometry, the covered range is PT_LATENCY_BUCKETS * PT_LATENCY_BUCKET_US
+#ifndef PT_LATENCY_BUCKETS
+#define PT_LATENCY_BUCKETS 64
+#endif
+
+#ifndef PT_LATENCY_BUCKET_US
+#define PT_LATENCY_BUCKET_US 32
+#endif
+
+// Time every processing stage in CPU cycles with the SysTick of the host core
+#ifndef PT_STAGE_PROFILE
+#define PT_STAGE_PROFILE 1
+#endif
+
+// Stream binary samples and counters on CDC interface 1, see telemetry_proto.h
+#ifndef PT_TELEMETRY
+#define PT_TELEMETRY 1
+#endif
+
+// Interval between two counter snapshots in the telemetry stream
+#ifndef PT_TELEMETRY_COUNTERS_MS
+#define PT_TELEMETRY_COUNTERS_MS 100
+#endif
+
+// Vendor control request (bmRequestType 0xC0) that returns latency_stats_t
+#ifndef PT_VENDOR_REQUEST_LATENCY
+#define PT_VENDOR_REQUEST_LATENCY 0x91
+#endif
+
+// Vendor control request (bmRequestType 0xC0) that returns stage_profile_t[]
+#ifndef PT_VENDOR_REQUEST_PROFILE
+#define PT_VENDOR_REQUEST_PROFILE 0x92
+#endif
+
+#if PT_HARDWARE_ALARMS > 4
+#error More hardware alarms claimed than the RP2040 has, move a timer into the default alarm pool
+#endif
+
+#if PT_XINPUT_PADS < 1 || PT_XINPUT_PADS > 4
+#error PT_XINPUT_PADS must be between 1 and 4
+#endif
+
+#if PT_HID_INTERFACES < 1
+#error PT_HID_INTERFACES must be at least 1
+#endif
+
+#if PT_CONFIG_STORE_SECTORS < 2
+#error PT_CONFIG_STORE_SECTORS must be at least 2 so a record survives an erase
+#endif
+
+#if (PT_REPORT_RING_SIZE & (PT_REPORT_RING_SIZE - 1)) != 0
+#error PT_REPORT_RING_SIZE must be a power of two
+#endif
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "passthrough_config.h"
+#include "settings.h"
+#include "stage_profile.h"
+#include "stick_filter.h"
+#include "xinput_device.h"
+
+// Processing applied to every translated report, in this order. Each stage
+// is selected at build time with its PT_STAGE_* switch, a stage that is off
+// compiles away entirely.
+enum
+{
+  PIPELINE_REMAP = 0,
+  PIPELINE_SMOOTH,
+  PIPELINE_CURVE,
+  PIPELINE_STAGE_COUNT,
+};
+
+#define PIPELINE_BIT(stage) (1u << (stage))
+
+// Stages present in this build
+#define PIPELINE_STAGES_BUILT                             \
+  ((PT_STAGE_REMAP ? PIPELINE_BIT(PIPELINE_REMAP) : 0) |   \
+   (PT_STAGE_SMOOTH ? PIPELINE_BIT(PIPELINE_SMOOTH) : 0) | \
+   (PT_STAGE_CURVE ? PIPELINE_BIT(PIPELINE_CURVE) : 0))
+
+// Per-pad state of the stateful stages
+typedef struct
+{
+  stick_filter_state_t filter;
+} pipeline_state_t;
+
+// Host core, indexed by pad slot
+extern pipeline_state_t pipeline_state[PT_XINPUT_PADS];
+
+// Everything a stage may look at besides the report itself
+typedef struct
+{
+  const settings_tables_t *tables;
+  pipeline_state_t *state;  // of the pad the report belongs to
+  uint8_t slot;
+  uint32_t now_us;          // receive time of the report
+} pipeline_ctx_t;
+
+extern const char *const pipeline_stage_names[PIPELINE_STAGE_COUNT];
+
+static inline void pipeline_smooth(const pipeline_ctx_t *ctx, xinput_report_t *report)
+{
+  int16_t axes[STICK_FILTER_AXES] = {report->wThumbLeftX, report->wThumbLeftY, report->wThumbRightX, report->wThumbRightY};
+  stick_filter_apply(&ctx->tables->filter, &ctx->state->filter, axes, ctx->now_us);
+  report->wThumbLeftX = axes[0];
+  report->wThumbLeftY = axes[1];
+  report->wThumbRightX = axes[2];
+  report->wThumbRightY = axes[3];
+}
+
+// Straight-line pipeline. Every built stage is inlined into the caller and
+// works on a local copy of the report the compiler can keep in registers.
+// profile must be a constant, false drops the per-stage timing
+static inline void pipeline_run_static(const pipeline_ctx_t *ctx, xinput_report_t *report, bool profile)
+{
+  xinput_report_t r = *report;
+  uint32_t t = profile ? stage_profile_now() : 0;
+  (void)ctx;
+
+#if PT_STAGE_REMAP
+  remap_apply(&ctx->tables->remap, &r);
+  if (profile)
+  {
+    t = stage_profile_record(PROFILE_REMAP, t);
+  }
+#endif
+
+#if PT_STAGE_SMOOTH
+  pipeline_smooth(ctx, &r);
+  if (profile)
+  {
+    t = stage_profile_record(PROFILE_SMOOTH, t);
+  }
+#endif
+
+#if PT_STAGE_CURVE
+  curve_apply(&ctx->tables->curve, &r);
+  if (profile)
+  {
+    t = stage_profile_record(PROFILE_CURVE, t);
+  }
+#endif
+
+  (void)t;
+  *report = r;
+}
+
+// Table-driven pipeline that calls every stage enabled in the runtime mask
+// through a function pointer
+void pipeline_run_dynamic(const pipeline_ctx_t *ctx, xinput_report_t *report, bool profile);
+
+// Runtime stage selection for pipeline_run_dynamic(), limited to the built
+// stages. Written by the device core, read by the host core
+extern atomic_uint pipeline_mask;
+
+void pipeline_set_mask(uint32_t mask);
+
+// The pipeline the report path uses, chosen with PT_PIPELINE_RUNTIME
+static inline void pipeline_run(const pipeline_ctx_t *ctx, xinput_report_t *report)
+{
+  uint32_t start = stage_profile_now();
+#if PT_PIPELINE_RUNTIME
+  pipeline_run_dynamic(ctx, report, true);
+#else
+  pipeline_run_static(ctx, report, true);
+#endif
+  stage_profile_record(PROFILE_PIPELINE, start);
+}
+
+// Time both variants on synthetic reports with the current settings.
+// Returns the average cycles per report of each
+void pipeline_bench(uint32_t iterations, uint32_t *static_cycles, uint32_t *dynamic_cycles);
+
+#endif
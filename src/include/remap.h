@@ -0,0 +1,61 @@
+#ifndef REMAP_H
+#define REMAP_H
+
+#include <stdint.h>
+
+#include "xinput_device.h"
+
+#define REMAP_BUTTON_COUNT 16
+#define REMAP_STICK_AXES 4   // LX, LY, RX, RY in report order
+#define REMAP_TRIGGERS 2     // LT, RT in report order
+#define REMAP_NONE 0xFF      // button_src value that leaves the output bit clear
+
+// Human-editable mapping. Output element i takes its value from input element
+// src[i], so the identity mapping is src[i] == i.
+typedef struct
+{
+  uint8_t button_src[REMAP_BUTTON_COUNT];
+  uint8_t stick_src[REMAP_STICK_AXES];
+  uint8_t stick_invert;  // bit i inverts output stick axis i
+  uint8_t trigger_src[REMAP_TRIGGERS];
+} remap_config_t;
+
+// Mapping compiled into flat tables. Applying it costs four button lookups
+// and six axis loads without a single branch on the mapping contents.
+typedef struct
+{
+  // button_lut[n][v] holds the output bits produced by input nibble n == v
+  uint16_t button_lut[REMAP_BUTTON_COUNT / 4][16];
+  uint8_t stick_src[REMAP_STICK_AXES];
+  uint8_t trigger_src[REMAP_TRIGGERS];
+  // 0 or -1, x ^ -1 == -x - 1 inverts an axis without overflowing at -32768
+  int16_t stick_xor[REMAP_STICK_AXES];
+} remap_table_t;
+
+void remap_config_identity(remap_config_t *cfg);
+
+// Build the lookup tables for a mapping. Out-of-range sources are treated as
+// REMAP_NONE for buttons and as the identity for axes.
+void remap_compile(const remap_config_t *cfg, remap_table_t *table);
+
+static inline void remap_apply(const remap_table_t *table, xinput_report_t *report)
+{
+  uint16_t b = report->bmButtons;
+  report->bmButtons = table->button_lut[0][b & 0xF] |
+                      table->button_lut[1][(b >> 4) & 0xF] |
+                      table->button_lut[2][(b >> 8) & 0xF] |
+                      table->button_lut[3][b >> 12];
+
+  int16_t const sticks[REMAP_STICK_AXES] = {
+      report->wThumbLeftX, report->wThumbLeftY, report->wThumbRightX, report->wThumbRightY};
+  report->wThumbLeftX = sticks[table->stick_src[0]] ^ table->stick_xor[0];
+  report->wThumbLeftY = sticks[table->stick_src[1]] ^ table->stick_xor[1];
+  report->wThumbRightX = sticks[table->stick_src[2]] ^ table->stick_xor[2];
+  report->wThumbRightY = sticks[table->stick_src[3]] ^ table->stick_xor[3];
+
+  uint8_t const triggers[REMAP_TRIGGERS] = {report->bLeftTrigger, report->bRightTrigger};
+  report->bLeftTrigger = triggers[table->trigger_src[0]];
+  report->bRightTrigger = triggers[table->trigger_src[1]];
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef REPORT_FRAME_H
+#define REPORT_FRAME_H
+
+#include <stdint.h>
+
+#include "passthrough_config.h"
+#include "telemetry_proto.h"
+#include "xinput_device.h"
+
+// Frames carry their receive time whenever something downstream reads it
+#define REPORT_FRAME_TIMESTAMPS (PT_LATENCY_STATS || PT_TELEMETRY || PT_SOF_ALIGN)
+
+// A translated report plus the bookkeeping that travels with it from the
+// host callback to the device endpoint
+typedef struct
+{
+  xinput_report_t report;
+  uint8_t slot; // XInput device interface the report is meant for
+#if REPORT_FRAME_TIMESTAMPS
+  uint32_t rx_us; // time_us_32() when tuh_xinput_report_received_cb fired
+#endif
+#if PT_TELEMETRY
+  telemetry_pad_t raw; // controller state before remapping and curves
+#endif
+} report_frame_t;
+
+#if REPORT_FRAME_TIMESTAMPS
+#include "pico/time.h"
+
+static inline void report_frame_stamp(report_frame_t *frame) { frame->rx_us = time_us_32(); }
+#define REPORT_FRAME_RX_US(frame) ((frame)->rx_us)
+#else
+static inline void report_frame_stamp(report_frame_t *frame) { (void)frame; }
+#define REPORT_FRAME_RX_US(frame) 0u
+#endif
+
+// Remember the freshly translated report as the raw controller state
+static inline void report_frame_keep_raw(report_frame_t *frame)
+{
+#if PT_TELEMETRY
+  frame->raw = (telemetry_pad_t){
+      .buttons = frame->report.bmButtons,
+      .left_trigger = frame->report.bLeftTrigger,
+      .right_trigger = frame->report.bRightTrigger,
+      .thumb_lx = frame->report.wThumbLeftX,
+      .thumb_ly = frame->report.wThumbLeftY,
+      .thumb_rx = frame->report.wThumbRightX,
+      .thumb_ry = frame->report.wThumbRightY,
+  };
+#else
+  (void)frame;
+#endif
+}
+
+#endif
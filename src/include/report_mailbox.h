@@ -0,0 +1,43 @@
+#ifndef REPORT_MAILBOX_H
+#define REPORT_MAILBOX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "report_frame.h"
+
+// One-slot, latest-wins mailbox in front of the IN endpoint of a pad.
+// It always holds the newest frame. A frame posted while the endpoint is busy
+// waits here and is sent as soon as the previous transfer completes. Only the
+// device core touches the mailbox.
+typedef struct
+{
+  report_frame_t frame;  // newest frame posted
+  uint8_t itf;           // pad this mailbox feeds
+  uint32_t seq;          // sequence number of the frame above
+  uint32_t sent_seq;     // sequence number of the last frame handed to the endpoint
+  uint32_t mirror_seq;   // same for the mirrored HID endpoint, see usb_personality.h
+  uint32_t sent;         // frames queued on the endpoint
+  uint32_t overwritten;  // frames replaced by a newer one before they were sent
+  uint32_t mirror_overwritten;  // same for the mirrored HID endpoint
+  uint32_t dropped;      // frames discarded because the device was not mounted
+} report_mailbox_t;
+
+// One mailbox per pad
+extern report_mailbox_t report_mailbox[PT_XINPUT_PADS];
+
+void report_mailbox_init(void);
+
+// Store a frame as the newest state of its mailbox and try to send it straight away
+void report_mailbox_post(report_mailbox_t *mb, const report_frame_t *frame);
+
+// Send the pending frame if there is one and the endpoint accepts it.
+// Returns true if a frame was queued on the endpoint
+bool report_mailbox_flush(report_mailbox_t *mb);
+
+static inline bool report_mailbox_pending(report_mailbox_t const *mb)
+{
+  return mb->seq != mb->sent_seq || mb->seq != mb->mirror_seq;
+}
+
+#endif
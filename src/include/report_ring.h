@@ -0,0 +1,44 @@
+#ifndef REPORT_RING_H
+#define REPORT_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "passthrough_config.h"
+#include "report_frame.h"
+
+// Wait-free single-producer/single-consumer ring of report frames.
+// The producer (host core) only ever writes head, the consumer (device core)
+// only ever writes tail, so no locks or read-modify-write atomics are needed,
+// which matters on the Cortex-M0+ since it has no exclusive load/store.
+typedef struct
+{
+  report_frame_t slots[PT_REPORT_RING_SIZE];
+  atomic_uint head;  // next slot to write, owned by the producer
+  atomic_uint tail;  // next slot to read, owned by the consumer
+  uint32_t dropped;  // pushes rejected because the ring was full (producer)
+  uint32_t skipped;  // stale or overwritten frames discarded by a latest-wins pop (consumer)
+} report_ring_t;
+
+// Reports travel from the host stack on core1 to the device stack on core0,
+// one ring per pad so a latest-wins pop never discards another pad's report
+extern report_ring_t report_ring[PT_XINPUT_PADS];
+
+void report_ring_init(report_ring_t *ring);
+
+// Producer side. Returns false and counts a drop if the ring is full
+bool report_ring_push(report_ring_t *ring, const report_frame_t *frame);
+
+// Producer side for a latest-wins consumer. Never fails, a full ring has its
+// oldest frame overwritten so the newest one always reaches the consumer.
+// Only pair it with report_ring_pop_latest
+void report_ring_push_latest(report_ring_t *ring, const report_frame_t *frame);
+
+// Consumer side. Pops the oldest frame, returns false if the ring is empty
+bool report_ring_pop(report_ring_t *ring, report_frame_t *frame);
+
+// Consumer side. Pops the newest frame and discards everything older
+bool report_ring_pop_latest(report_ring_t *ring, report_frame_t *frame);
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef REPORT_TRANSLATE_H
+#define REPORT_TRANSLATE_H
+
+#include "xinput_device.h"
+#include "xinput_host.h"
+
+// Translate the state of a physical controller into the report sent to the PC.
+// Pure function of its inputs: it touches no hardware and no Pico SDK API, so
+// this translation unit can be compiled for any target.
+void report_translate(const xinput_gamepad_t *pad, xinput_report_t *report);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "passthrough_config.h"
+#include "remap.h"
+#include "stick_curve.h"
+#include "stick_filter.h"
+#include "turbo.h"
+#include "usb_personality.h"
+
+// User-tunable configuration, edited on the device core
+typedef struct
+{
+  remap_config_t remap;
+  curve_config_t curve;
+  stick_filter_config_t filter;
+  turbo_config_t turbo;
+  uint8_t personality;  // USB_PERSONALITY_*, applied by re-enumerating
+} settings_t;
+
+// Settings compiled into the lookup tables the report path runs on
+typedef struct
+{
+  remap_table_t remap;
+  curve_table_t curve;
+  stick_filter_table_t filter;
+} settings_tables_t;
+
+extern settings_t settings;
+
+// Load the saved settings, or defaults if there are none, and publish the
+// first set of tables
+void settings_init(void);
+
+// Mark `settings` as changed. The tables are rebuilt by settings_task()
+void settings_changed(void);
+
+// Device core. Rebuilds and publishes the tables once the host core let go
+// of the previous set. Returns true while a change is still pending
+bool settings_task(void);
+
+// Host core. Returns the tables to use for the current report. The pointer
+// stays valid until the next call, which also tells the device core the
+// previous set is no longer in use
+const settings_tables_t *settings_tables(void);
+
+// Device core. The tables currently published, without acknowledging them
+const settings_tables_t *settings_tables_peek(void);
+
+#endif
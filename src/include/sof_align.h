@@ -0,0 +1,70 @@
+#ifndef SOF_ALIGN_H
+#define SOF_ALIGN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "passthrough_config.h"
+
+// SOF-aligned report scheduling. The completion time of every IN transfer
+// is taken relative to the last Start-of-Frame to learn when in the frame
+// (and every how many frames) the PC polls. Once learned, the mailboxes
+// stop sending as soon as a frame arrives and instead commit their newest
+// state from a timer alarm PT_SOF_ALIGN_GUARD_US before the expected poll.
+typedef struct
+{
+  uint16_t phase_us;   // learned poll time after SOF
+  uint8_t period;      // learned poll interval in frames
+  uint32_t commits;    // commit points served
+  uint32_t late;       // alarms that could not be set before their target
+  uint32_t max_lateness_us;  // worst delay between alarm target and commit
+
+  // Over the last PT_SOF_ALIGN_WINDOW completions
+  uint32_t age_min_us;  // controller report received -> read by the PC
+  uint32_t age_avg_us;
+  uint32_t age_max_us;  // age_max_us - age_min_us is the jitter
+  uint32_t wait_avg_us; // committed -> read by the PC
+  uint32_t wait_max_us;
+} sof_align_stats_t;
+
+extern sof_align_stats_t sof_align_stats;
+
+#if PT_SOF_ALIGN
+
+// Claim the commit alarm and enable SOF events, call after tusb_init()
+void sof_align_init(void);
+
+// Switch aligned scheduling on or off at runtime, it is on by default
+void sof_align_enable(bool enable);
+
+// USB IRQ. A Start-of-Frame was received
+void sof_align_sof(void);
+
+// True while mailboxes must wait for the commit point instead of sending
+bool sof_align_active(void);
+
+// A frame received at rx_us was queued on the IN endpoint of itf
+void sof_align_queued(uint8_t itf, uint32_t rx_us);
+
+// The PC read the IN endpoint of itf
+void sof_align_completed(uint8_t itf);
+
+// Device core loop. Commit the mailboxes once the alarm fired
+void sof_align_task(void);
+
+#else
+
+static inline void sof_align_init(void) {}
+static inline void sof_align_sof(void) {}
+static inline bool sof_align_active(void) { return false; }
+static inline void sof_align_queued(uint8_t itf, uint32_t rx_us)
+{
+  (void)itf;
+  (void)rx_us;
+}
+static inline void sof_align_completed(uint8_t itf) { (void)itf; }
+static inline void sof_align_task(void) {}
+
+#endif
+
+#endif
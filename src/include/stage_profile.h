@@ -0,0 +1,88 @@
+#ifndef STAGE_PROFILE_H
+#define STAGE_PROFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "hardware/structs/systick.h"
+#include "passthrough_config.h"
+#include "tusb.h"
+
+// Report processing stages timed on the core that runs the host stack
+enum
+{
+  PROFILE_TRANSLATE = 0,
+  PROFILE_REMAP,
+  PROFILE_SMOOTH,
+  PROFILE_CURVE,
+  PROFILE_PIPELINE,  // every stage after translation, as a whole
+  PROFILE_STAGE_COUNT,
+};
+
+// Cost of one stage in clk_sys cycles
+typedef struct
+{
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t total;
+} stage_profile_t;
+
+extern stage_profile_t stage_profile[PROFILE_STAGE_COUNT];
+
+// SysTick counts down from 0xFFFFFF at the processor clock
+#define STAGE_PROFILE_SYSTICK_MASK 0x00FFFFFFu
+
+// Start the free-running SysTick of the calling core unless it already runs,
+// every core has its own. Available without PT_STAGE_PROFILE for pipeline_bench
+void stage_profile_systick_start(void);
+
+static inline uint32_t stage_profile_systick(void)
+{
+  return systick_hw->cvr;
+}
+
+// Cycles between two SysTick reads less than one wrap (~70 ms) apart
+static inline uint32_t stage_profile_cycles(uint32_t start, uint32_t end)
+{
+  return (start - end) & STAGE_PROFILE_SYSTICK_MASK;
+}
+
+#if PT_STAGE_PROFILE
+
+static inline void stage_profile_init(void)
+{
+  stage_profile_systick_start();
+}
+
+static inline uint32_t stage_profile_now(void)
+{
+  return stage_profile_systick();
+}
+
+// Account the cycles since start to a stage, returns the current count so
+// consecutive stages can be chained
+uint32_t stage_profile_record(uint8_t stage, uint32_t start);
+
+// Serve PT_VENDOR_REQUEST_PROFILE, returns false for any other request
+bool stage_profile_control_xfer(uint8_t rhport, tusb_control_request_t const *request);
+
+#else
+
+static inline void stage_profile_init(void) {}
+static inline uint32_t stage_profile_now(void) { return 0; }
+static inline uint32_t stage_profile_record(uint8_t stage, uint32_t start)
+{
+  (void)stage;
+  return start;
+}
+static inline bool stage_profile_control_xfer(uint8_t rhport, tusb_control_request_t const *request)
+{
+  (void)rhport;
+  (void)request;
+  return false;
+}
+
+#endif
+
+#endif
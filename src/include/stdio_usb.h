@@ -33,6 +33,16 @@
 #define PICO_STDIO_USB_STDOUT_TIMEOUT_US 500000
 #endif
 
+// PICO_CONFIG: PICO_STDIO_USB_OUT_RING_SIZE, Size in bytes of the ring USB output is buffered in. Output then never blocks, the ring is drained by stdio_usb_task(). 0 keeps the blocking writer. Must be a power of two, default=2048, group=pico_stdio_usb
+#ifndef PICO_STDIO_USB_OUT_RING_SIZE
+#define PICO_STDIO_USB_OUT_RING_SIZE 2048
+#endif
+
+// PICO_CONFIG: PICO_STDIO_USB_OUT_RING_DROP_OLDEST, When the output ring is full overwrite the oldest bytes (1) or discard the newest ones (0), type=bool, default=0, group=pico_stdio_usb
+#ifndef PICO_STDIO_USB_OUT_RING_DROP_OLDEST
+#define PICO_STDIO_USB_OUT_RING_DROP_OLDEST 0
+#endif
+
 // todo perhaps unnecessarily frequent?
 // PICO_CONFIG: PICO_STDIO_USB_TASK_INTERVAL_US, Period of microseconds between calling tud_task in the background, default=1000, advanced=true, group=pico_stdio_usb
 #ifndef PICO_STDIO_USB_TASK_INTERVAL_US
@@ -193,6 +203,29 @@ bool stdio_usb_deinit(void);
  */
 bool stdio_usb_connected(void);
 
+#if PICO_STDIO_USB_OUT_RING_SIZE
+/*! \brief Counters of the non-blocking output ring
+ *  \ingroup pico_stdio_usb
+ */
+typedef struct {
+    uint32_t written;   ///< bytes accepted into the ring
+    uint32_t sent;      ///< bytes handed to the CDC endpoint
+    uint32_t dropped;   ///< bytes lost because the ring was full
+} stdio_usb_out_stats_t;
+
+/*! \brief Move buffered output into the CDC endpoint without blocking
+ *  \ingroup pico_stdio_usb
+ *
+ * Must be called regularly from the core that runs tud_task().
+ */
+void stdio_usb_task(void);
+
+/*! \brief Read the output ring counters
+ *  \ingroup pico_stdio_usb
+ */
+void stdio_usb_get_out_stats(stdio_usb_out_stats_t *stats);
+#endif
+
 #if PICO_STDIO_USB_SUPPORT_CHARS_AVAILABLE_CALLBACK
 /*! \brief Explicitly calls the registered USB stdio chars_available_callback
  *  \ingroup pico_stdio_usb
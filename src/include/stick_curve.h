@@ -0,0 +1,54 @@
+#ifndef STICK_CURVE_H
+#define STICK_CURVE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "passthrough_config.h"
+#include "xinput_device.h"
+
+#define CURVE_STICK_LUT_SIZE (1u << PT_CURVE_LUT_BITS)
+#define CURVE_STICK_LUT_SHIFT (15 - PT_CURVE_LUT_BITS)
+
+// Response of one stick, magnitudes are on the 0..32767 scale of the report
+typedef struct
+{
+  uint16_t deadzone;       // radial inner deadzone, smaller magnitudes output 0
+  uint16_t anti_deadzone;  // output magnitude right outside the deadzone
+  uint16_t outer;          // input magnitude that already gives full output
+  uint8_t curve;           // 0 = linear .. 100 = cubic
+} curve_stick_config_t;
+
+// Response of one trigger, on the 0..255 scale of the report
+typedef struct
+{
+  uint8_t deadzone;
+  uint8_t anti_deadzone;
+  uint8_t outer;
+  uint8_t curve;
+} curve_trigger_config_t;
+
+typedef struct
+{
+  curve_stick_config_t stick[2];      // left, right
+  curve_trigger_config_t trigger[2];  // left, right
+} curve_config_t;
+
+// Curves sampled into fixed-point tables. Sticks are looked up by radial
+// magnitude with linear interpolation between entries, triggers directly.
+typedef struct
+{
+  uint16_t stick[2][CURVE_STICK_LUT_SIZE + 1];
+  uint8_t trigger[2][256];
+  bool identity;  // default config, curve_apply leaves the report untouched
+} curve_table_t;
+
+// Pass-through response: no deadzone, linear, full range
+void curve_config_default(curve_config_t *cfg);
+
+void curve_compile(const curve_config_t *cfg, curve_table_t *table);
+
+// Integer-only, applies both sticks and both triggers
+void curve_apply(const curve_table_t *table, xinput_report_t *report);
+
+#endif
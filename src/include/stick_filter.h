@@ -0,0 +1,58 @@
+#ifndef STICK_FILTER_H
+#define STICK_FILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define STICK_FILTER_AXES 4  // LX, LY, RX, RY in report order
+
+// Adaptive stick smoothing (One-Euro filter). Every axis goes through a
+// first-order low-pass whose cutoff rises with the speed of the stick: a
+// resting stick is filtered hard at min_cutoff, which removes the jitter of
+// a worn potentiometer, while a moving one follows with little lag. Cutoffs
+// are in 0.1 Hz.
+typedef struct
+{
+  uint8_t axes;         // bit i filters axis i, 0 = filter off
+  uint8_t beta;         // cutoff added per full stick range per second of speed
+  uint16_t min_cutoff;  // cutoff of a resting stick
+  uint16_t d_cutoff;    // cutoff of the speed estimate
+} stick_filter_config_t;
+
+// Config clamped to what the fixed-point filter supports
+typedef struct
+{
+  uint8_t axes;
+  uint8_t beta;
+  uint16_t min_cutoff;
+  uint16_t d_cutoff;
+} stick_filter_table_t;
+
+// Filter state of one axis
+typedef struct
+{
+  int32_t x;   // filtered position, counts in Q8
+  int32_t dx;  // filtered speed, 1/1024 full stick range per second
+} stick_filter_axis_t;
+
+// Filter state of one pad, restarted after a gap of more than 100 ms
+typedef struct
+{
+  stick_filter_axis_t axis[STICK_FILTER_AXES];
+  uint32_t last_us;
+  uint8_t axes;  // axes the state was built for
+  bool primed;
+} stick_filter_state_t;
+
+// Filter off. The parameters for when it is switched on (15 Hz, 25.5 Hz,
+// 20 Hz) keep the error of every axis of the stick_filter_bench trace below
+// that of the raw input
+void stick_filter_config_default(stick_filter_config_t *cfg);
+
+void stick_filter_compile(const stick_filter_config_t *cfg, stick_filter_table_t *table);
+
+// Integer-only. Filter the stick axes of one report received at now_us
+void stick_filter_apply(const stick_filter_table_t *table, stick_filter_state_t *state,
+                        int16_t axes[STICK_FILTER_AXES], uint32_t now_us);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+#include "passthrough_config.h"
+#include "report_frame.h"
+#include "telemetry_proto.h"
+
+#if PT_TELEMETRY
+
+// Frames that did not fit into the CDC 1 FIFO
+extern uint32_t telemetry_dropped;
+
+// Stream one sample for a frame the device core just forwarded
+void telemetry_sample(const report_frame_t *frame, uint32_t forward_us);
+
+// Periodic counters snapshot and FIFO flush, call from the device core loop
+void telemetry_task(void);
+
+#else
+
+static inline void telemetry_sample(const report_frame_t *frame, uint32_t forward_us)
+{
+  (void)frame;
+  (void)forward_us;
+}
+static inline void telemetry_task(void) {}
+
+#endif
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef TELEMETRY_PROTO_H
+#define TELEMETRY_PROTO_H
+
+// Binary telemetry streamed on CDC interface 1. Shared between the firmware
+// and tools/telemetry_decode, so it only depends on the C standard library.
+//
+// Every frame is exactly one 64-byte full-speed packet:
+//   sync (A5 5A) | type | slot | seq (LE16) | payload (56) | crc (LE16)
+// The CRC is CRC-16/CCITT-FALSE over the first 62 bytes. All multi-byte
+// fields are little-endian.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TELEMETRY_FRAME_SIZE 64
+#define TELEMETRY_PAYLOAD_SIZE 56
+#define TELEMETRY_SYNC0 0xA5
+#define TELEMETRY_SYNC1 0x5A
+
+enum
+{
+  TELEMETRY_TYPE_SAMPLE = 1,    // one report through the passthrough path
+  TELEMETRY_TYPE_COUNTERS = 2,  // periodic snapshot of the drop/skip counters
+};
+
+// Controller state in report order: buttons, triggers, sticks
+typedef struct __attribute__((packed))
+{
+  uint16_t buttons;
+  uint8_t left_trigger;
+  uint8_t right_trigger;
+  int16_t thumb_lx;
+  int16_t thumb_ly;
+  int16_t thumb_rx;
+  int16_t thumb_ry;
+} telemetry_pad_t;
+
+typedef struct __attribute__((packed))
+{
+  uint32_t rx_us;         // host callback fired
+  uint32_t forward_us;    // frame handed to the device mailbox
+  telemetry_pad_t raw;    // state read from the physical controller
+  telemetry_pad_t out;    // state sent to the PC after processing
+  uint8_t reserved[24];
+} telemetry_sample_t;
+
+typedef struct __attribute__((packed))
+{
+  uint32_t now_us;
+  uint32_t ring_dropped;
+  uint32_t ring_skipped;
+  uint32_t mailbox_sent;
+  uint32_t mailbox_overwritten;
+  uint32_t mailbox_dropped;
+  uint32_t delta_suppressed;
+  uint32_t relay_coalesced;
+  uint32_t stdio_dropped;
+  uint32_t telemetry_dropped;
+  uint32_t poll_rate_hz;      // reports per second delivered by the pad
+  uint32_t poll_failed;       // IN transfers from the pad that failed
+  uint8_t reserved[8];
+} telemetry_counters_t;
+
+typedef struct __attribute__((packed))
+{
+  uint8_t sync[2];
+  uint8_t type;
+  uint8_t slot;
+  uint16_t seq;
+  union
+  {
+    telemetry_sample_t sample;
+    telemetry_counters_t counters;
+    uint8_t raw[TELEMETRY_PAYLOAD_SIZE];
+  } payload;
+  uint16_t crc;
+} telemetry_frame_t;
+
+_Static_assert(sizeof(telemetry_sample_t) == TELEMETRY_PAYLOAD_SIZE, "sample payload size");
+_Static_assert(sizeof(telemetry_counters_t) == TELEMETRY_PAYLOAD_SIZE, "counters payload size");
+_Static_assert(sizeof(telemetry_frame_t) == TELEMETRY_FRAME_SIZE, "telemetry frame size");
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), one nibble at a time
+static inline uint16_t telemetry_crc16(const uint8_t *data, size_t len)
+{
+  static const uint16_t nibble_table[16] = {
+      0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+      0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF};
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++)
+  {
+    crc = (uint16_t)((crc << 4) ^ nibble_table[(crc >> 12) ^ (data[i] >> 4)]);
+    crc = (uint16_t)((crc << 4) ^ nibble_table[(crc >> 12) ^ (data[i] & 0x0F)]);
+  }
+  return crc;
+}
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef TURBO_H
+#define TURBO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "passthrough_config.h"
+#include "report_frame.h"
+
+#define TURBO_BUTTON_COUNT 16
+#define TURBO_RATE_MAX 30  // presses per second
+
+// Rapid fire per output button, in presses per second, 0 = off
+typedef struct
+{
+  uint8_t rate[TURBO_BUTTON_COUNT];
+} turbo_config_t;
+
+// Rapid fire. While a button with a rate is held, its output bit is switched
+// off and on by a repeating hardware alarm every PT_TURBO_TICK_US, whether or
+// not the pad sends anything new. Every button has a 32-bit phase
+// accumulator whose top bit is its current state, and the states of all
+// buttons are kept as one 16-bit mask so gating a report is a single AND.
+// The phases are shared by all pads, so pads holding the same button fire in
+// step. A toggle of a held button re-sends the last report of its pad
+// through the normal device path.
+typedef struct
+{
+  uint32_t ticks;            // alarm ticks served
+  uint32_t missed;           // ticks whose target had already passed when set
+  uint32_t tick_late_max_us; // worst delay between alarm target and IRQ
+  uint32_t injected;         // reports re-sent for a toggle
+  uint32_t toggle_min_us;    // toggle in the IRQ -> report posted, the
+  uint32_t toggle_max_us;    // spread is the toggle jitter
+  uint64_t toggle_total_us;
+} turbo_stats_t;
+
+extern turbo_stats_t turbo_stats;
+
+void turbo_config_default(turbo_config_t *cfg);
+
+#if PT_TURBO
+
+// Claim the alarm and apply settings.turbo, call once from the device core
+void turbo_init(void);
+
+// Device core. Take new rates, the alarm only runs while a rate is set
+void turbo_configure(const turbo_config_t *cfg);
+
+// Device core. Remember the buttons of a frame about to be posted and mask
+// the turbo buttons that are in their off phase
+void turbo_apply(report_frame_t *frame);
+
+// Device core. Returns the last frame of slot again if one of its held
+// turbo buttons toggled since it was posted
+bool turbo_inject(uint8_t slot, report_frame_t *frame);
+
+#else
+
+static inline void turbo_init(void) {}
+static inline void turbo_configure(const turbo_config_t *cfg) { (void)cfg; }
+static inline void turbo_apply(report_frame_t *frame) { (void)frame; }
+static inline bool turbo_inject(uint8_t slot, report_frame_t *frame)
+{
+  (void)slot;
+  (void)frame;
+  return false;
+}
+
+#endif
+
+#endif
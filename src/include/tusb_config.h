@@ -26,6 +26,8 @@
 #ifndef TUSB_CONFIG_H_
 #define TUSB_CONFIG_H_
 
+#include "passthrough_config.h"
+
 #ifdef __cplusplus
  extern "C" {
 #endif
@@ -111,14 +113,15 @@
 #define CFG_TUD_CDC              2
 #define CFG_TUD_BOS              1
 #define CFG_TUD_VENDOR           1
-#define CFG_TUD_XINPUT           1
+#define CFG_TUD_XINPUT           PT_XINPUT_PADS
 
 #define CFG_TUD_HID_EPIN_BUFSIZE    64
 #define CFG_TUD_HID_EPOUT_BUFSIZE   64
-#define CFG_TUD_HID              0
+#define CFG_TUD_HID              PT_XINPUT_PADS
 // CDC FIFO size of TX and RX
+// TX holds several 64-byte telemetry frames so a short host stall drops nothing
 #define CFG_TUD_CDC_RX_BUFSIZE   (TUD_OPT_HIGH_SPEED ? 512 : 64)
-#define CFG_TUD_CDC_TX_BUFSIZE   (TUD_OPT_HIGH_SPEED ? 512 : 64)
+#define CFG_TUD_CDC_TX_BUFSIZE   (TUD_OPT_HIGH_SPEED ? 512 : 256)
 
 // CDC Endpoint transfer buffer size, more is faster
 #define CFG_TUD_CDC_EP_BUFSIZE   (TUD_OPT_HIGH_SPEED ? 512 : 64)
@@ -128,7 +131,8 @@
 //--------------------------------------------------------------------
 
 // Size of buffer to hold descriptors and other data used for enumeration
-#define CFG_TUH_ENUMERATION_BUFSIZE 256
+// HID report descriptors of keyboards and pads easily exceed 256 bytes
+#define CFG_TUH_ENUMERATION_BUFSIZE (PT_HID_HOST ? 512 : 256)
 
 #ifndef CFG_TUH_MEM_SECTION
 #define CFG_TUH_MEM_SECTION
@@ -140,7 +144,7 @@
 
 #define CFG_TUH_HID_EPIN_BUFSIZE    64
 #define CFG_TUH_HID_EPOUT_BUFSIZE   64
-#define CFG_TUH_HID 0
+#define CFG_TUH_HID                 (PT_HID_HOST ? PT_HID_INTERFACES : 0)
 #define CFG_TUH_HUB                 1
 #define CFG_TUH_XINPUT              1
 // max device support (excluding hub device)
@@ -0,0 +1,17 @@
+#ifndef USB_DESCRIPTORS_H
+#define USB_DESCRIPTORS_H
+
+#include "passthrough_config.h"
+
+// Interface numbers, the same in every personality up to ITF_NUM_PADS
+enum
+{
+  ITF_NUM_CDC_0 = 0,  // Interface 0 (CDC0 Comm)
+  ITF_NUM_CDC_0_DATA, // Interface 1 (CDC0 Data)
+  ITF_NUM_CDC_1,      // Interface 2 (CDC1 Comm)
+  ITF_NUM_CDC_1_DATA, // Interface 3 (CDC1 Data)
+  ITF_NUM_PADS,       // Interface 4.. (one per passed through pad, twice with both personalities)
+  ITF_NUM_XINPUT = ITF_NUM_PADS,
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef USB_PERSONALITY_H
+#define USB_PERSONALITY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "passthrough_config.h"
+#include "xinput_device.h"
+
+// What the device presents itself as. Every personality has its own product
+// ID and configuration descriptor (usb_descriptors.c), the two CDC
+// interfaces are always there
+enum
+{
+  USB_PERSONALITY_XINPUT = 0,  // one XInput interface per pad
+  USB_PERSONALITY_HID,         // one generic HID gamepad interface per pad
+  USB_PERSONALITY_BOTH,        // both, the HID pads mirror the XInput ones
+  USB_PERSONALITY_COUNT,
+};
+
+extern const char *const usb_personality_names[USB_PERSONALITY_COUNT];
+
+// The HID gamepad report is the part of xinput_report_t from bmButtons to
+// wThumbRightY, sent straight out of the report without repacking: 16
+// buttons in wButtons order, the triggers as Rx/Ry and the sticks as X/Y and
+// Z/Rz. The sticks keep the XInput orientation, Y up
+#define USB_HID_PAD_REPORT_LEN 12
+
+typedef struct
+{
+  uint32_t switches;   // re-enumerations into another personality
+  uint32_t last_us;    // last switch: detach -> configured by the PC
+  uint32_t best_us;    // fastest switch
+} usb_personality_stats_t;
+
+extern usb_personality_stats_t usb_personality_stats;
+
+// Personality to enumerate with, before the device stack is started
+void usb_personality_init(uint8_t personality);
+
+// The personality the device is enumerated with
+uint8_t usb_personality_active(void);
+
+// Switch to another personality. The device detaches from the bus for
+// PT_USB_DETACH_MS and enumerates again. Device core
+void usb_personality_select(uint8_t personality);
+
+// Device core, polled. Drives a pending switch, returns true while one is
+// in progress
+bool usb_personality_task(void);
+
+// The PC configured the device
+void usb_personality_mounted(void);
+
+// Queue the report of pad on the endpoint the timing statistics follow, the
+// XInput one unless it is the HID personality. Returns false if it is busy
+bool usb_personality_report(uint8_t pad, xinput_report_t const *report);
+
+// With USB_PERSONALITY_BOTH, queue the report on the HID endpoint of pad too.
+// Returns true if it was queued or there is no such endpoint
+bool usb_personality_mirror(uint8_t pad, xinput_report_t const *report);
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef USB_STRINGS_H
+#define USB_STRINGS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Longest serial number, the board's unique ID as hex
+#define USB_STRING_SERIAL_MAX 32
+
+// String Descriptor Index
+enum
+{
+  STRID_LANGID = 0,
+  STRID_MANUFACTURER,
+  STRID_PRODUCT,
+  STRID_SERIAL,
+  STRID_CDC,
+  STRID_PAD,
+  STRID_MSFT100,
+  STRID_MS_OS = 0xEE,
+};
+
+// Record the serial number, once at boot before the device stack starts.
+// Longer serials are cut to USB_STRING_SERIAL_MAX characters
+void usb_string_set_serial(uint16_t const *chars, size_t count);
+
+// Ready-to-send string descriptor for index, NULL if there is none. Every
+// descriptor but the serial number is a UTF-16LE blob built at compile time
+uint16_t const *usb_string_descriptor(uint8_t index);
+
+#endif
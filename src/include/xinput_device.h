@@ -0,0 +1,63 @@
+#ifndef XINPUT_DEVICE_H
+#define XINPUT_DEVICE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// XInput device class driver for TinyUSB, one instance per interface up to
+// CFG_TUD_XINPUT. Registered through usbd_app_driver_get_cb. Only depends on
+// the C library, so the host tools can share the report layout.
+
+// Report sent on the IN endpoint, as a wired Xbox 360 controller does
+typedef struct __attribute__((packed))
+{
+  uint8_t bReportID;
+  uint8_t bSize;
+  uint16_t bmButtons;
+  uint8_t bLeftTrigger;
+  uint8_t bRightTrigger;
+  int16_t wThumbLeftX;
+  int16_t wThumbLeftY;
+  int16_t wThumbRightX;
+  int16_t wThumbRightY;
+  uint8_t reserved[6];
+} xinput_report_t;
+
+_Static_assert(sizeof(xinput_report_t) == 20, "XInput reports are 20 bytes on the wire");
+
+// Interface class of a wired Xbox 360 controller
+#define XINPUT_ITF_CLASS 0xFF
+#define XINPUT_ITF_SUBCLASS 0x5D
+#define XINPUT_ITF_PROTOCOL 0x01
+
+// Interface, the undocumented 0x21 class descriptor and the two interrupt
+// endpoints, as the Windows xusb22 driver expects them
+#define TUD_XINPUT_DESC_LEN (9 + 17 + 7 + 7)
+
+// Interface number, string index, EP OUT address, EP IN address, EP size
+#define TUD_XINPUT_DESCRIPTOR(_itfnum, _stridx, _epout, _epin, _epsize)                                           \
+  /* Interface */                                                                                                 \
+  9, TUSB_DESC_INTERFACE, _itfnum, 0, 2, XINPUT_ITF_CLASS, XINPUT_ITF_SUBCLASS, XINPUT_ITF_PROTOCOL, _stridx,    \
+  /* Class descriptor, 20-byte IN and 8-byte OUT reports */                                                       \
+  17, 0x21, 0x00, 0x01, 0x01, 0x25, _epin, 0x14, 0x00, 0x00, 0x00, 0x00, 0x13, _epout, 0x08, 0x00, 0x00,          \
+  /* Endpoint In, polled every frame */                                                                           \
+  7, TUSB_DESC_ENDPOINT, _epin, TUSB_XFER_INTERRUPT, U16_TO_U8S_LE(_epsize), 1,                                   \
+  /* Endpoint Out */                                                                                              \
+  7, TUSB_DESC_ENDPOINT, _epout, TUSB_XFER_INTERRUPT, U16_TO_U8S_LE(_epsize), 8
+
+// True if interface itf is mounted and its IN endpoint can take a report
+bool tud_xinput_n_ready(uint8_t itf);
+
+// Queue a report on interface itf. Returns false if the endpoint is busy
+bool tud_xinput_n_report(uint8_t itf, xinput_report_t const *report);
+
+// Invoked from tud_task when the report queued on interface itf has been
+// read by the PC. Optional, the driver has a weak default
+void tud_xinput_report_complete_cb(uint8_t itf, uint8_t const *report, uint16_t len);
+
+// Invoked from tud_task when the PC sent an OUT report (rumble or LED) on
+// interface itf. report is only valid during the call. Optional, the driver
+// has a weak default
+void tud_xinput_report_received_cb(uint8_t itf, uint8_t const *report, uint16_t len);
+
+#endif
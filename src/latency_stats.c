@@ -0,0 +1,110 @@
+#include "latency_stats.h"
+
+#if PT_LATENCY_STATS
+
+#include <string.h>
+
+#include "pico/time.h"
+
+// Everything here runs on the device core (core0), so plain statics suffice
+static latency_stats_t stats;
+
+// Timestamps of the frame currently sitting in each IN endpoint
+static bool inflight[PT_XINPUT_PADS];
+static uint32_t inflight_rx_us[PT_XINPUT_PADS];
+static uint32_t inflight_queue_us[PT_XINPUT_PADS];
+
+// Control transfers read from this buffer after the callback returns
+static latency_stats_t snapshot;
+
+static void hist_add(latency_hist_t *hist, uint32_t us)
+{
+  uint32_t bucket = us / PT_LATENCY_BUCKET_US;
+  if (bucket >= PT_LATENCY_BUCKETS)
+  {
+    bucket = PT_LATENCY_BUCKETS - 1;
+  }
+  hist->buckets[bucket]++;
+
+  if (hist->count == 0 || us < hist->min_us)
+  {
+    hist->min_us = us;
+  }
+  if (us > hist->max_us)
+  {
+    hist->max_us = us;
+  }
+  hist->count++;
+}
+
+static uint32_t hist_p99(latency_hist_t const *hist)
+{
+  // Smallest bucket whose cumulative count reaches 99% of all samples
+  uint32_t target = hist->count - hist->count / 100;
+  uint32_t seen = 0;
+  for (uint32_t i = 0; i < PT_LATENCY_BUCKETS; i++)
+  {
+    seen += hist->buckets[i];
+    if (seen >= target)
+    {
+      return (i + 1) * PT_LATENCY_BUCKET_US;
+    }
+  }
+  return hist->max_us;
+}
+
+void latency_stats_reset(void)
+{
+  memset(&stats, 0, sizeof(stats));
+  memset(inflight, 0, sizeof(inflight));
+}
+
+void latency_stats_queued(uint8_t itf, uint32_t rx_us)
+{
+  uint32_t now = time_us_32();
+  hist_add(&stats.stage[LATENCY_RX_TO_QUEUE], now - rx_us);
+
+  inflight[itf] = true;
+  inflight_rx_us[itf] = rx_us;
+  inflight_queue_us[itf] = now;
+}
+
+void latency_stats_completed(uint8_t itf)
+{
+  if (itf >= PT_XINPUT_PADS || !inflight[itf])
+  {
+    return;
+  }
+  inflight[itf] = false;
+
+  uint32_t now = time_us_32();
+  hist_add(&stats.stage[LATENCY_QUEUE_TO_COMPLETE], now - inflight_queue_us[itf]);
+  hist_add(&stats.stage[LATENCY_RX_TO_COMPLETE], now - inflight_rx_us[itf]);
+}
+
+void latency_stats_snapshot(latency_stats_t *out)
+{
+  *out = stats;
+  for (uint32_t i = 0; i < LATENCY_STAGE_COUNT; i++)
+  {
+    out->stage[i].p99_us = hist_p99(&out->stage[i]);
+  }
+}
+
+bool latency_stats_control_xfer(uint8_t rhport, tusb_control_request_t const *request)
+{
+  if (request->bRequest != PT_VENDOR_REQUEST_LATENCY)
+  {
+    return false;
+  }
+
+  // wValue 1 clears the histograms after they have been read
+  latency_stats_snapshot(&snapshot);
+  if (request->wValue == 1)
+  {
+    latency_stats_reset();
+  }
+  return tud_control_xfer(rhport, request, &snapshot, sizeof(snapshot));
+}
+
+#endif
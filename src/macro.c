@@ -0,0 +1,310 @@
+#include <string.h>
+
+#include "macro.h"
+
+const char *const macro_state_names[] = {"idle", "recording", "replaying"};
+
+macro_stats_t macro_stats;
+
+#if PT_MACRO
+
+#include <stdatomic.h>
+
+#include "pico/time.h"
+
+#include "config_store.h"
+#include "event_loop.h"
+#include "macro_codec.h"
+
+// Room kept at the end of the buffer for the mark macro_stop appends
+#define MACRO_TAIL MACRO_EVENT_MAX
+
+static uint8_t buffer[PT_MACRO_BUFFER_SIZE] __attribute__((aligned(4)));
+
+// Only the device core changes the state. The host core appends to the
+// recording while it is RECORDING and announces that with writing, so
+// macro_stop can wait for an append that saw the old state to finish
+static atomic_int state;
+static atomic_bool writing;
+static atomic_uint length;  // bytes of recording
+static uint8_t record_slot;
+static uint8_t replay_slot;
+
+// Host core while recording
+static macro_codec_t encoder;
+
+// Device core while replaying. The replay alarm lives in the default alarm
+// pool of this core, its IRQ only reports that the decoded event is due
+static alarm_id_t alarm_id;
+static macro_codec_t decoder;
+static uint32_t read_pos;
+static absolute_time_t start;
+static absolute_time_t target;  // of the decoded event
+static volatile bool due;
+
+static int64_t replay_alarm(alarm_id_t id, void *user_data)
+{
+  (void)id;
+  (void)user_data;
+  alarm_id = 0;
+  due = true;
+  event_loop_signal(EVENT_TICK);
+  return 0;
+}
+
+static uint32_t count_events(uint32_t len)
+{
+  macro_codec_t c;
+  macro_codec_reset(&c, 0);
+  uint32_t events = 0;
+  for (uint32_t pos = 0, n; pos < len; pos += n, events++)
+  {
+    n = macro_decode(&c, buffer + pos, len - pos);
+    if (n == 0)
+    {
+      break;
+    }
+  }
+  return events;
+}
+
+void macro_init(void)
+{
+  uint32_t len = config_store_load_macro(buffer, sizeof(buffer));
+  atomic_store_explicit(&length, len, memory_order_relaxed);
+  macro_stats.bytes = len;
+  macro_stats.events = count_events(len);
+}
+
+macro_state_t macro_state(void)
+{
+  return (macro_state_t)atomic_load_explicit(&state, memory_order_relaxed);
+}
+
+bool macro_record_start(uint8_t slot)
+{
+  if (slot >= PT_XINPUT_PADS || macro_state() != MACRO_IDLE || config_store_stats.macro_pending)
+  {
+    return false;
+  }
+
+  record_slot = slot;
+  macro_codec_reset(&encoder, time_us_32());
+  atomic_store_explicit(&length, 0, memory_order_relaxed);
+  macro_stats.events = 0;
+  macro_stats.bytes = 0;
+  macro_stats.captured = 0;
+  macro_stats.full = false;
+  atomic_store_explicit(&state, MACRO_RECORDING, memory_order_release);
+  return true;
+}
+
+void macro_stop(void)
+{
+  macro_state_t was = macro_state();
+  if (was == MACRO_IDLE)
+  {
+    return;
+  }
+  atomic_store(&state, MACRO_IDLE);
+
+  if (was == MACRO_REPLAYING)
+  {
+    if (alarm_id > 0)
+    {
+      cancel_alarm(alarm_id);
+      alarm_id = 0;
+    }
+    due = false;
+    return;
+  }
+
+  // An append that still saw RECORDING finishes first, later ones leave
+  // the recording alone
+  while (atomic_load(&writing))
+  {
+    tight_loop_contents();
+  }
+
+  // Close with a mark so the replay holds the last state as long as it was held
+  uint32_t len = atomic_load_explicit(&length, memory_order_relaxed);
+  len += macro_encode_mark(&encoder, time_us_32(), buffer + len);
+  atomic_store_explicit(&length, len, memory_order_relaxed);
+  macro_stats.bytes = len;
+  macro_stats.events++;
+}
+
+// Decode the next event and arm the alarm for it, or end the replay
+static void replay_next(void)
+{
+  uint32_t len = atomic_load_explicit(&length, memory_order_relaxed);
+  uint8_t n = read_pos < len ? macro_decode(&decoder, buffer + read_pos, len - read_pos) : 0;
+  if (n == 0)
+  {
+    atomic_store(&state, MACRO_IDLE);
+    return;
+  }
+  read_pos += n;
+
+  // An event that is already due, e.g. the next change in the same
+  // microsecond, fires right away from within add_alarm_at
+  target = delayed_by_us(start, decoder.t_us);
+  alarm_id_t id = add_alarm_at(target, replay_alarm, NULL, true);
+  if (id > 0)
+  {
+    alarm_id = id;
+  }
+  else if (id < 0)
+  {
+    // The pool is out of slots, send it on the next pass instead
+    due = true;
+    event_loop_signal(EVENT_TICK);
+  }
+}
+
+bool macro_replay_start(uint8_t slot)
+{
+  if (slot >= PT_XINPUT_PADS || macro_state() != MACRO_IDLE || atomic_load_explicit(&length, memory_order_relaxed) == 0)
+  {
+    return false;
+  }
+
+  replay_slot = slot;
+  read_pos = 0;
+  macro_codec_reset(&decoder, 0);
+  macro_stats.replayed = 0;
+  macro_stats.late_min_us = 0;
+  macro_stats.late_max_us = 0;
+  macro_stats.late_total_us = 0;
+  macro_stats.late_over = 0;
+  atomic_store_explicit(&state, MACRO_REPLAYING, memory_order_release);
+
+  // The recording starts from the neutral state, which goes out right away
+  start = get_absolute_time();
+  target = start;
+  due = true;
+  event_loop_signal(EVENT_TICK);
+  return true;
+}
+
+bool macro_save(void)
+{
+  uint32_t len = atomic_load_explicit(&length, memory_order_relaxed);
+  if (macro_state() != MACRO_IDLE || len == 0)
+  {
+    return false;
+  }
+  config_store_save_macro(buffer, len);
+  return true;
+}
+
+bool macro_capture(const report_frame_t *frame)
+{
+  macro_state_t s = (macro_state_t)atomic_load_explicit(&state, memory_order_acquire);
+  if (s == MACRO_REPLAYING)
+  {
+    if (frame->slot != replay_slot)
+    {
+      return true;
+    }
+    macro_stats.held_back++;
+    return false;
+  }
+  if (s != MACRO_RECORDING || frame->slot != record_slot)
+  {
+    return true;
+  }
+
+  atomic_store(&writing, true);
+  uint32_t len = atomic_load_explicit(&length, memory_order_relaxed);
+  if (atomic_load(&state) == MACRO_RECORDING && !macro_stats.full)
+  {
+    macro_stats.captured++;
+    if (len + MACRO_EVENT_MAX + MACRO_TAIL > sizeof(buffer))
+    {
+      // macro_task ends the recording
+      macro_stats.full = true;
+      event_loop_signal(EVENT_TICK);
+    }
+    else
+    {
+      // Receive time, so the time spent in the pipeline does not add jitter.
+      // A frame received before the recording started counts from its start
+      uint32_t t_us = REPORT_FRAME_TIMESTAMPS ? REPORT_FRAME_RX_US(frame) : time_us_32();
+      if ((int32_t)(t_us - encoder.t_us) < 0)
+      {
+        t_us = encoder.t_us;
+      }
+
+      xinput_report_t const *r = &frame->report;
+      telemetry_pad_t pad = {
+          .buttons = r->bmButtons,
+          .left_trigger = r->bLeftTrigger,
+          .right_trigger = r->bRightTrigger,
+          .thumb_lx = r->wThumbLeftX,
+          .thumb_ly = r->wThumbLeftY,
+          .thumb_rx = r->wThumbRightX,
+          .thumb_ry = r->wThumbRightY,
+      };
+      uint8_t n = macro_encode(&encoder, t_us, &pad, buffer + len);
+      if (n)
+      {
+        atomic_store_explicit(&length, len + n, memory_order_relaxed);
+        macro_stats.bytes = len + n;
+        macro_stats.events++;
+      }
+    }
+  }
+  atomic_store(&writing, false);
+  return true;
+}
+
+bool macro_task(report_frame_t *frame)
+{
+  macro_state_t s = macro_state();
+  if (s == MACRO_RECORDING && macro_stats.full)
+  {
+    macro_stop();
+    return false;
+  }
+  if (s != MACRO_REPLAYING || !due)
+  {
+    return false;
+  }
+  due = false;
+
+  *frame = (report_frame_t){0};
+  frame->slot = replay_slot;
+  frame->report.bSize = 0x14;
+  frame->report.bmButtons = decoder.pad.buttons;
+  frame->report.bLeftTrigger = decoder.pad.left_trigger;
+  frame->report.bRightTrigger = decoder.pad.right_trigger;
+  frame->report.wThumbLeftX = decoder.pad.thumb_lx;
+  frame->report.wThumbLeftY = decoder.pad.thumb_ly;
+  frame->report.wThumbRightX = decoder.pad.thumb_rx;
+  frame->report.wThumbRightY = decoder.pad.thumb_ry;
+  report_frame_stamp(frame);
+  report_frame_keep_raw(frame);
+
+  uint32_t late = time_us_32() - (uint32_t)to_us_since_boot(target);
+  macro_stats_t *st = &macro_stats;
+  if (st->replayed == 0 || late < st->late_min_us)
+  {
+    st->late_min_us = late;
+  }
+  if (late > st->late_max_us)
+  {
+    st->late_max_us = late;
+  }
+  if (late > MACRO_LATE_LIMIT_US)
+  {
+    st->late_over++;
+  }
+  st->late_total_us += late;
+  st->replayed++;
+
+  replay_next();
+  return true;
+}
+
+#endif
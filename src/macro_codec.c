@@ -0,0 +1,141 @@
+#include <string.h>
+
+#include "macro_codec.h"
+
+void macro_codec_reset(macro_codec_t *c, uint32_t t_us)
+{
+  memset(&c->pad, 0, sizeof(c->pad));
+  c->t_us = t_us;
+}
+
+static uint8_t put_varint(uint8_t *out, uint32_t v)
+{
+  uint8_t n = 0;
+  while (v >= 0x80)
+  {
+    out[n++] = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  out[n++] = (uint8_t)v;
+  return n;
+}
+
+// Returns the bytes taken, 0 if truncated or longer than 5 bytes
+static uint8_t get_varint(uint8_t const *in, uint32_t len, uint32_t *v)
+{
+  uint32_t r = 0;
+  for (uint8_t n = 0; n < 5 && n < len; n++)
+  {
+    r |= (uint32_t)(in[n] & 0x7F) << (7 * n);
+    if (!(in[n] & 0x80))
+    {
+      *v = r;
+      return n + 1;
+    }
+  }
+  return 0;
+}
+
+static uint32_t zigzag(int32_t v)
+{
+  return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v)
+{
+  return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+// Field values as int32_t, in mask bit order
+static void fields(telemetry_pad_t const *p, int32_t f[MACRO_FIELD_COUNT])
+{
+  f[MACRO_FIELD_BUTTONS] = p->buttons;
+  f[MACRO_FIELD_LT] = p->left_trigger;
+  f[MACRO_FIELD_RT] = p->right_trigger;
+  f[MACRO_FIELD_LX] = p->thumb_lx;
+  f[MACRO_FIELD_LY] = p->thumb_ly;
+  f[MACRO_FIELD_RX] = p->thumb_rx;
+  f[MACRO_FIELD_RY] = p->thumb_ry;
+}
+
+uint8_t macro_encode(macro_codec_t *c, uint32_t t_us, telemetry_pad_t const *pad, uint8_t *out)
+{
+  int32_t prev[MACRO_FIELD_COUNT], next[MACRO_FIELD_COUNT];
+  fields(&c->pad, prev);
+  fields(pad, next);
+
+  uint8_t mask = 0;
+  for (uint8_t i = 0; i < MACRO_FIELD_COUNT; i++)
+  {
+    mask |= (uint8_t)((prev[i] != next[i]) << i);
+  }
+  if (!mask)
+  {
+    return 0;
+  }
+
+  uint8_t n = put_varint(out, t_us - c->t_us);
+  out[n++] = mask;
+  for (uint8_t i = 0; i < MACRO_FIELD_COUNT; i++)
+  {
+    if (mask & (1u << i))
+    {
+      uint32_t v = i == MACRO_FIELD_BUTTONS ? (uint32_t)(prev[i] ^ next[i]) : zigzag(next[i] - prev[i]);
+      n += put_varint(out + n, v);
+    }
+  }
+
+  c->pad = *pad;
+  c->t_us = t_us;
+  return n;
+}
+
+uint8_t macro_encode_mark(macro_codec_t *c, uint32_t t_us, uint8_t *out)
+{
+  uint8_t n = put_varint(out, t_us - c->t_us);
+  out[n++] = 0;
+  c->t_us = t_us;
+  return n;
+}
+
+uint8_t macro_decode(macro_codec_t *c, uint8_t const *in, uint32_t len)
+{
+  uint32_t dt;
+  uint8_t n = get_varint(in, len, &dt);
+  if (n == 0 || n >= len || (in[n] & ~((1u << MACRO_FIELD_COUNT) - 1)))
+  {
+    return 0;
+  }
+  uint8_t mask = in[n++];
+
+  int32_t f[MACRO_FIELD_COUNT];
+  fields(&c->pad, f);
+  for (uint8_t i = 0; i < MACRO_FIELD_COUNT; i++)
+  {
+    if (!(mask & (1u << i)))
+    {
+      continue;
+    }
+    uint32_t v;
+    uint8_t used = get_varint(in + n, len - n, &v);
+    if (used == 0)
+    {
+      return 0;
+    }
+    n += used;
+    f[i] = i == MACRO_FIELD_BUTTONS ? (int32_t)((uint32_t)f[i] ^ v) : (int32_t)((uint32_t)f[i] + (uint32_t)unzigzag(v));
+  }
+
+  // Out-of-range values wrap like the fields they are stored in
+  c->pad = (telemetry_pad_t){
+      .buttons = (uint16_t)f[MACRO_FIELD_BUTTONS],
+      .left_trigger = (uint8_t)f[MACRO_FIELD_LT],
+      .right_trigger = (uint8_t)f[MACRO_FIELD_RT],
+      .thumb_lx = (int16_t)f[MACRO_FIELD_LX],
+      .thumb_ly = (int16_t)f[MACRO_FIELD_LY],
+      .thumb_rx = (int16_t)f[MACRO_FIELD_RX],
+      .thumb_ry = (int16_t)f[MACRO_FIELD_RY],
+  };
+  c->t_us += dt;
+  return n;
+}
@@ -0,0 +1,115 @@
+#include "ms_os_desc.h"
+#include "usb_descriptors.h"
+
+// Spelled out so the host tools build this file without TinyUSB
+#define LE16(x) (uint8_t)((x) & 0xFF), (uint8_t)(((x) >> 8) & 0xFF)
+#define LE32(x) LE16((x) & 0xFFFF), LE16(((x) >> 16) & 0xFFFF)
+
+#define DESC_BOS 0x0F
+#define DESC_DEVICE_CAPABILITY 0x10
+#define DEVICE_CAPABILITY_USB20_EXTENSION 0x02
+#define DEVICE_CAPABILITY_PLATFORM 0x05
+
+// Windows 8.1, the first version that reads MS OS 2.0 descriptors
+#define MS_OS_2_0_WINDOWS_VERSION 0x06030000
+
+// MS OS 2.0 descriptor types
+#define MS_OS_2_0_SET_HEADER 0x00
+#define MS_OS_2_0_SUBSET_CONFIGURATION 0x01
+#define MS_OS_2_0_SUBSET_FUNCTION 0x02
+#define MS_OS_2_0_FEATURE_COMPATIBLE_ID 0x03
+
+// One per XInput interface, the same everywhere but for the interface number
+#define XUSB10_ID 'X', 'U', 'S', 'B', '1', '0', 0x00, 0x00
+
+#if PT_XINPUT_PADS > 1
+#define PAD_1(_each) _each(ITF_NUM_XINPUT + 1)
+#else
+#define PAD_1(_each)
+#endif
+#if PT_XINPUT_PADS > 2
+#define PAD_2(_each) _each(ITF_NUM_XINPUT + 2)
+#else
+#define PAD_2(_each)
+#endif
+#if PT_XINPUT_PADS > 3
+#define PAD_3(_each) _each(ITF_NUM_XINPUT + 3)
+#else
+#define PAD_3(_each)
+#endif
+
+// _each for every XInput interface
+#define XINPUT_PADS(_each) _each(ITF_NUM_XINPUT + 0) PAD_1(_each) PAD_2(_each) PAD_3(_each)
+
+//--------------------------------------------------------------------+
+// MS OS 1.0
+//--------------------------------------------------------------------+
+
+// Function Section (24 bytes), one per XInput interface
+#define MS_OS_1_0_XUSB10(_itf)                                         \
+  _itf, /* bFirstInterface */                                          \
+  0x00, /* reserved */                                                 \
+  XUSB10_ID,                                                           \
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* subCompatibleID */ \
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* reserved */
+
+const uint8_t ms_os_1_0_compat_id[MS_OS_1_0_COMPAT_ID_LEN] = {
+    // Header (16 bytes)
+    LE32(MS_OS_1_0_COMPAT_ID_LEN),
+    LE16(0x0100),                      // bcdVersion
+    LE16(MS_OS_1_0_COMPAT_ID_INDEX),   // wIndex
+    PT_XINPUT_PADS,                    // function sections
+    0, 0, 0, 0, 0, 0, 0,               // reserved[7]
+
+    XINPUT_PADS(MS_OS_1_0_XUSB10)
+};
+
+//--------------------------------------------------------------------+
+// MS OS 2.0
+//--------------------------------------------------------------------+
+
+// Function subset (8 bytes) with the compatible ID feature (20 bytes)
+#define MS_OS_2_0_XUSB10(_itf)                                          \
+  LE16(8), LE16(MS_OS_2_0_SUBSET_FUNCTION), _itf, 0x00, LE16(8 + 20),   \
+  LE16(20), LE16(MS_OS_2_0_FEATURE_COMPATIBLE_ID), XUSB10_ID,           \
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* subCompatibleID */
+
+const uint8_t ms_os_2_0_set[MS_OS_2_0_SET_LEN] = {
+    // Set header: wLength, wDescriptorType, dwWindowsVersion, wTotalLength
+    LE16(10), LE16(MS_OS_2_0_SET_HEADER), LE32(MS_OS_2_0_WINDOWS_VERSION), LE16(MS_OS_2_0_SET_LEN),
+
+    // Configuration subset: wLength, wDescriptorType, bConfigurationValue
+    // (the configuration index, so 0), bReserved, wTotalLength
+    LE16(8), LE16(MS_OS_2_0_SUBSET_CONFIGURATION), 0, 0, LE16(MS_OS_2_0_SET_LEN - 10),
+
+    XINPUT_PADS(MS_OS_2_0_XUSB10)
+};
+
+//--------------------------------------------------------------------+
+// BOS
+//--------------------------------------------------------------------+
+
+// bLength, bDescriptorType, wTotalLength, bNumDeviceCaps
+#define BOS_HEADER(_len, _caps) 5, DESC_BOS, LE16(_len), _caps
+
+// No link power management
+#define BOS_USB20_EXTENSION 7, DESC_DEVICE_CAPABILITY, DEVICE_CAPABILITY_USB20_EXTENSION, LE32(0)
+
+const uint8_t usb_bos_plain[USB_BOS_PLAIN_LEN] = {
+    BOS_HEADER(USB_BOS_PLAIN_LEN, 1),
+    BOS_USB20_EXTENSION,
+};
+
+const uint8_t usb_bos_ms_os[USB_BOS_MS_OS_LEN] = {
+    BOS_HEADER(USB_BOS_MS_OS_LEN, 2),
+    BOS_USB20_EXTENSION,
+
+    // MS OS 2.0 platform capability
+    28, DESC_DEVICE_CAPABILITY, DEVICE_CAPABILITY_PLATFORM, 0x00,
+    // PlatformCapabilityUUID D8DD60DF-4589-4CC7-9CD2-659D9E648A9F
+    0xDF, 0x60, 0xDD, 0xD8, 0x89, 0x45, 0xC7, 0x4C, 0x9C, 0xD2, 0x65, 0x9D, 0x9E, 0x64, 0x8A, 0x9F,
+    LE32(MS_OS_2_0_WINDOWS_VERSION),
+    LE16(MS_OS_2_0_SET_LEN),  // wMSOSDescriptorSetTotalLength
+    MS_OS_2_0_VENDOR_CODE,    // bMS_VendorCode
+    0x00,                     // bAltEnumCode
+};
@@ -0,0 +1,141 @@
+#include "output_relay.h"
+#include "pad_slot.h"
+#include "xinput_host.h"
+
+output_relay_t output_relay[PT_XINPUT_PADS];
+
+// XInput OUT report layouts sent by the PC
+#define XINPUT_OUT_RUMBLE 0x00 // 00 08 00 <left> <right> 00 00 00
+#define XINPUT_OUT_LED 0x01    // 01 03 <pattern>
+
+// The host driver takes a player quadrant rather than a raw LED pattern.
+// Patterns 2-5 flash and 6-9 light quadrant 1-4, everything else (blinking,
+// rotating) has no quadrant equivalent and is not forwarded
+static uint8_t led_quadrant(uint8_t pattern)
+{
+  if (pattern == 0)
+  {
+    return 0;
+  }
+  if (pattern >= 2 && pattern <= 9)
+  {
+    return (uint8_t)((pattern - 2) % 4 + 1);
+  }
+  return 0xFF;
+}
+
+void output_relay_post(uint8_t slot, uint8_t const *report, uint16_t len)
+{
+  if (slot >= PT_XINPUT_PADS || len < 3)
+  {
+    return;
+  }
+  output_relay_t *relay = &output_relay[slot];
+
+  if (report[0] == XINPUT_OUT_RUMBLE && len >= 5)
+  {
+    // Sequence 0 is reserved for "nothing posted yet"
+    relay->rumble_seq = (relay->rumble_seq + 1) & 0xFFFF;
+    if (relay->rumble_seq == 0)
+    {
+      relay->rumble_seq = 1;
+    }
+    atomic_store_explicit(&relay->rumble, (relay->rumble_seq << 16) | (report[3] << 8) | report[4],
+                          memory_order_release);
+  }
+  else if (report[0] == XINPUT_OUT_LED && led_quadrant(report[2]) != 0xFF)
+  {
+    relay->led_seq = (relay->led_seq + 1) & 0xFFFFFF;
+    if (relay->led_seq == 0)
+    {
+      relay->led_seq = 1;
+    }
+    atomic_store_explicit(&relay->led, (relay->led_seq << 8) | led_quadrant(report[2]), memory_order_release);
+  }
+}
+
+// Count requests that were overwritten between two forwards
+static void count_coalesced(output_relay_t *relay, uint32_t sent_seq, uint32_t new_seq, uint32_t mask)
+{
+  uint32_t skipped = ((new_seq - sent_seq) & mask) - 1;
+  if (sent_seq != 0 && skipped < mask / 2)
+  {
+    relay->coalesced += skipped;
+  }
+}
+
+static void relay_one(uint8_t slot, uint8_t dev_addr, uint8_t instance)
+{
+  output_relay_t *relay = &output_relay[slot];
+  if (relay->busy)
+  {
+    return;
+  }
+
+  // Rumble goes first, a late LED change is far less noticeable
+  uint32_t rumble = atomic_load_explicit(&relay->rumble, memory_order_acquire);
+  if (rumble != relay->rumble_sent)
+  {
+    if (tuh_xinput_set_rumble(dev_addr, instance, (rumble >> 8) & 0xFF, rumble & 0xFF, false))
+    {
+      count_coalesced(relay, relay->rumble_sent >> 16, rumble >> 16, 0xFFFF);
+      relay->rumble_sent = rumble;
+      relay->busy = true;
+      relay->forwarded++;
+    }
+    return;
+  }
+
+  uint32_t led = atomic_load_explicit(&relay->led, memory_order_acquire);
+  if (led != relay->led_sent)
+  {
+    if (tuh_xinput_set_led(dev_addr, instance, led & 0xFF, false))
+    {
+      count_coalesced(relay, relay->led_sent >> 8, led >> 8, 0xFFFFFF);
+      relay->led_sent = led;
+      relay->busy = true;
+      relay->forwarded++;
+    }
+  }
+}
+
+void output_relay_task(void)
+{
+  for (uint8_t slot = 0; slot < PT_XINPUT_PADS; slot++)
+  {
+    uint8_t dev_addr, instance;
+    // HID pads have no rumble or LED to relay to
+    if (pad_slot_owner(slot, &dev_addr, &instance) && instance != PAD_SLOT_HID)
+    {
+      relay_one(slot, dev_addr, instance);
+    }
+  }
+}
+
+void output_relay_mounted(uint8_t slot)
+{
+  if (slot >= PT_XINPUT_PADS)
+  {
+    return;
+  }
+  output_relay_t *relay = &output_relay[slot];
+  relay->busy = false;
+  relay->rumble_sent = 0;
+  relay->led_sent = 0;
+}
+
+void output_relay_claim(uint8_t slot)
+{
+  if (slot < PT_XINPUT_PADS)
+  {
+    output_relay[slot].busy = true;
+  }
+}
+
+void output_relay_sent(uint8_t slot)
+{
+  if (slot < PT_XINPUT_PADS)
+  {
+    output_relay[slot].busy = false;
+  }
+}
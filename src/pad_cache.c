@@ -0,0 +1,146 @@
+#include <string.h>
+
+#include "pico/time.h"
+
+#include "pad_cache.h"
+#include "pad_slot.h"
+
+typedef struct
+{
+  tusb_desc_device_t device;
+  uint16_t config_len;
+  uint32_t config_hash;
+  bool valid;
+} cache_entry_t;
+
+pad_connect_stats_t pad_connect_stats[PT_XINPUT_PADS];
+
+static cache_entry_t cache[PT_XINPUT_PADS];
+static uint8_t cache_next;
+
+// Set by the host IRQ, consumed by the next device descriptor
+static volatile uint32_t attach_us;
+
+// Per device address while it enumerates. Hubs, keyboards and anything else
+// that never mounts an XInput interface stay here and never reach the cache
+static uint32_t start_us[PAD_SLOT_MAX_ADDR + 1];
+static cache_entry_t pending[PAD_SLOT_MAX_ADDR + 1];
+static bool known[PAD_SLOT_MAX_ADDR + 1];
+
+// Per slot until its first report arrives
+static uint32_t slot_start_us[PT_XINPUT_PADS];
+static bool awaiting_report[PT_XINPUT_PADS];
+
+// FNV-1a, only needs to tell two configuration descriptors apart
+static uint32_t fingerprint(uint8_t const *data, uint16_t len)
+{
+  uint32_t hash = 2166136261u;
+  while (len--)
+  {
+    hash = (hash ^ *data++) * 16777619u;
+  }
+  return hash;
+}
+
+void pad_cache_attach(void)
+{
+  uint32_t now = time_us_32();
+  attach_us = now ? now : 1;
+}
+
+// Cache entry with the same device descriptor, PT_XINPUT_PADS if none
+static uint8_t cache_find(tusb_desc_device_t const *desc)
+{
+  for (uint8_t i = 0; i < PT_XINPUT_PADS; i++)
+  {
+    if (cache[i].valid && memcmp(&cache[i].device, desc, sizeof(*desc)) == 0)
+    {
+      return i;
+    }
+  }
+  return PT_XINPUT_PADS;
+}
+
+void pad_cache_device(uint8_t daddr, tusb_desc_device_t const *desc)
+{
+  if (daddr > PAD_SLOT_MAX_ADDR)
+  {
+    return;
+  }
+
+  // Pads behind a hub are timed from their device descriptor, only the root
+  // port reports the attach itself
+  uint32_t attached = attach_us;
+  attach_us = 0;
+  start_us[daddr] = attached ? attached : time_us_32();
+
+  pending[daddr] = (cache_entry_t){.device = *desc};
+  known[daddr] = false;
+}
+
+void pad_cache_config(uint8_t daddr, tusb_desc_configuration_t const *desc)
+{
+  if (daddr > PAD_SLOT_MAX_ADDR)
+  {
+    return;
+  }
+
+  cache_entry_t *p = &pending[daddr];
+  p->config_len = tu_le16toh(desc->wTotalLength);
+  p->config_hash = fingerprint((uint8_t const *)desc, p->config_len);
+  p->valid = true;
+
+  uint8_t entry = cache_find(&p->device);
+  known[daddr] = entry < PT_XINPUT_PADS && cache[entry].config_len == p->config_len &&
+                 cache[entry].config_hash == p->config_hash;
+}
+
+bool pad_cache_mounted(uint8_t slot, uint8_t daddr)
+{
+  if (slot >= PT_XINPUT_PADS || daddr > PAD_SLOT_MAX_ADDR)
+  {
+    return false;
+  }
+
+  // Only now is daddr known to be a pad. A device with several pad
+  // interfaces stores its descriptors once
+  cache_entry_t *p = &pending[daddr];
+  if (p->valid)
+  {
+    uint8_t entry = cache_find(&p->device);
+    if (entry == PT_XINPUT_PADS)
+    {
+      entry = cache_next;
+      cache_next = (uint8_t)((cache_next + 1) % PT_XINPUT_PADS);
+    }
+    cache[entry] = *p;
+    p->valid = false;
+  }
+
+  pad_connect_stats_t *s = &pad_connect_stats[slot];
+  bool fast = PT_FAST_RECONNECT && known[daddr];
+  s->connects++;
+  s->fast_connects += fast;
+  s->last_fast = fast;
+  s->mount_us = time_us_32() - start_us[daddr];
+
+  slot_start_us[slot] = start_us[daddr];
+  awaiting_report[slot] = true;
+  return fast;
+}
+
+void pad_cache_report(uint8_t slot)
+{
+  if (slot >= PT_XINPUT_PADS || !awaiting_report[slot])
+  {
+    return;
+  }
+  awaiting_report[slot] = false;
+
+  pad_connect_stats_t *s = &pad_connect_stats[slot];
+  s->first_report_us = time_us_32() - slot_start_us[slot];
+  if (s->best_us == 0 || s->first_report_us < s->best_us)
+  {
+    s->best_us = s->first_report_us;
+  }
+}
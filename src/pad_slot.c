@@ -0,0 +1,88 @@
+#include <string.h>
+
+#include "pad_slot.h"
+
+uint8_t pad_slot_map[PAD_SLOT_MAX_ADDR + 1][PAD_SLOT_MAX_INSTANCES + 1];
+
+// Owner key of each slot, 0 when free. last_owner survives an unplug so the
+// same controller lands on the same slot again
+static uint16_t slot_owner[PT_XINPUT_PADS];
+static uint16_t slot_last_owner[PT_XINPUT_PADS];
+
+static uint16_t owner_key(uint8_t dev_addr, uint8_t instance)
+{
+  return (uint16_t)((dev_addr << 8) | instance | 0x8000);
+}
+
+void pad_slot_init(void)
+{
+  memset(pad_slot_map, PAD_SLOT_NONE, sizeof(pad_slot_map));
+  memset(slot_owner, 0, sizeof(slot_owner));
+  memset(slot_last_owner, 0, sizeof(slot_last_owner));
+}
+
+uint8_t pad_slot_acquire(uint8_t dev_addr, uint8_t instance)
+{
+  if (dev_addr > PAD_SLOT_MAX_ADDR || instance > PAD_SLOT_HID)
+  {
+    return PAD_SLOT_NONE;
+  }
+
+  uint16_t key = owner_key(dev_addr, instance);
+  uint8_t slot = PAD_SLOT_NONE;
+
+  for (uint8_t i = 0; i < PT_XINPUT_PADS; i++)
+  {
+    if (slot_owner[i] == 0 && slot_last_owner[i] == key)
+    {
+      slot = i;
+      break;
+    }
+  }
+
+  // Prefer slots nobody used yet so other controllers keep theirs
+  for (uint8_t i = 0; i < PT_XINPUT_PADS && slot == PAD_SLOT_NONE; i++)
+  {
+    if (slot_owner[i] == 0 && slot_last_owner[i] == 0)
+    {
+      slot = i;
+    }
+  }
+  for (uint8_t i = 0; i < PT_XINPUT_PADS && slot == PAD_SLOT_NONE; i++)
+  {
+    if (slot_owner[i] == 0)
+    {
+      slot = i;
+    }
+  }
+
+  if (slot != PAD_SLOT_NONE)
+  {
+    slot_owner[slot] = key;
+    slot_last_owner[slot] = key;
+    pad_slot_map[dev_addr][instance] = slot;
+  }
+  return slot;
+}
+
+uint8_t pad_slot_release(uint8_t dev_addr, uint8_t instance)
+{
+  uint8_t slot = pad_slot_lookup(dev_addr, instance);
+  if (slot != PAD_SLOT_NONE)
+  {
+    slot_owner[slot] = 0;
+    pad_slot_map[dev_addr][instance] = PAD_SLOT_NONE;
+  }
+  return slot;
+}
+
+bool pad_slot_owner(uint8_t slot, uint8_t *dev_addr, uint8_t *instance)
+{
+  if (slot >= PT_XINPUT_PADS || slot_owner[slot] == 0)
+  {
+    return false;
+  }
+  *dev_addr = (uint8_t)((slot_owner[slot] >> 8) & 0x7F);
+  *instance = (uint8_t)(slot_owner[slot] & 0xFF);
+  return true;
+}
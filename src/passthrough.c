@@ -13,6 +13,7 @@
 #include "pico/stdio.h"
 #include "pico/stdio/driver.h"
 #include "pico/multicore.h"
+#include "pico/flash.h"
 
 // TinyUSB and board headers
 #include "tusb.h"
@@ -26,8 +27,36 @@
 #include "pio_usb.h"
 
 // Project-specific headers
+#include "passthrough_config.h"
 #include "device_callbacks.h"
 #include "host_callbacks.h"
+#include "report_frame.h"
+#include "host_report.h"
+#include "report_ring.h"
+#include "report_translate.h"
+#include "remap.h"
+#include "stick_curve.h"
+#include "stage_profile.h"
+#include "delta_filter.h"
+#include "pad_slot.h"
+#include "output_relay.h"
+#include "latency_stats.h"
+#include "report_mailbox.h"
+#include "telemetry.h"
+#include "settings.h"
+#include "command.h"
+#include "event_loop.h"
+#include "host_poll.h"
+#include "sof_align.h"
+#include "config_store.h"
+#include "boot_timeline.h"
+#include "pad_cache.h"
+#include "pipeline.h"
+#include "turbo.h"
+#include "hid_input.h"
+#include "usb_personality.h"
+#include "usb_strings.h"
+#include "macro.h"
 
 // Cannot use pico/stdio_usb.h along with tinyusb host mode
 // So we copy the file into our own project
@@ -45,16 +74,10 @@ void led_blinking_task(void);
 void cdc_task(void);
 void xusbd_task();
 
-int main(void)
+static void host_stack_init(void)
 {
-
-  set_sys_clock_khz(240000, true);
-  board_init();
-
-  tusb_rhport_init_t dev_init = {
-      .role = TUSB_ROLE_DEVICE,
-      .speed = TUSB_SPEED_AUTO};
-  tusb_init(BOARD_TUD_RHPORT, &dev_init);
+  stage_profile_init();
+  pad_slot_init();
 
   pio_usb_configuration_t pio_cfg = PIO_USB_DEFAULT_CONFIG;
 
@@ -62,10 +85,164 @@ int main(void)
   pio_cfg.pinout = PIO_USB_PINOUT_DPDM;
   tuh_configure(BOARD_TUH_RHPORT, TUH_CFGID_RPI_PIO_USB_CONFIGURATION, &pio_cfg);
 
+#if PT_HID_HOST
+  // Boot protocol reports carry no descriptor to compile
+  tuh_hid_set_default_protocol(HID_PROTOCOL_REPORT);
+#endif
+
   tusb_rhport_init_t host_init = {
       .role = TUSB_ROLE_HOST,
       .speed = TUSB_SPEED_AUTO};
   tusb_init(BOARD_TUH_RHPORT, &host_init);
+  boot_mark(BOOT_HOST_STACK);
+}
+
+#if PT_DUAL_CORE
+// Core1 owns the PIO USB host port. pio_usb creates its SOF alarm pool on the
+// core that initialises it, so the host stack must be brought up from here.
+static void core1_main(void)
+{
+  // Let core0 park this core while it writes the config store
+  flash_safe_execute_core_init();
+  host_stack_init();
+
+  while (1)
+  {
+    // A finished OUT transfer frees the pad for the next relay request
+    bool host = event_loop_take(EVENT_HOST);
+    if (host)
+    {
+      tuh_task();
+    }
+
+    // Forward rumble and LED requests from the PC
+    if (event_loop_take(EVENT_RELAY) || host)
+    {
+      output_relay_task();
+    }
+    hid_idle_task();
+
+    // Let go of superseded settings tables even while no pad is reporting
+    settings_tables();
+
+    // The PIO USB frame timer wakes this core at least once per millisecond
+    event_loop_sleep(EVENT_BIT(EVENT_HOST) | EVENT_BIT(EVENT_RELAY), false);
+  }
+}
+#endif
+
+// Hand a frame to the device endpoint, runs on the device core
+static void report_forward(const report_frame_t *in)
+{
+  report_frame_t frame = *in;
+  turbo_apply(&frame);
+#if PT_DELTA_SUPPRESS
+  if (!delta_filter_check(&delta_filter[frame.slot], &frame.report, time_us_32()))
+  {
+    return;
+  }
+#endif
+  report_mailbox_post(&report_mailbox[frame.slot], &frame);
+  boot_mark(BOOT_FIRST_REPORT);
+  telemetry_sample(&frame, time_us_32());
+}
+
+// Forward a translated report to the device stack
+static void report_submit(const report_frame_t *frame)
+{
+#if PT_DUAL_CORE && PT_REPORT_RING_LATEST_WINS
+  report_ring_push_latest(&report_ring[frame->slot], frame);
+  event_loop_signal(EVENT_RING);
+#elif PT_DUAL_CORE
+  if (report_ring_push(&report_ring[frame->slot], frame))
+  {
+    event_loop_signal(EVENT_RING);
+  }
+#else
+  report_forward(frame);
+#endif
+}
+
+// Run a translated report through the pipeline and submit it, host core
+void report_process(report_frame_t *frame)
+{
+  pipeline_ctx_t ctx = {
+      .tables = settings_tables(),
+      .state = &pipeline_state[frame->slot],
+      .slot = frame->slot,
+      .now_us = REPORT_FRAME_TIMESTAMPS ? REPORT_FRAME_RX_US(frame) : time_us_32()};
+  pipeline_run(&ctx, &frame->report);
+
+  // Recorded as it would go out, and not sent while a macro plays on its slot
+  if (!macro_capture(frame))
+  {
+    return;
+  }
+  report_submit(frame);
+}
+
+#if PT_HID_HOST
+// Re-centre the right stick of HID devices whose mouse came to rest
+static void hid_idle_task(void)
+{
+  uint8_t dev_addr;
+  report_frame_t frame;
+  if (!hid_input_idle(&dev_addr, &frame.report))
+  {
+    return;
+  }
+  frame.slot = pad_slot_lookup(dev_addr, PAD_SLOT_HID);
+  if (frame.slot == PAD_SLOT_NONE)
+  {
+    return;
+  }
+  report_frame_stamp(&frame);
+  report_frame_keep_raw(&frame);
+  report_process(&frame);
+}
+#else
+static inline void hid_idle_task(void) {}
+#endif
+
+int main(void)
+{
+
+  set_sys_clock_khz(240000, true);
+  boot_mark(BOOT_CLOCK);
+  board_init();
+  boot_mark(BOOT_BOARD);
+
+  // Mapping and curves applied to every translated report, read from flash
+  // before USB is running
+  settings_init();
+  boot_mark(BOOT_SETTINGS);
+
+  // The saved personality decides the descriptors of the first enumeration
+  usb_personality_init(settings.personality);
+
+  // The serial number is read from flash once, every other string
+  // descriptor is built at compile time
+  uint16_t serial[USB_STRING_SERIAL_MAX];
+  usb_string_set_serial(serial, board_usb_get_serial(serial, USB_STRING_SERIAL_MAX));
+
+  tusb_rhport_init_t dev_init = {
+      .role = TUSB_ROLE_DEVICE,
+      .speed = TUSB_SPEED_AUTO};
+  tusb_init(BOARD_TUD_RHPORT, &dev_init);
+  boot_mark(BOOT_DEVICE_STACK);
+
+  report_mailbox_init();
+
+#if PT_DUAL_CORE
+  for (uint8_t i = 0; i < PT_XINPUT_PADS; i++)
+  {
+    report_ring_init(&report_ring[i]);
+  }
+  multicore_reset_core1();
+  multicore_launch_core1(core1_main);
+#else
+  host_stack_init();
+#endif
 
   if (board_init_after_tusb)
   {
@@ -73,18 +250,124 @@ int main(void)
   }
 
   stdio_usb_init();
+  event_loop_init();
+  sof_align_init();
+  turbo_init();
+  macro_init();
+  boot_mark(BOOT_STDIO);
+
+  boot_mark(BOOT_LOOP);
 
-  // Main loop
+  // Main loop. Every pass serves the events that were signalled since the
+  // previous one, then the core sleeps until the next interrupt
   while (1)
   {
+#if PT_DUAL_CORE
+    // Device task
+    if (event_loop_take(EVENT_DEVICE))
+    {
+      tud_task();
+    }
+
+    // Forward whatever core1 produced since the last pass
+    if (event_loop_take(EVENT_RING))
+    {
+      for (uint8_t i = 0; i < PT_XINPUT_PADS; i++)
+      {
+        report_frame_t frame;
+#if PT_REPORT_RING_LATEST_WINS
+        if (report_ring_pop_latest(&report_ring[i], &frame))
+        {
+          report_forward(&frame);
+        }
+#else
+        if (report_ring_pop(&report_ring[i], &frame))
+        {
+          report_forward(&frame);
+
+          // One frame per pass, come back for the rest on the next one
+          event_loop_signal(EVENT_RING);
+        }
+#endif
+      }
+    }
+#else
     // Host task
-    tuh_task();
+    bool host = event_loop_take(EVENT_HOST);
+    if (host)
+    {
+      tuh_task();
+    }
+    if (event_loop_take(EVENT_RELAY) || host)
+    {
+      output_relay_task();
+    }
+    hid_idle_task();
 
     // Device task
-    tud_task();
+    if (event_loop_take(EVENT_DEVICE))
+    {
+      tud_task();
+    }
+#endif
+
+    // Run commands received on CDC 0 and publish any settings they changed
+    command_task();
+    bool busy = settings_task();
+    busy |= usb_personality_task();
+    config_store_task();
+
+    // Drain buffered printf output into CDC 0
+    stdio_usb_task();
+
+    // Counters and flush of the binary stream on CDC 1
+    telemetry_task();
+
+    // Re-send the pads whose held turbo buttons toggled
+    for (uint8_t i = 0; i < PT_XINPUT_PADS; i++)
+    {
+      report_frame_t frame;
+      if (turbo_inject(i, &frame))
+      {
+        report_forward(&frame);
+      }
+    }
+
+    // Next step of a macro replay once its alarm fired
+    report_frame_t macro_frame;
+    if (macro_task(&macro_frame))
+    {
+      report_forward(&macro_frame);
+    }
+
+    // Catch up on frames the endpoints were too busy to take, or commit
+    // them at the point the SOF alarm picked
+    if (sof_align_active())
+    {
+      sof_align_task();
+    }
+    else
+    {
+      for (uint8_t i = 0; i < PT_XINPUT_PADS; i++)
+      {
+        report_mailbox_flush(&report_mailbox[i]);
+      }
+    }
 
     // led blink task
     led_blinking_task();
+
+    // The tick only exists to wake the self-timed tasks above
+    event_loop_take(EVENT_TICK);
+
+    // A settings change waits for core1 to release the old tables and a
+    // personality switch times its detach, keep polling until they went through
+#if PT_DUAL_CORE
+    event_loop_sleep(EVENT_BIT(EVENT_DEVICE) | EVENT_BIT(EVENT_RING) | EVENT_BIT(EVENT_TICK), busy);
+#else
+    event_loop_sleep(EVENT_BIT(EVENT_DEVICE) | EVENT_BIT(EVENT_HOST) | EVENT_BIT(EVENT_RELAY) | EVENT_BIT(EVENT_TICK),
+                     busy);
+#endif
   }
 
   return 0;
@@ -121,40 +404,122 @@ usbd_class_driver_t const *usbd_app_driver_get_cb(uint8_t *driver_count)
   return &usbd_xinput_driver;
 }
 
-// Application callback invoked when XInput report is received
-// For passthrough, we send a device report for every report we receive
-void tuh_xinput_report_received_cb(uint8_t dev_addr, uint8_t instance, xinputh_interface_t const *xid_itf, uint16_t len)
+// Application callback invoked when Xinput device is plugged in
+void tuh_xinput_mount_cb(uint8_t dev_addr, uint8_t instance, const xinputh_interface_t *xinput_itf)
 {
-  (void)len; // unused
-  const xinput_gamepad_t *p = &xid_itf->pad;
-  const char *type_str;
-  if (xid_itf->last_xfer_result == XFER_RESULT_SUCCESS)
+  (void)xinput_itf;
+  uint8_t slot = pad_slot_acquire(dev_addr, instance);
+  boot_mark(BOOT_PAD_MOUNTED);
+  output_relay_mounted(slot);
+  host_poll_mounted(slot, dev_addr);
+
+  if (pad_cache_mounted(slot, dev_addr))
   {
-    if (xid_itf->connected && xid_itf->new_pad_data)
+    // Same pad as before, a freshly plugged pad has no rumble running and
+    // its LED animation is replaced anyway. Start reports first and set the
+    // player LED without waiting for it
+    tuh_xinput_receive_report(dev_addr, instance);
+    if (tuh_xinput_set_led(dev_addr, instance, slot + 1, false))
     {
-      // Create a report to send to the PC.
-      xinput_report_t report = {0};
-      report.bReportID = 0;
-      report.bSize = 0x14;
-      report.bmButtons = p->wButtons;
-      report.bLeftTrigger = p->bLeftTrigger;
-      report.bRightTrigger = p->bRightTrigger;
-      report.wThumbLeftX = p->sThumbLX;
-      report.wThumbLeftY = p->sThumbLY;
-      report.wThumbRightX = p->sThumbRX;
-      report.wThumbRightY = p->sThumbRY;
-
-      tud_xinput_report(&report);
+      output_relay_claim(slot);
     }
+    return;
   }
-  tuh_xinput_receive_report(dev_addr, instance);
-}
 
-// Application callback invoked when Xinput device is plugged in
-void tuh_xinput_mount_cb(uint8_t dev_addr, uint8_t instance, const xinputh_interface_t *xinput_itf)
-{
+  // Player LED shows which XInput interface the pad is passed through to
   tuh_xinput_set_led(dev_addr, instance, 0, true);
-  tuh_xinput_set_led(dev_addr, instance, 1, true);
+  tuh_xinput_set_led(dev_addr, instance, slot == PAD_SLOT_NONE ? 1 : slot + 1, true);
   tuh_xinput_set_rumble(dev_addr, instance, 0, 0, true);
   tuh_xinput_receive_report(dev_addr, instance);
 }
+
+// Application callback invoked when an OUT report (rumble, LED) reached the pad
+void tuh_xinput_report_sent_cb(uint8_t dev_addr, uint8_t instance, uint8_t const *report, uint16_t len)
+{
+  (void)report;
+  (void)len;
+  output_relay_sent(pad_slot_lookup(dev_addr, instance));
+}
+
+// Application callback invoked when Xinput device is unplugged
+void tuh_xinput_umount_cb(uint8_t dev_addr, uint8_t instance)
+{
+  uint8_t slot = pad_slot_release(dev_addr, instance);
+  if (slot == PAD_SLOT_NONE)
+  {
+    return;
+  }
+
+  // Release everything on the PC side so no button stays held
+  report_frame_t frame;
+  report_frame_stamp(&frame);
+  frame.slot = slot;
+  report_translate(&(xinput_gamepad_t){0}, &frame.report);
+  report_frame_keep_raw(&frame);
+  report_submit(&frame);
+}
+
+#if PT_HID_HOST
+// Application callback invoked when a HID interface is plugged in. Every
+// interface of the device feeds the same slot
+void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t idx, uint8_t const *desc_report, uint16_t desc_len)
+{
+  if (!hid_input_mount(dev_addr, idx, desc_report, desc_len))
+  {
+    return;
+  }
+
+  if (pad_slot_lookup(dev_addr, PAD_SLOT_HID) == PAD_SLOT_NONE)
+  {
+    uint8_t slot = pad_slot_acquire(dev_addr, PAD_SLOT_HID);
+    boot_mark(BOOT_PAD_MOUNTED);
+    pad_cache_mounted(slot, dev_addr);
+  }
+  tuh_hid_receive_report(dev_addr, idx);
+}
+
+// Application callback invoked when a HID interface delivered a report
+void tuh_hid_report_received_cb(uint8_t dev_addr, uint8_t idx, uint8_t const *report, uint16_t len)
+{
+  uint8_t slot = pad_slot_lookup(dev_addr, PAD_SLOT_HID);
+  if (slot != PAD_SLOT_NONE)
+  {
+    report_frame_t frame;
+    report_frame_stamp(&frame);
+    frame.slot = slot;
+    uint32_t t = stage_profile_now();
+
+    bool changed = hid_input_report(dev_addr, idx, report, len, &frame.report);
+    stage_profile_record(PROFILE_TRANSLATE, t);
+    if (changed)
+    {
+      report_frame_keep_raw(&frame);
+      report_process(&frame);
+    }
+  }
+  pad_cache_report(slot);
+  tuh_hid_receive_report(dev_addr, idx);
+}
+
+// Application callback invoked when a HID interface is unplugged
+void tuh_hid_umount_cb(uint8_t dev_addr, uint8_t idx)
+{
+  if (!hid_input_umount(dev_addr, idx))
+  {
+    return;
+  }
+  uint8_t slot = pad_slot_release(dev_addr, PAD_SLOT_HID);
+  if (slot == PAD_SLOT_NONE)
+  {
+    return;
+  }
+
+  // Release everything on the PC side so no button stays held
+  report_frame_t frame;
+  report_frame_stamp(&frame);
+  frame.slot = slot;
+  report_translate(&(xinput_gamepad_t){0}, &frame.report);
+  report_frame_keep_raw(&frame);
+  report_submit(&frame);
+}
+#endif
@@ -0,0 +1,126 @@
+#include "pipeline.h"
+
+typedef void (*pipeline_stage_fn)(const pipeline_ctx_t *ctx, xinput_report_t *report);
+
+typedef struct
+{
+  pipeline_stage_fn fn;
+  uint8_t profile;  // stage_profile slot
+} pipeline_stage_t;
+
+const char *const pipeline_stage_names[PIPELINE_STAGE_COUNT] = {"remap", "smooth", "curve"};
+
+atomic_uint pipeline_mask = PIPELINE_STAGES_BUILT;
+
+pipeline_state_t pipeline_state[PT_XINPUT_PADS];
+
+#if PT_STAGE_REMAP
+static void stage_remap(const pipeline_ctx_t *ctx, xinput_report_t *report)
+{
+  remap_apply(&ctx->tables->remap, report);
+}
+#endif
+
+#if PT_STAGE_SMOOTH
+static void stage_smooth(const pipeline_ctx_t *ctx, xinput_report_t *report)
+{
+  pipeline_smooth(ctx, report);
+}
+#endif
+
+#if PT_STAGE_CURVE
+static void stage_curve(const pipeline_ctx_t *ctx, xinput_report_t *report)
+{
+  curve_apply(&ctx->tables->curve, report);
+}
+#endif
+
+// Indexed by stage, stages left out of the build have no entry
+static const pipeline_stage_t stages[PIPELINE_STAGE_COUNT] = {
+#if PT_STAGE_REMAP
+    [PIPELINE_REMAP] = {stage_remap, PROFILE_REMAP},
+#endif
+#if PT_STAGE_SMOOTH
+    [PIPELINE_SMOOTH] = {stage_smooth, PROFILE_SMOOTH},
+#endif
+#if PT_STAGE_CURVE
+    [PIPELINE_CURVE] = {stage_curve, PROFILE_CURVE},
+#endif
+};
+
+void pipeline_set_mask(uint32_t mask)
+{
+  atomic_store_explicit(&pipeline_mask, mask & PIPELINE_STAGES_BUILT, memory_order_relaxed);
+}
+
+void pipeline_run_dynamic(const pipeline_ctx_t *ctx, xinput_report_t *report, bool profile)
+{
+  uint32_t mask = atomic_load_explicit(&pipeline_mask, memory_order_relaxed);
+  uint32_t t = profile ? stage_profile_now() : 0;
+
+  for (uint8_t i = 0; mask; i++, mask >>= 1)
+  {
+    if (mask & 1)
+    {
+      stages[i].fn(ctx, report);
+      if (profile)
+      {
+        t = stage_profile_record(stages[i].profile, t);
+      }
+    }
+  }
+}
+
+//--------------------------------------------------------------------+
+// Benchmark
+//--------------------------------------------------------------------+
+
+// Vary the input so nothing can be hoisted out of the loop
+static void bench_report(xinput_report_t *report, uint32_t i)
+{
+  report->bmButtons = (uint16_t)(i * 0x9E37u);
+  report->bLeftTrigger = (uint8_t)i;
+  report->bRightTrigger = (uint8_t)(255 - i);
+  report->wThumbLeftX = (int16_t)(i * 977u);
+  report->wThumbLeftY = (int16_t)(i * 1531u);
+  report->wThumbRightX = (int16_t)(i * 2699u);
+  report->wThumbRightY = (int16_t)(i * 4093u);
+}
+
+// Reports arrive this far apart, so the smoothing filter sees the time steps
+// of a real pad rather than none at all
+#define BENCH_POLL_US (PT_HOST_POLL_INTERVAL_MS ? PT_HOST_POLL_INTERVAL_MS * 1000u : 4000u)
+
+void pipeline_bench(uint32_t iterations, uint32_t *static_cycles, uint32_t *dynamic_cycles)
+{
+  // SysTick is per core, start it on this one if the profiler has not
+  stage_profile_systick_start();
+
+  // Each variant runs on filter state of its own, the report path may be
+  // running on the other core
+  pipeline_state_t static_state = {0}, dynamic_state = {0};
+  pipeline_ctx_t static_ctx = {.tables = settings_tables_peek(), .state = &static_state, .slot = 0, .now_us = 0};
+  pipeline_ctx_t dynamic_ctx = static_ctx;
+  dynamic_ctx.state = &dynamic_state;
+  xinput_report_t report = {0};
+  uint32_t total_static = 0, total_dynamic = 0;
+
+  // Time every report on its own, the 24-bit SysTick wraps after ~70 ms
+  for (uint32_t i = 0; i < iterations; i++)
+  {
+    bench_report(&report, i);
+    static_ctx.now_us += BENCH_POLL_US;
+    uint32_t start = stage_profile_systick();
+    pipeline_run_static(&static_ctx, &report, false);
+    total_static += stage_profile_cycles(start, stage_profile_systick());
+
+    bench_report(&report, i);
+    dynamic_ctx.now_us += BENCH_POLL_US;
+    start = stage_profile_systick();
+    pipeline_run_dynamic(&dynamic_ctx, &report, false);
+    total_dynamic += stage_profile_cycles(start, stage_profile_systick());
+  }
+
+  *static_cycles = iterations ? total_static / iterations : 0;
+  *dynamic_cycles = iterations ? total_dynamic / iterations : 0;
+}
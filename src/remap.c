@@ -0,0 +1,57 @@
+#include <string.h>
+
+#include "remap.h"
+
+void remap_config_identity(remap_config_t *cfg)
+{
+  for (uint8_t i = 0; i < REMAP_BUTTON_COUNT; i++)
+  {
+    cfg->button_src[i] = i;
+  }
+  for (uint8_t i = 0; i < REMAP_STICK_AXES; i++)
+  {
+    cfg->stick_src[i] = i;
+  }
+  cfg->stick_invert = 0;
+  for (uint8_t i = 0; i < REMAP_TRIGGERS; i++)
+  {
+    cfg->trigger_src[i] = i;
+  }
+}
+
+void remap_compile(const remap_config_t *cfg, remap_table_t *table)
+{
+  memset(table->button_lut, 0, sizeof(table->button_lut));
+
+  // Every output bit whose source lands in nibble n contributes to the
+  // entries of button_lut[n] that have that source bit set
+  for (uint8_t out = 0; out < REMAP_BUTTON_COUNT; out++)
+  {
+    uint8_t src = cfg->button_src[out];
+    if (src >= REMAP_BUTTON_COUNT)
+    {
+      continue;
+    }
+
+    uint8_t nibble = src / 4;
+    uint8_t bit = src % 4;
+    for (uint8_t v = 0; v < 16; v++)
+    {
+      if (v & (1u << bit))
+      {
+        table->button_lut[nibble][v] |= (uint16_t)(1u << out);
+      }
+    }
+  }
+
+  for (uint8_t i = 0; i < REMAP_STICK_AXES; i++)
+  {
+    table->stick_src[i] = cfg->stick_src[i] < REMAP_STICK_AXES ? cfg->stick_src[i] : i;
+    table->stick_xor[i] = (cfg->stick_invert & (1u << i)) ? -1 : 0;
+  }
+
+  for (uint8_t i = 0; i < REMAP_TRIGGERS; i++)
+  {
+    table->trigger_src[i] = cfg->trigger_src[i] < REMAP_TRIGGERS ? cfg->trigger_src[i] : i;
+  }
+}
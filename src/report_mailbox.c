@@ -0,0 +1,74 @@
+#include <string.h>
+
+#include "report_mailbox.h"
+#include "latency_stats.h"
+#include "sof_align.h"
+#include "usb_personality.h"
+
+report_mailbox_t report_mailbox[PT_XINPUT_PADS];
+
+void report_mailbox_init(void)
+{
+  memset(report_mailbox, 0, sizeof(report_mailbox));
+  for (uint8_t i = 0; i < PT_XINPUT_PADS; i++)
+  {
+    report_mailbox[i].itf = i;
+  }
+}
+
+void report_mailbox_post(report_mailbox_t *mb, const report_frame_t *frame)
+{
+  // Each endpoint counts its own losses, a busy HID mirror must not count
+  // against a frame the XInput endpoint already sent
+  if (mb->seq != mb->sent_seq)
+  {
+    mb->overwritten++;
+  }
+  if (mb->seq != mb->mirror_seq && usb_personality_active() == USB_PERSONALITY_BOTH)
+  {
+    mb->mirror_overwritten++;
+  }
+  mb->frame = *frame;
+  mb->seq++;
+
+  // With SOF-aligned scheduling the frame waits for the next commit point
+  if (!sof_align_active())
+  {
+    report_mailbox_flush(mb);
+  }
+}
+
+bool report_mailbox_flush(report_mailbox_t *mb)
+{
+  if (!report_mailbox_pending(mb))
+  {
+    return false;
+  }
+
+  // Nobody is listening, there is no point in holding on to the frame
+  if (!tud_ready())
+  {
+    mb->dropped++;
+    mb->sent_seq = mb->seq;
+    mb->mirror_seq = mb->seq;
+    return false;
+  }
+
+  // The HID pads of the combined personality follow on a best-effort basis
+  if (mb->mirror_seq != mb->seq && usb_personality_mirror(mb->itf, &mb->frame.report))
+  {
+    mb->mirror_seq = mb->seq;
+  }
+
+  // Endpoint still busy, keep the frame until the transfer completes
+  if (mb->sent_seq == mb->seq || !usb_personality_report(mb->itf, &mb->frame.report))
+  {
+    return false;
+  }
+
+  mb->sent_seq = mb->seq;
+  mb->sent++;
+  latency_stats_queued(mb->itf, REPORT_FRAME_RX_US(&mb->frame));
+  sof_align_queued(mb->itf, REPORT_FRAME_RX_US(&mb->frame));
+  return true;
+}
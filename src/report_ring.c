@@ -0,0 +1,90 @@
+#include "report_ring.h"
+
+#define RING_MASK (PT_REPORT_RING_SIZE - 1)
+
+report_ring_t report_ring[PT_XINPUT_PADS];
+
+void report_ring_init(report_ring_t *ring)
+{
+  atomic_store_explicit(&ring->head, 0, memory_order_relaxed);
+  atomic_store_explicit(&ring->tail, 0, memory_order_relaxed);
+  ring->dropped = 0;
+  ring->skipped = 0;
+}
+
+bool report_ring_push(report_ring_t *ring, const report_frame_t *frame)
+{
+  unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  unsigned tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+  if (head - tail >= PT_REPORT_RING_SIZE)
+  {
+    ring->dropped++;
+    return false;
+  }
+
+  ring->slots[head & RING_MASK] = *frame;
+
+  // Publish the slot only after its contents are written
+  atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+  return true;
+}
+
+void report_ring_push_latest(report_ring_t *ring, const report_frame_t *frame)
+{
+  unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+  // A full ring loses its oldest frame instead of the newest one. The
+  // consumer skips to head anyway and detects a copy that was overwritten
+  ring->slots[head & RING_MASK] = *frame;
+
+  atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+bool report_ring_pop(report_ring_t *ring, report_frame_t *frame)
+{
+  unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+  if (head == tail)
+  {
+    return false;
+  }
+
+  *frame = ring->slots[tail & RING_MASK];
+
+  // Hand the slot back to the producer only after it has been copied out
+  atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+  return true;
+}
+
+bool report_ring_pop_latest(report_ring_t *ring, report_frame_t *frame)
+{
+  unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+  if (head == tail)
+  {
+    return false;
+  }
+
+  for (;;)
+  {
+    *frame = ring->slots[(head - 1) & RING_MASK];
+
+    // report_ring_push_latest reuses slot head - 1 once it has written
+    // PT_REPORT_RING_SIZE - 1 further frames. Fewer than that since the
+    // first load of head and the copy cannot be torn
+    atomic_thread_fence(memory_order_acquire);
+    unsigned now = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (now - head < PT_REPORT_RING_SIZE - 1)
+    {
+      break;
+    }
+    head = now;
+  }
+  ring->skipped += head - tail - 1;
+
+  atomic_store_explicit(&ring->tail, head, memory_order_release);
+  return true;
+}
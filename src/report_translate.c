@@ -0,0 +1,15 @@
+#include "report_translate.h"
+
+void report_translate(const xinput_gamepad_t *pad, xinput_report_t *report)
+{
+  *report = (xinput_report_t){0};
+  report->bReportID = 0;
+  report->bSize = 0x14;
+  report->bmButtons = pad->wButtons;
+  report->bLeftTrigger = pad->bLeftTrigger;
+  report->bRightTrigger = pad->bRightTrigger;
+  report->wThumbLeftX = pad->sThumbLX;
+  report->wThumbLeftY = pad->sThumbLY;
+  report->wThumbRightX = pad->sThumbRX;
+  report->wThumbRightY = pad->sThumbRY;
+}
@@ -0,0 +1,80 @@
+#include <stdatomic.h>
+
+#include "settings.h"
+#include "config_store.h"
+
+settings_t settings;
+
+// Double-buffered tables. The host core always reads tables[generation & 1]
+// and acknowledges the generation it picked up, the device core only
+// rebuilds the other buffer once the current generation has been
+// acknowledged. Only plain loads and stores are needed on either side.
+static settings_tables_t tables[2];
+static atomic_uint generation;
+static atomic_uint acked;
+static bool dirty;
+
+void settings_init(void)
+{
+  remap_config_identity(&settings.remap);
+  curve_config_default(&settings.curve);
+  stick_filter_config_default(&settings.filter);
+  turbo_config_default(&settings.turbo);
+  settings.personality = PT_USB_PERSONALITY;
+  config_store_load(&settings);
+
+  remap_compile(&settings.remap, &tables[0].remap);
+  curve_compile(&settings.curve, &tables[0].curve);
+  stick_filter_compile(&settings.filter, &tables[0].filter);
+  atomic_store_explicit(&generation, 0, memory_order_relaxed);
+  atomic_store_explicit(&acked, 0, memory_order_relaxed);
+  dirty = false;
+}
+
+void settings_changed(void)
+{
+  dirty = true;
+}
+
+bool settings_task(void)
+{
+  if (!dirty)
+  {
+    return false;
+  }
+
+  // Turbo and the USB personality live on this core and apply straight away
+  turbo_configure(&settings.turbo);
+  usb_personality_select(settings.personality);
+
+  unsigned gen = atomic_load_explicit(&generation, memory_order_relaxed);
+#if PT_DUAL_CORE
+  // The host core may still be reading the buffer we are about to rebuild
+  if (atomic_load_explicit(&acked, memory_order_acquire) != gen)
+  {
+    return true;
+  }
+#endif
+
+  settings_tables_t *next = &tables[(gen + 1) & 1];
+  remap_compile(&settings.remap, &next->remap);
+  curve_compile(&settings.curve, &next->curve);
+  stick_filter_compile(&settings.filter, &next->filter);
+
+  atomic_store_explicit(&generation, gen + 1, memory_order_release);
+  dirty = false;
+  return false;
+}
+
+const settings_tables_t *settings_tables_peek(void)
+{
+  // The device core never rebuilds the published buffer, so no ack needed
+  return &tables[atomic_load_explicit(&generation, memory_order_relaxed) & 1];
+}
+
+const settings_tables_t *settings_tables(void)
+{
+  unsigned gen = atomic_load_explicit(&generation, memory_order_acquire);
+  atomic_store_explicit(&acked, gen, memory_order_release);
+  return &tables[gen & 1];
+}
@@ -0,0 +1,227 @@
+#include "sof_align.h"
+
+sof_align_stats_t sof_align_stats;
+
+#if PT_SOF_ALIGN
+
+#include <string.h>
+
+#include "pico/time.h"
+#include "hardware/timer.h"
+#include "tusb.h"
+
+#include "report_mailbox.h"
+
+#define FRAME_US 1000
+#define PHASE_BUCKET_US 32
+#define PHASE_BUCKETS ((FRAME_US + PHASE_BUCKET_US - 1) / PHASE_BUCKET_US)
+
+static int alarm_num = -1;
+static bool enabled = true;
+
+// Written by the SOF interrupt
+static volatile uint32_t sof_frame;
+static volatile uint32_t sof_us;
+
+// Learned poll schedule, published at the end of every window
+static volatile bool learned;
+static uint16_t phase_us;
+static uint8_t period = 1;
+static volatile uint32_t ref_frame;  // frame of the latest completion
+
+// Set by the alarm, consumed by sof_align_task()
+static volatile bool commit_due;
+static volatile uint32_t commit_target_us;
+
+// Learning state for the current window. The completion callback runs from
+// tud_task(), a little after the transfer finished, and now and then after
+// the next SOF. Taking the most common phase rather than the smallest one
+// keeps those samples from dragging the estimate
+static uint16_t phase_hist[PHASE_BUCKETS];
+static uint32_t last_frame;
+static bool have_last_frame;
+static uint32_t frame_gcd;
+static uint32_t window_count;
+
+// Age of the data the PC read, over the current window
+static bool inflight[PT_XINPUT_PADS];
+static uint32_t inflight_rx_us[PT_XINPUT_PADS];
+static uint32_t inflight_queue_us[PT_XINPUT_PADS];
+static uint32_t age_count, age_min, age_max, wait_max;
+static uint64_t age_total, wait_total;
+
+static uint32_t gcd(uint32_t a, uint32_t b)
+{
+  while (b)
+  {
+    uint32_t t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+static void commit_alarm(uint alarm)
+{
+  (void)alarm;
+  commit_due = true;
+}
+
+void sof_align_init(void)
+{
+  alarm_num = hardware_alarm_claim_unused(true);
+  hardware_alarm_set_callback((uint)alarm_num, commit_alarm);
+  tud_sof_cb_enable(true);
+}
+
+void sof_align_enable(bool enable)
+{
+  enabled = enable;
+}
+
+bool sof_align_active(void)
+{
+  return enabled && learned;
+}
+
+void sof_align_sof(void)
+{
+  uint32_t now = time_us_32();
+  uint32_t frame = sof_frame + 1;
+  sof_us = now;
+  sof_frame = frame;
+
+  if (!sof_align_active())
+  {
+    return;
+  }
+
+  // A phase earlier than the guard is committed at the end of the frame
+  // before the one that is polled
+  uint32_t lead = (phase_us + FRAME_US - PT_SOF_ALIGN_GUARD_US) % FRAME_US;
+  uint32_t polled_frame = frame + (phase_us < PT_SOF_ALIGN_GUARD_US ? 1 : 0);
+  if ((polled_frame - ref_frame) % period != 0)
+  {
+    return;
+  }
+
+  commit_target_us = now + lead;
+  if (hardware_alarm_set_target((uint)alarm_num, delayed_by_us(get_absolute_time(), lead)))
+  {
+    // Already past the target, commit right away
+    sof_align_stats.late++;
+    commit_due = true;
+  }
+}
+
+void sof_align_queued(uint8_t itf, uint32_t rx_us)
+{
+  inflight[itf] = true;
+  inflight_rx_us[itf] = rx_us;
+  inflight_queue_us[itf] = time_us_32();
+}
+
+static void window_done(void)
+{
+  uint8_t best = 0;
+  for (uint8_t i = 1; i < PHASE_BUCKETS; i++)
+  {
+    if (phase_hist[i] > phase_hist[best])
+    {
+      best = i;
+    }
+  }
+  phase_us = best * PHASE_BUCKET_US;
+  period = frame_gcd == 0 ? 1 : frame_gcd > 255 ? 255 : (uint8_t)frame_gcd;
+  learned = true;
+
+  sof_align_stats.phase_us = phase_us;
+  sof_align_stats.period = period;
+  if (age_count)
+  {
+    sof_align_stats.age_min_us = age_min;
+    sof_align_stats.age_avg_us = (uint32_t)(age_total / age_count);
+    sof_align_stats.age_max_us = age_max;
+    sof_align_stats.wait_avg_us = (uint32_t)(wait_total / age_count);
+    sof_align_stats.wait_max_us = wait_max;
+  }
+
+  memset(phase_hist, 0, sizeof(phase_hist));
+  frame_gcd = 0;
+  window_count = 0;
+  age_count = 0;
+  age_total = wait_total = 0;
+  age_max = wait_max = 0;
+}
+
+void sof_align_completed(uint8_t itf)
+{
+  uint32_t now = time_us_32();
+
+  // The SOF interrupt may update both values while they are read
+  uint32_t frame, start;
+  do
+  {
+    frame = sof_frame;
+    start = sof_us;
+  } while (frame != sof_frame);
+
+  phase_hist[((now - start) % FRAME_US) / PHASE_BUCKET_US]++;
+  if (have_last_frame)
+  {
+    frame_gcd = gcd(frame_gcd, frame - last_frame);
+  }
+  last_frame = frame;
+  have_last_frame = true;
+  ref_frame = frame;
+
+  if (itf < PT_XINPUT_PADS && inflight[itf])
+  {
+    inflight[itf] = false;
+    uint32_t age = now - inflight_rx_us[itf];
+    uint32_t wait = now - inflight_queue_us[itf];
+    if (age_count == 0 || age < age_min)
+    {
+      age_min = age;
+    }
+    if (age > age_max)
+    {
+      age_max = age;
+    }
+    if (wait > wait_max)
+    {
+      wait_max = wait;
+    }
+    age_total += age;
+    wait_total += wait;
+    age_count++;
+  }
+
+  if (++window_count >= PT_SOF_ALIGN_WINDOW)
+  {
+    window_done();
+  }
+}
+
+void sof_align_task(void)
+{
+  if (!commit_due)
+  {
+    return;
+  }
+  commit_due = false;
+
+  uint32_t lateness = time_us_32() - commit_target_us;
+  if (lateness > sof_align_stats.max_lateness_us)
+  {
+    sof_align_stats.max_lateness_us = lateness;
+  }
+  sof_align_stats.commits++;
+
+  for (uint8_t i = 0; i < PT_XINPUT_PADS; i++)
+  {
+    report_mailbox_flush(&report_mailbox[i]);
+  }
+}
+
+#endif
@@ -0,0 +1,58 @@
+#include "stage_profile.h"
+
+stage_profile_t stage_profile[PROFILE_STAGE_COUNT];
+
+void stage_profile_systick_start(void)
+{
+  if (systick_hw->csr & 1)
+  {
+    return;
+  }
+  systick_hw->rvr = STAGE_PROFILE_SYSTICK_MASK;
+  systick_hw->cvr = 0;
+  // Enable, processor clock source, no interrupt
+  systick_hw->csr = 0x5;
+}
+
+#if PT_STAGE_PROFILE
+
+// Control transfers read from this buffer after the callback returns
+static stage_profile_t snapshot[PROFILE_STAGE_COUNT];
+
+uint32_t stage_profile_record(uint8_t stage, uint32_t start)
+{
+  uint32_t cycles = stage_profile_cycles(start, stage_profile_now());
+  stage_profile_t *p = &stage_profile[stage];
+
+  if (p->count == 0 || cycles < p->min)
+  {
+    p->min = cycles;
+  }
+  if (cycles > p->max)
+  {
+    p->max = cycles;
+  }
+  p->total += cycles;
+  p->count++;
+
+  // Skip the bookkeeping above when timing the next stage
+  return stage_profile_now();
+}
+
+bool stage_profile_control_xfer(uint8_t rhport, tusb_control_request_t const *request)
+{
+  if (request->bRequest != PT_VENDOR_REQUEST_PROFILE)
+  {
+    return false;
+  }
+
+  // The host core updates the counters concurrently, a torn read only skews
+  // a single sample
+  for (uint8_t i = 0; i < PROFILE_STAGE_COUNT; i++)
+  {
+    snapshot[i] = stage_profile[i];
+  }
+  return tud_control_xfer(rhport, request, snapshot, sizeof(snapshot));
+}
+
+#endif
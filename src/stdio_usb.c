@@ -17,6 +17,7 @@
 #include "pico/mutex.h"
 #include "hardware/irq.h"
 #include "device/usbd_pvt.h" // for usbd_defer_func
+#include <stdatomic.h>
 
 static mutex_t stdio_usb_mutex;
 
@@ -96,6 +97,110 @@ static void usb_irq(void) {
 
 #endif
 
+#if PICO_STDIO_USB_OUT_RING_SIZE
+static_assert((PICO_STDIO_USB_OUT_RING_SIZE & (PICO_STDIO_USB_OUT_RING_SIZE - 1)) == 0,
+              "PICO_STDIO_USB_OUT_RING_SIZE must be a power of two");
+#define OUT_RING_MASK (PICO_STDIO_USB_OUT_RING_SIZE - 1)
+
+// Output is written into this ring in constant time and drained by stdio_usb_task(), so printf
+// can never stall the caller waiting for the CDC host. pico_stdio already serializes writers with
+// its print mutex, so there is exactly one producer (whoever holds that mutex) and one consumer
+// (the core running tud_task).
+static char out_ring[PICO_STDIO_USB_OUT_RING_SIZE];
+static atomic_uint out_reserved;    // producer: end of the bytes being written
+static atomic_uint out_head;        // producer: end of the bytes ready to send
+static atomic_uint out_tail;        // consumer: next byte to send
+static uint32_t out_written;
+static uint32_t out_sent;
+static uint32_t out_dropped_newest; // producer owned
+static uint32_t out_dropped_oldest; // consumer owned
+
+static void stdio_usb_out_chars(const char *buf, int length) {
+    uint32_t n = (uint32_t) length;
+    uint32_t head = atomic_load_explicit(&out_head, memory_order_relaxed);
+#if PICO_STDIO_USB_OUT_RING_DROP_OLDEST
+    // keep only the newest bytes if the string is longer than the whole ring
+    if (n > PICO_STDIO_USB_OUT_RING_SIZE) {
+        buf += n - PICO_STDIO_USB_OUT_RING_SIZE;
+        out_dropped_newest += n - PICO_STDIO_USB_OUT_RING_SIZE;
+        n = PICO_STDIO_USB_OUT_RING_SIZE;
+    }
+    // announce which bytes are about to be overwritten before touching them
+    atomic_store_explicit(&out_reserved, head + n, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+#else
+    uint32_t tail = atomic_load_explicit(&out_tail, memory_order_acquire);
+    uint32_t space = PICO_STDIO_USB_OUT_RING_SIZE - (head - tail);
+    if (n > space) {
+        out_dropped_newest += n - space;
+        n = space;
+    }
+#endif
+    for (uint32_t i = 0; i < n; i++) {
+        out_ring[(head + i) & OUT_RING_MASK] = buf[i];
+    }
+    out_written += n;
+    atomic_store_explicit(&out_head, head + n, memory_order_release);
+}
+
+void stdio_usb_task(void) {
+    if (!stdio_usb_connected()) {
+        // nobody is listening, throw away what is buffered
+        atomic_store_explicit(&out_tail, atomic_load_explicit(&out_head, memory_order_acquire),
+                              memory_order_release);
+        return;
+    }
+
+    for (;;) {
+        uint32_t head = atomic_load_explicit(&out_head, memory_order_acquire);
+        uint32_t tail = atomic_load_explicit(&out_tail, memory_order_relaxed);
+        uint32_t avail = tud_cdc_write_available();
+#if PICO_STDIO_USB_OUT_RING_DROP_OLDEST
+        if (head - tail > PICO_STDIO_USB_OUT_RING_SIZE) {
+            out_dropped_oldest += head - tail - PICO_STDIO_USB_OUT_RING_SIZE;
+            tail = head - PICO_STDIO_USB_OUT_RING_SIZE;
+        }
+#endif
+        uint32_t n = head - tail;
+        if (!n || !avail) break;
+
+        // copy through a bounce buffer so a chunk the producer overwrote meanwhile can be discarded
+        char chunk[CFG_TUD_CDC_EP_BUFSIZE];
+        if (n > avail) n = avail;
+        if (n > sizeof(chunk)) n = sizeof(chunk);
+        for (uint32_t i = 0; i < n; i++) {
+            chunk[i] = out_ring[(tail + i) & OUT_RING_MASK];
+        }
+        uint32_t skip = 0;
+#if PICO_STDIO_USB_OUT_RING_DROP_OLDEST
+        atomic_thread_fence(memory_order_acquire);
+        uint32_t reserved = atomic_load_explicit(&out_reserved, memory_order_relaxed);
+        if (reserved - tail > PICO_STDIO_USB_OUT_RING_SIZE) {
+            skip = reserved - tail - PICO_STDIO_USB_OUT_RING_SIZE;
+            if (skip > n) skip = n;
+            out_dropped_oldest += skip;
+        }
+#endif
+        if (n > skip) {
+            tud_cdc_write(chunk + skip, n - skip);
+            out_sent += n - skip;
+        }
+        atomic_store_explicit(&out_tail, tail + n, memory_order_release);
+    }
+    tud_cdc_write_flush();
+}
+
+void stdio_usb_get_out_stats(stdio_usb_out_stats_t *stats) {
+    stats->written = out_written;
+    stats->sent = out_sent;
+    stats->dropped = out_dropped_newest + out_dropped_oldest;
+}
+
+static void stdio_usb_out_flush(void) {
+    // nothing to do, flushing must not block and stdio_usb_task() is the only consumer of the ring
+}
+
+#else
 static void stdio_usb_out_chars(const char *buf, int length) {
     static uint64_t last_avail_time;
     if (!mutex_try_enter_block_until(&stdio_usb_mutex, make_timeout_time_ms(PICO_STDIO_DEADLOCK_TIMEOUT_MS))) {
@@ -137,6 +242,7 @@ static void stdio_usb_out_flush(void) {
     } while (tud_cdc_write_flush());
     mutex_exit(&stdio_usb_mutex);
 }
+#endif // PICO_STDIO_USB_OUT_RING_SIZE
 
 int stdio_usb_in_chars(char *buf, int length) {
     // note we perform this check outside the lock, to try and prevent possible deadlock conditions
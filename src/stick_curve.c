@@ -0,0 +1,159 @@
+#include "stick_curve.h"
+
+// Shape a normalised Q15 input u in [0, 32768] with a blend between linear
+// and cubic. Only used while compiling tables, so 64-bit math is fine here
+static uint32_t shape_q15(uint32_t u, uint8_t curve)
+{
+  uint32_t cubic = (uint32_t)(((uint64_t)u * u * u) >> 30);
+  int32_t blend = (int32_t)u + (((int32_t)cubic - (int32_t)u) * (int32_t)curve) / 100;
+  return (uint32_t)blend;
+}
+
+// Output magnitude for input magnitude m, everything on a 0..full scale
+static uint32_t response(uint32_t m, uint32_t full, uint32_t deadzone, uint32_t anti, uint32_t outer, uint8_t curve)
+{
+  if (outer > full || outer <= deadzone)
+  {
+    outer = full;
+  }
+  if (m <= deadzone)
+  {
+    return 0;
+  }
+  if (m >= outer)
+  {
+    return full;
+  }
+
+  uint32_t u = ((m - deadzone) << 15) / (outer - deadzone);
+  uint32_t shaped = shape_q15(u, curve);
+  return anti + ((shaped * (full - anti) + (1u << 14)) >> 15);
+}
+
+void curve_config_default(curve_config_t *cfg)
+{
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    cfg->stick[i] = (curve_stick_config_t){.deadzone = 0, .anti_deadzone = 0, .outer = 32767, .curve = 0};
+    cfg->trigger[i] = (curve_trigger_config_t){.deadzone = 0, .anti_deadzone = 0, .outer = 255, .curve = 0};
+  }
+}
+
+void curve_compile(const curve_config_t *cfg, curve_table_t *table)
+{
+  table->identity = true;
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    curve_stick_config_t const *sc = &cfg->stick[i];
+    curve_trigger_config_t const *tc = &cfg->trigger[i];
+    if (sc->deadzone || sc->anti_deadzone || sc->outer < 32767 || sc->curve ||
+        tc->deadzone || tc->anti_deadzone || tc->outer < 255 || tc->curve)
+    {
+      table->identity = false;
+    }
+  }
+
+  for (uint8_t s = 0; s < 2; s++)
+  {
+    curve_stick_config_t const *c = &cfg->stick[s];
+    for (uint32_t i = 0; i <= CURVE_STICK_LUT_SIZE; i++)
+    {
+      uint32_t m = i << CURVE_STICK_LUT_SHIFT;
+      if (m > 32767)
+      {
+        m = 32767;
+      }
+      table->stick[s][i] = (uint16_t)response(m, 32767, c->deadzone, c->anti_deadzone, c->outer, c->curve);
+    }
+  }
+
+  for (uint8_t t = 0; t < 2; t++)
+  {
+    curve_trigger_config_t const *c = &cfg->trigger[t];
+    for (uint32_t v = 0; v < 256; v++)
+    {
+      table->trigger[t][v] = (uint8_t)response(v, 255, c->deadzone, c->anti_deadzone, c->outer, c->curve);
+    }
+  }
+}
+
+static uint32_t isqrt32(uint32_t v)
+{
+  uint32_t root = 0;
+  uint32_t bit = 1u << 30;
+  while (bit > v)
+  {
+    bit >>= 2;
+  }
+  while (bit)
+  {
+    if (v >= root + bit)
+    {
+      v -= root + bit;
+      root = (root >> 1) + bit;
+    }
+    else
+    {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return root;
+}
+
+static void stick_apply(uint16_t const *lut, int16_t *x, int16_t *y)
+{
+  int32_t ix = *x;
+  int32_t iy = *y;
+  uint32_t mag = isqrt32((uint32_t)(ix * ix) + (uint32_t)(iy * iy));
+  if (mag == 0)
+  {
+    return;
+  }
+
+  int32_t out;
+  if (mag < 32767)
+  {
+    uint32_t idx = mag >> CURVE_STICK_LUT_SHIFT;
+    uint32_t frac = mag & ((1u << CURVE_STICK_LUT_SHIFT) - 1);
+    int32_t lo = lut[idx];
+    int32_t hi = lut[idx + 1];
+    out = lo + (((hi - lo) * (int32_t)frac) >> CURVE_STICK_LUT_SHIFT);
+  }
+  else
+  {
+    // Diagonals of a square gate reach past the single-axis range. Keep the
+    // excess so corners are not pulled in, the per-axis clamp below bounds it
+    out = lut[CURVE_STICK_LUT_SIZE] + (int32_t)(mag - 32767);
+  }
+
+  // Scale both axes by out / mag so the direction is preserved.
+  // |axis| * out stays below 2^31, and the RP2040 divides in hardware
+  ix = ix * out / (int32_t)mag;
+  iy = iy * out / (int32_t)mag;
+  *x = (int16_t)(ix > 32767 ? 32767 : (ix < -32768 ? -32768 : ix));
+  *y = (int16_t)(iy > 32767 ? 32767 : (iy < -32768 ? -32768 : iy));
+}
+
+void curve_apply(const curve_table_t *table, xinput_report_t *report)
+{
+  // Interpolation and rounding would otherwise nudge raw values by one count
+  if (table->identity)
+  {
+    return;
+  }
+
+  int16_t lx = report->wThumbLeftX, ly = report->wThumbLeftY;
+  int16_t rx = report->wThumbRightX, ry = report->wThumbRightY;
+
+  stick_apply(table->stick[0], &lx, &ly);
+  stick_apply(table->stick[1], &rx, &ry);
+
+  report->wThumbLeftX = lx;
+  report->wThumbLeftY = ly;
+  report->wThumbRightX = rx;
+  report->wThumbRightY = ry;
+
+  report->bLeftTrigger = table->trigger[0][report->bLeftTrigger];
+  report->bRightTrigger = table->trigger[1][report->bRightTrigger];
+}
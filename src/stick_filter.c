@@ -0,0 +1,112 @@
+#include "stick_filter.h"
+
+// tau / dt = FILTER_TAU_K / (cutoff * dt) with the cutoff in 0.1 Hz and dt
+// in microseconds, FILTER_TAU_K = 1e7 / (2 pi)
+#define FILTER_TAU_K 1591549u
+
+// A longer gap between two reports restarts the filter
+#define FILTER_DT_MAX_US 100000u
+
+// 1 kHz, the filter is transparent well before that
+#define FILTER_CUTOFF_MAX 10000u
+
+// Counts per microsecond -> 1/1024 full range (32768 counts) per second
+#define FILTER_SPEED_SCALE 31250
+
+// Keeps beta * speed within 32 bits
+#define FILTER_SPEED_MAX 0xFFFFFFu
+
+void stick_filter_config_default(stick_filter_config_t *cfg)
+{
+  cfg->axes = 0;
+  cfg->beta = 255;
+  cfg->min_cutoff = 150;
+  cfg->d_cutoff = 200;
+}
+
+void stick_filter_compile(const stick_filter_config_t *cfg, stick_filter_table_t *table)
+{
+  table->axes = cfg->axes & ((1u << STICK_FILTER_AXES) - 1);
+  table->beta = cfg->beta;
+  table->min_cutoff = cfg->min_cutoff == 0 ? 1 : cfg->min_cutoff > FILTER_CUTOFF_MAX ? FILTER_CUTOFF_MAX : cfg->min_cutoff;
+  table->d_cutoff = cfg->d_cutoff == 0 ? 1 : cfg->d_cutoff > FILTER_CUTOFF_MAX ? FILTER_CUTOFF_MAX : cfg->d_cutoff;
+}
+
+// alpha = 1 / (1 + tau / dt) in Q16. Both terms are scaled down to 16 bits
+// so a single 32-bit division (the hardware divider on the RP2040) does it
+static uint32_t smoothing_factor(uint32_t cutoff, uint32_t dt_us)
+{
+  uint32_t r = cutoff * dt_us;
+  uint32_t d = r + FILTER_TAU_K;
+  while (d > 0xFFFF)
+  {
+    d >>= 1;
+    r >>= 1;
+  }
+  return (r << 16) / d;
+}
+
+static inline int32_t low_pass(int32_t y, int32_t x, uint32_t alpha)
+{
+  return y + (int32_t)(((int64_t)(x - y) * alpha) >> 16);
+}
+
+void stick_filter_apply(const stick_filter_table_t *table, stick_filter_state_t *state,
+                        int16_t axes[STICK_FILTER_AXES], uint32_t now_us)
+{
+  if (!table->axes)
+  {
+    state->primed = false;
+    return;
+  }
+
+  uint32_t dt = now_us - state->last_us;
+  state->last_us = now_us;
+  if (!state->primed || state->axes != table->axes || dt > FILTER_DT_MAX_US)
+  {
+    for (uint8_t i = 0; i < STICK_FILTER_AXES; i++)
+    {
+      state->axis[i].x = (int32_t)axes[i] * 256;
+      state->axis[i].dx = 0;
+    }
+    state->axes = table->axes;
+    state->primed = true;
+    return;
+  }
+  if (dt == 0)
+  {
+    dt = 1;
+  }
+
+  // The speed estimate has a fixed cutoff, its factor is shared by all axes
+  uint32_t alpha_d = smoothing_factor(table->d_cutoff, dt);
+
+  for (uint8_t i = 0; i < STICK_FILTER_AXES; i++)
+  {
+    if (!(table->axes & (1u << i)))
+    {
+      continue;
+    }
+
+    stick_filter_axis_t *a = &state->axis[i];
+    int32_t x = (int32_t)axes[i] * 256;
+
+    // Speed against the previous filtered position, at most 65535 * 31250
+    int32_t speed = (x - a->x) / 256 * FILTER_SPEED_SCALE / (int32_t)dt;
+    a->dx = low_pass(a->dx, speed, alpha_d);
+
+    uint32_t mag = (uint32_t)(a->dx < 0 ? -a->dx : a->dx);
+    if (mag > FILTER_SPEED_MAX)
+    {
+      mag = FILTER_SPEED_MAX;
+    }
+    uint32_t cutoff = table->min_cutoff + ((table->beta * mag) >> 10);
+    if (cutoff > FILTER_CUTOFF_MAX)
+    {
+      cutoff = FILTER_CUTOFF_MAX;
+    }
+
+    a->x = low_pass(a->x, x, smoothing_factor(cutoff, dt));
+    axes[i] = (int16_t)((a->x + 128) >> 8);
+  }
+}
@@ -0,0 +1,103 @@
+#include "telemetry.h"
+
+#if PT_TELEMETRY
+
+#include "tusb.h"
+#include "pico/time.h"
+#include "stdio_usb.h"
+
+#include "delta_filter.h"
+#include "host_poll.h"
+#include "output_relay.h"
+#include "report_mailbox.h"
+#include "report_ring.h"
+
+#define TELEMETRY_CDC_ITF 1
+
+uint32_t telemetry_dropped;
+
+static uint16_t seq;
+static uint32_t last_counters_ms;
+
+static void emit(telemetry_frame_t *frame, uint8_t type, uint8_t slot)
+{
+  frame->sync[0] = TELEMETRY_SYNC0;
+  frame->sync[1] = TELEMETRY_SYNC1;
+  frame->type = type;
+  frame->slot = slot;
+  frame->seq = seq++;
+  frame->crc = telemetry_crc16((uint8_t const *)frame, TELEMETRY_FRAME_SIZE - 2);
+
+  // Whole frames only, a partial one would desync the decoder
+  if (tud_cdc_n_write_available(TELEMETRY_CDC_ITF) < TELEMETRY_FRAME_SIZE)
+  {
+    telemetry_dropped++;
+    return;
+  }
+  tud_cdc_n_write(TELEMETRY_CDC_ITF, frame, TELEMETRY_FRAME_SIZE);
+}
+
+void telemetry_sample(const report_frame_t *frame, uint32_t forward_us)
+{
+  if (!tud_cdc_n_connected(TELEMETRY_CDC_ITF))
+  {
+    return;
+  }
+
+  xinput_report_t const *r = &frame->report;
+  telemetry_frame_t out = {0};
+  out.payload.sample.rx_us = frame->rx_us;
+  out.payload.sample.forward_us = forward_us;
+  out.payload.sample.raw = frame->raw;
+  out.payload.sample.out = (telemetry_pad_t){
+      .buttons = r->bmButtons,
+      .left_trigger = r->bLeftTrigger,
+      .right_trigger = r->bRightTrigger,
+      .thumb_lx = r->wThumbLeftX,
+      .thumb_ly = r->wThumbLeftY,
+      .thumb_rx = r->wThumbRightX,
+      .thumb_ry = r->wThumbRightY,
+  };
+  emit(&out, TELEMETRY_TYPE_SAMPLE, frame->slot);
+}
+
+void telemetry_task(void)
+{
+  if (!tud_cdc_n_connected(TELEMETRY_CDC_ITF))
+  {
+    return;
+  }
+
+  uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+  if (now_ms - last_counters_ms >= PT_TELEMETRY_COUNTERS_MS)
+  {
+    last_counters_ms = now_ms;
+
+    for (uint8_t slot = 0; slot < PT_XINPUT_PADS; slot++)
+    {
+      telemetry_frame_t out = {0};
+      telemetry_counters_t *c = &out.payload.counters;
+      c->now_us = time_us_32();
+      c->ring_dropped = report_ring[slot].dropped;
+      c->ring_skipped = report_ring[slot].skipped;
+      c->mailbox_sent = report_mailbox[slot].sent;
+      c->mailbox_overwritten = report_mailbox[slot].overwritten;
+      c->mailbox_dropped = report_mailbox[slot].dropped;
+      c->delta_suppressed = delta_filter[slot].suppressed;
+      c->relay_coalesced = output_relay[slot].coalesced;
+#if PICO_STDIO_USB_OUT_RING_SIZE
+      stdio_usb_out_stats_t stdio_stats;
+      stdio_usb_get_out_stats(&stdio_stats);
+      c->stdio_dropped = stdio_stats.dropped;
+#endif
+      c->telemetry_dropped = telemetry_dropped;
+      c->poll_rate_hz = host_poll_stats[slot].rate_hz;
+      c->poll_failed = host_poll_stats[slot].failed;
+      emit(&out, TELEMETRY_TYPE_COUNTERS, slot);
+    }
+  }
+
+  tud_cdc_n_write_flush(TELEMETRY_CDC_ITF);
+}
+
+#endif
@@ -0,0 +1,187 @@
+#include <string.h>
+
+#include "turbo.h"
+
+turbo_stats_t turbo_stats;
+
+void turbo_config_default(turbo_config_t *cfg)
+{
+  memset(cfg, 0, sizeof(*cfg));
+}
+
+#if PT_TURBO
+
+#include "pico/time.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+
+#include "event_loop.h"
+#include "settings.h"
+
+static int alarm_num = -1;
+static bool running;
+static absolute_time_t next_tick;
+
+// Shared with the alarm IRQ, which runs on this core. The device core only
+// changes them with interrupts disabled
+static uint32_t step[TURBO_BUTTON_COUNT];
+static uint32_t phase[TURBO_BUTTON_COUNT];
+static volatile uint16_t rate_mask;  // buttons that have a rate
+static volatile uint16_t off_mask;   // buttons in their off phase
+static volatile uint16_t held_any;   // turbo buttons held on any pad
+static volatile uint32_t toggle_us;  // last toggle of a held button
+
+// Device core, per pad
+static report_frame_t last[PT_XINPUT_PADS];
+static uint16_t held[PT_XINPUT_PADS];
+static uint16_t posted_off[PT_XINPUT_PADS];  // off_mask the last post was gated with
+
+static void schedule_next(void)
+{
+  // Drop ticks that are already due, the phases only advance on served ticks
+  next_tick = delayed_by_us(next_tick, PT_TURBO_TICK_US);
+  while (hardware_alarm_set_target((uint)alarm_num, next_tick))
+  {
+    turbo_stats.missed++;
+    next_tick = delayed_by_us(next_tick, PT_TURBO_TICK_US);
+  }
+}
+
+static void tick_alarm(uint alarm)
+{
+  (void)alarm;
+  uint32_t now = time_us_32();
+  uint32_t late = now - (uint32_t)to_us_since_boot(next_tick);
+  turbo_stats.ticks++;
+  if (late > turbo_stats.tick_late_max_us)
+  {
+    turbo_stats.tick_late_max_us = late;
+  }
+
+  uint16_t off = 0;
+  uint16_t mask = rate_mask;
+  for (uint8_t i = 0; mask; i++, mask >>= 1)
+  {
+    if (mask & 1)
+    {
+      phase[i] += step[i];
+      off |= (uint16_t)((phase[i] >> 31) << i);
+    }
+  }
+
+  uint16_t toggled = off ^ off_mask;
+  off_mask = off;
+  if (toggled & held_any)
+  {
+    toggle_us = now;
+    event_loop_signal(EVENT_TICK);
+  }
+
+  schedule_next();
+}
+
+void turbo_init(void)
+{
+  alarm_num = hardware_alarm_claim_unused(true);
+  hardware_alarm_set_callback((uint)alarm_num, tick_alarm);
+  turbo_configure(&settings.turbo);
+}
+
+void turbo_configure(const turbo_config_t *cfg)
+{
+  uint32_t steps[TURBO_BUTTON_COUNT];
+  uint16_t mask = 0;
+  for (uint8_t i = 0; i < TURBO_BUTTON_COUNT; i++)
+  {
+    uint32_t rate = cfg->rate[i] > TURBO_RATE_MAX ? TURBO_RATE_MAX : cfg->rate[i];
+
+    // One full turn of the accumulator is one press and release
+    steps[i] = (uint32_t)(((uint64_t)rate * PT_TURBO_TICK_US << 32) / 1000000u);
+    mask |= (uint16_t)((rate ? 1u : 0u) << i);
+  }
+
+  uint32_t irq = save_and_disable_interrupts();
+  memcpy(step, steps, sizeof(step));
+  rate_mask = mask;
+  off_mask &= mask;
+  restore_interrupts(irq);
+
+  if (mask && !running)
+  {
+    running = true;
+    next_tick = get_absolute_time();
+    schedule_next();
+  }
+  else if (!mask && running)
+  {
+    running = false;
+    hardware_alarm_cancel((uint)alarm_num);
+  }
+}
+
+void turbo_apply(report_frame_t *frame)
+{
+  uint8_t slot = frame->slot;
+  if (slot >= PT_XINPUT_PADS)
+  {
+    return;
+  }
+
+  uint16_t buttons = frame->report.bmButtons;
+  uint16_t turbo = buttons & rate_mask;
+  uint16_t pressed = turbo & ~held[slot];
+  if (pressed)
+  {
+    // A fresh press starts in its on phase
+    uint32_t irq = save_and_disable_interrupts();
+    for (uint8_t i = 0; i < TURBO_BUTTON_COUNT; i++)
+    {
+      if (pressed & (1u << i))
+      {
+        phase[i] = 0;
+      }
+    }
+    off_mask &= (uint16_t)~pressed;
+    restore_interrupts(irq);
+  }
+
+  held[slot] = turbo;
+  uint16_t any = 0;
+  for (uint8_t i = 0; i < PT_XINPUT_PADS; i++)
+  {
+    any |= held[i];
+  }
+  held_any = any;
+
+  last[slot] = *frame;
+  uint16_t off = off_mask;
+  posted_off[slot] = off;
+  frame->report.bmButtons = buttons & (uint16_t)~(off & turbo);
+}
+
+bool turbo_inject(uint8_t slot, report_frame_t *frame)
+{
+  if (slot >= PT_XINPUT_PADS || !((off_mask ^ posted_off[slot]) & held[slot]))
+  {
+    return false;
+  }
+
+  *frame = last[slot];
+  report_frame_stamp(frame);
+
+  uint32_t delay = time_us_32() - toggle_us;
+  turbo_stats_t *s = &turbo_stats;
+  if (s->injected == 0 || delay < s->toggle_min_us)
+  {
+    s->toggle_min_us = delay;
+  }
+  if (delay > s->toggle_max_us)
+  {
+    s->toggle_max_us = delay;
+  }
+  s->toggle_total_us += delay;
+  s->injected++;
+  return true;
+}
+
+#endif
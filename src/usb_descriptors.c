@@ -4,61 +4,121 @@
 #include "xinput_device.h"
 #include "device/usbd.h"
 #include "common/tusb_common.h"
+#include "passthrough_config.h"
+#include "latency_stats.h"
+#include "stage_profile.h"
+#include "usb_personality.h"
+#include "usb_strings.h"
+#include "usb_descriptors.h"
+#include "ms_os_desc.h"
 /* A combination of interfaces must have a unique product id, since PC will save device driver after the first plug. */
-/* This is a composite device with 2x CDC and 1x XInput. */
+/* This is a composite device with 2x CDC and 1 to 4 pads, as XInput, HID gamepad or both. */
 
 #define USB_VID 0x045E
-#define USB_PID 0x123 // 2x CDC + 1x Vendor/XInput
+#define USB_PID_XINPUT (0x123 + PT_XINPUT_PADS - 1) // 2x CDC + PT_XINPUT_PADS x Vendor/XInput
+#define USB_PID_HID (0x127 + PT_XINPUT_PADS - 1)    // 2x CDC + PT_XINPUT_PADS x HID
+#define USB_PID_BOTH (0x12B + PT_XINPUT_PADS - 1)   // 2x CDC + PT_XINPUT_PADS x (Vendor/XInput + HID)
 #define USB_BCD 0x0200
+#define USB_BCD_USB 0x0210 // 2.1, so Windows reads the BOS
 
 //--------------------------------------------------------------------+
 // Device Descriptors
 //--------------------------------------------------------------------+
-tusb_desc_device_t const desc_device = {
-    .bLength = sizeof(tusb_desc_device_t),
-    .bDescriptorType = TUSB_DESC_DEVICE,
-    .bcdUSB = USB_BCD,
-
-    // This is a composite device. Class and subclass codes are set to 0
-    // as required by the USB specification for devices with multiple interfaces.
-    .bDeviceClass = TUSB_CLASS_UNSPECIFIED,
-    .bDeviceSubClass = TUSB_CLASS_UNSPECIFIED,
-    .bDeviceProtocol = 0x0,
-    .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,
-
-    .idVendor = USB_VID,
-    .idProduct = USB_PID,
-    .bcdDevice = USB_BCD,
-
-    .iManufacturer = 0x01,
-    .iProduct = 0x02,
-    .iSerialNumber = 0x03,
+#define DEVICE_DESCRIPTOR(_pid)                                                        \
+  {                                                                                    \
+    .bLength = sizeof(tusb_desc_device_t),                                             \
+    .bDescriptorType = TUSB_DESC_DEVICE,                                               \
+    .bcdUSB = USB_BCD_USB,                                                             \
+                                                                                       \
+    /* This is a composite device. Class and subclass codes are set to 0 */            \
+    /* as required by the USB specification for devices with multiple interfaces. */   \
+    .bDeviceClass = TUSB_CLASS_UNSPECIFIED,                                            \
+    .bDeviceSubClass = TUSB_CLASS_UNSPECIFIED,                                         \
+    .bDeviceProtocol = 0x0,                                                            \
+    .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,                                         \
+                                                                                       \
+    .idVendor = USB_VID,                                                               \
+    .idProduct = (_pid),                                                               \
+    .bcdDevice = USB_BCD,                                                              \
+                                                                                       \
+    .iManufacturer = 0x01,                                                             \
+    .iProduct = 0x02,                                                                  \
+    .iSerialNumber = 0x03,                                                             \
+                                                                                       \
+    .bNumConfigurations = 0x01                                                         \
+  }
 
-    .bNumConfigurations = 0x01};
+// One per personality, see usb_personality.h
+static tusb_desc_device_t const desc_device[USB_PERSONALITY_COUNT] = {
+    [USB_PERSONALITY_XINPUT] = DEVICE_DESCRIPTOR(USB_PID_XINPUT),
+    [USB_PERSONALITY_HID] = DEVICE_DESCRIPTOR(USB_PID_HID),
+    [USB_PERSONALITY_BOTH] = DEVICE_DESCRIPTOR(USB_PID_BOTH),
+};
 
 // Invoked when received GET DEVICE DESCRIPTOR
 // Application return pointer to descriptor
 uint8_t const *tud_descriptor_device_cb(void)
 {
-  return (uint8_t const *)&desc_device;
+  return (uint8_t const *)&desc_device[usb_personality_active()];
 }
 
 //--------------------------------------------------------------------+
-// Configuration Descriptor
+// HID Report Descriptor
 //--------------------------------------------------------------------+
 
-enum
-{
-  ITF_NUM_CDC_0 = 0,  // Interface 0 (CDC0 Comm)
-  ITF_NUM_CDC_0_DATA, // Interface 1 (CDC0 Data)
-  ITF_NUM_CDC_1,      // Interface 2 (CDC1 Comm)
-  ITF_NUM_CDC_1_DATA, // Interface 3 (CDC1 Data)
-  ITF_NUM_XINPUT,
-  ITF_NUM_TOTAL,
+// Describes the bytes of xinput_report_t from bmButtons to wThumbRightY
+static uint8_t const desc_hid_report[] = {
+    HID_USAGE_PAGE(HID_USAGE_PAGE_DESKTOP),
+    HID_USAGE(HID_USAGE_DESKTOP_GAMEPAD),
+    HID_COLLECTION(HID_COLLECTION_APPLICATION),
+        // bmButtons
+        HID_USAGE_PAGE(HID_USAGE_PAGE_BUTTON),
+        HID_USAGE_MIN(1),
+        HID_USAGE_MAX(16),
+        HID_LOGICAL_MIN(0),
+        HID_LOGICAL_MAX(1),
+        HID_REPORT_COUNT(16),
+        HID_REPORT_SIZE(1),
+        HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+        // bLeftTrigger, bRightTrigger
+        HID_USAGE_PAGE(HID_USAGE_PAGE_DESKTOP),
+        HID_USAGE(HID_USAGE_DESKTOP_RX),
+        HID_USAGE(HID_USAGE_DESKTOP_RY),
+        HID_LOGICAL_MIN(0),
+        HID_LOGICAL_MAX_N(255, 2),
+        HID_REPORT_COUNT(2),
+        HID_REPORT_SIZE(8),
+        HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+        // wThumbLeftX/Y, wThumbRightX/Y
+        HID_USAGE(HID_USAGE_DESKTOP_X),
+        HID_USAGE(HID_USAGE_DESKTOP_Y),
+        HID_USAGE(HID_USAGE_DESKTOP_Z),
+        HID_USAGE(HID_USAGE_DESKTOP_RZ),
+        HID_LOGICAL_MIN_N(-32768, 2),
+        HID_LOGICAL_MAX_N(32767, 2),
+        HID_REPORT_COUNT(4),
+        HID_REPORT_SIZE(16),
+        HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+    HID_COLLECTION_END,
 };
 
-// total length of configuration descriptor
-#define CONFIG_TOTAL_LEN (TUD_CONFIG_DESC_LEN + CFG_TUD_CDC * TUD_CDC_DESC_LEN + TUD_XINPUT_DESC_LEN)
+// Invoked when received GET HID REPORT DESCRIPTOR
+// Every HID pad has the same layout
+uint8_t const *tud_hid_descriptor_report_cb(uint8_t instance)
+{
+  (void)instance;
+  return desc_hid_report;
+}
+
+//--------------------------------------------------------------------+
+// Configuration Descriptor
+//--------------------------------------------------------------------+
+
+// total length of the configuration descriptors
+#define CONFIG_BASE_LEN (TUD_CONFIG_DESC_LEN + CFG_TUD_CDC * TUD_CDC_DESC_LEN)
+#define CONFIG_XINPUT_LEN (CONFIG_BASE_LEN + PT_XINPUT_PADS * TUD_XINPUT_DESC_LEN)
+#define CONFIG_HID_LEN (CONFIG_BASE_LEN + PT_XINPUT_PADS * TUD_HID_DESC_LEN)
+#define CONFIG_BOTH_LEN (CONFIG_BASE_LEN + PT_XINPUT_PADS * (TUD_XINPUT_DESC_LEN + TUD_HID_DESC_LEN))
 
 // define endpoint numbers
 #define EPNUM_CDC_0_NOTIF 0x81 // notification endpoint for CDC 0
@@ -69,156 +129,147 @@ enum
 #define EPNUM_CDC_1_OUT 0x05   // out endpoint for CDC 1
 #define EPNUM_CDC_1_IN 0x85    // in endpoint for CDC 1
 
-#define EPNUM_XINPUT_OUT 0x02 // out endpoint for XINPUT
-#define EPNUM_XINPUT_IN 0x82  // in endpoint for XINPUT
+#define EPNUM_XINPUT_0_OUT 0x02 // out endpoint for XINPUT pad 0
+#define EPNUM_XINPUT_0_IN 0x82  // in endpoint for XINPUT pad 0
+
+#define EPNUM_XINPUT_1_OUT 0x03 // out endpoint for XINPUT pad 1
+#define EPNUM_XINPUT_1_IN 0x83  // in endpoint for XINPUT pad 1
+
+#define EPNUM_XINPUT_2_OUT 0x06 // out endpoint for XINPUT pad 2
+#define EPNUM_XINPUT_2_IN 0x86  // in endpoint for XINPUT pad 2
+
+#define EPNUM_XINPUT_3_OUT 0x07 // out endpoint for XINPUT pad 3
+#define EPNUM_XINPUT_3_IN 0x87  // in endpoint for XINPUT pad 3
+
+#define EPNUM_HID_0_IN 0x89 // in endpoint for HID gamepad 0
+#define EPNUM_HID_1_IN 0x8A // in endpoint for HID gamepad 1
+#define EPNUM_HID_2_IN 0x8B // in endpoint for HID gamepad 2
+#define EPNUM_HID_3_IN 0x8C // in endpoint for HID gamepad 3
+
+// Interfaces of one pad, _first is the interface number of pad 0
+#define XINPUT_PAD(_first, _n) TUD_XINPUT_DESCRIPTOR((_first) + _n, STRID_PAD, EPNUM_XINPUT_##_n##_OUT, EPNUM_XINPUT_##_n##_IN, 32),
+#define HID_PAD(_first, _n) \
+  TUD_HID_DESCRIPTOR((_first) + _n, STRID_PAD, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_report), EPNUM_HID_##_n##_IN, 16, 1),
+
+#if PT_XINPUT_PADS > 1
+#define PAD_1(_kind, _first) _kind##_PAD(_first, 1)
+#else
+#define PAD_1(_kind, _first)
+#endif
+#if PT_XINPUT_PADS > 2
+#define PAD_2(_kind, _first) _kind##_PAD(_first, 2)
+#else
+#define PAD_2(_kind, _first)
+#endif
+#if PT_XINPUT_PADS > 3
+#define PAD_3(_kind, _first) _kind##_PAD(_first, 3)
+#else
+#define PAD_3(_kind, _first)
+#endif
+
+// All PT_XINPUT_PADS interfaces of one kind
+#define PADS(_kind, _first) _kind##_PAD(_first, 0) PAD_1(_kind, _first) PAD_2(_kind, _first) PAD_3(_kind, _first)
+
+// Config number, interface count, string index, total length, attribute, power in mA, then both CDC interfaces
+#define CONFIG_HEADER(_itf_count, _len)                                                          \
+  TUD_CONFIG_DESCRIPTOR(1, _itf_count, 0, _len, 0x00, 500),                                      \
+  TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_0, STRID_CDC, EPNUM_CDC_0_NOTIF, 8, EPNUM_CDC_0_OUT, EPNUM_CDC_0_IN, 64), \
+  TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_1, STRID_CDC, EPNUM_CDC_1_NOTIF, 8, EPNUM_CDC_1_OUT, EPNUM_CDC_1_IN, 64)
+
+// device configuration descriptors, one per personality
+static uint8_t const desc_fs_configuration_xinput[] = {
+    CONFIG_HEADER(ITF_NUM_PADS + PT_XINPUT_PADS, CONFIG_XINPUT_LEN),
+    PADS(XINPUT, ITF_NUM_PADS)
+};
 
-// TODO: Implement passthrough as HID gamepad instead of XInput device
-// #define EPNUM_HID_GAMEPAD_IN 0x8F // in endpoint for HID gamepad
-// #define EPNUM_HID_GAMEPAD_OUT 0x0F
+// HID gamepads poll every frame, bInterval 1
+static uint8_t const desc_fs_configuration_hid[] = {
+    CONFIG_HEADER(ITF_NUM_PADS + PT_XINPUT_PADS, CONFIG_HID_LEN),
+    PADS(HID, ITF_NUM_PADS)
+};
 
-// device configuration descriptor
-uint8_t const desc_fs_configuration[] = {
-    // Config number, interface count, string index, total length, attribute, power in mA
-    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0x00, 500),
+// The XInput interfaces keep their numbers, so the MS OS descriptor applies unchanged
+static uint8_t const desc_fs_configuration_both[] = {
+    CONFIG_HEADER(ITF_NUM_PADS + 2 * PT_XINPUT_PADS, CONFIG_BOTH_LEN),
+    PADS(XINPUT, ITF_NUM_PADS)
+    PADS(HID, ITF_NUM_PADS + PT_XINPUT_PADS)
+};
 
-    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_0, 4, EPNUM_CDC_0_NOTIF, 8, EPNUM_CDC_0_OUT, EPNUM_CDC_0_IN, 64),
-    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_1, 4, EPNUM_CDC_1_NOTIF, 8, EPNUM_CDC_1_OUT, EPNUM_CDC_1_IN, 64),
-    TUD_XINPUT_DESCRIPTOR(ITF_NUM_XINPUT, 5, EPNUM_XINPUT_OUT, EPNUM_XINPUT_IN, 32),
+TU_VERIFY_STATIC(sizeof(desc_fs_configuration_xinput) == CONFIG_XINPUT_LEN, "Configuration descriptor size is incorrect.");
+TU_VERIFY_STATIC(sizeof(desc_fs_configuration_hid) == CONFIG_HID_LEN, "Configuration descriptor size is incorrect.");
+TU_VERIFY_STATIC(sizeof(desc_fs_configuration_both) == CONFIG_BOTH_LEN, "Configuration descriptor size is incorrect.");
 
+static uint8_t const *const desc_fs_configuration[USB_PERSONALITY_COUNT] = {
+    [USB_PERSONALITY_XINPUT] = desc_fs_configuration_xinput,
+    [USB_PERSONALITY_HID] = desc_fs_configuration_hid,
+    [USB_PERSONALITY_BOTH] = desc_fs_configuration_both,
 };
 
-TU_VERIFY_STATIC(sizeof(desc_fs_configuration) == CONFIG_TOTAL_LEN, "Configuration descriptor size is incorrect.");
-
 // Invoked when received GET CONFIGURATION DESCRIPTOR
 // Application return pointer to descriptor
 // Descriptor contents must exist long enough for transfer to complete
 uint8_t const *tud_descriptor_configuration_cb(uint8_t index)
 {
   (void)index; // for multiple configurations
-  return desc_fs_configuration;
+  return desc_fs_configuration[usb_personality_active()];
 }
 
-#define MS_OS_1_0_VENDOR_CODE 0x90
-
-// Microsoft OS 1.0 Extended Compat ID Feature Descriptor
-// https://learn.microsoft.com/en-us/windows-hardware/drivers/usbcon/microsoft-os-1-0-descriptors-specification
-// Required for XInput to work seamlessly on Windows
-static const uint8_t ms_os_ext_compat_id[40] = {
-    // Header (16 bytes)
-    0x28, 0x00, 0x00, 0x00,
-    0x00, 0x01,
-    0x04, 0x00,
-    0x01,                // 1 function section
-    0, 0, 0, 0, 0, 0, 0, // reserved[7]
-
-    // Function Section (24 bytes)
-    0x04, // bFirstInterface = 4
-    0x00, // reserved
-    'X', 'U', 'S', 'B', '1', '0', 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00};
+//--------------------------------------------------------------------+
+// BOS Descriptor
+//--------------------------------------------------------------------+
+
+// Invoked when received GET BOS DESCRIPTOR
+// Announces the MS OS 2.0 descriptor set whenever there are XInput interfaces
+uint8_t const *tud_descriptor_bos_cb(void)
+{
+  return usb_personality_active() == USB_PERSONALITY_HID ? usb_bos_plain : usb_bos_ms_os;
+}
 
 //--------------------------------------------------------------------+
-// E. TINYUSB VENDOR CALLBACK (for MS OS 1.0)
+// E. TINYUSB VENDOR CALLBACK (for MS OS 1.0 and 2.0)
 //--------------------------------------------------------------------+
 bool tud_vendor_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const *request)
 {
   if (stage != CONTROL_STAGE_SETUP)
     return true;
+  bool xinput = usb_personality_active() != USB_PERSONALITY_HID;
+  if (request->bmRequestType == 0xC0 &&
+      request->bRequest == MS_OS_2_0_VENDOR_CODE &&
+      request->wIndex == MS_OS_2_0_DESCRIPTOR_INDEX && xinput)
+  {
+    // Windows 8.1 and later, one request for every XInput interface
+    return tud_control_xfer(rhport, request, (void *)ms_os_2_0_set, sizeof(ms_os_2_0_set));
+  }
   if (request->bmRequestType == 0xC0 &&
       request->bRequest == MS_OS_1_0_VENDOR_CODE &&
-      request->wIndex == 0x0004)
+      request->wIndex == MS_OS_1_0_COMPAT_ID_INDEX && xinput)
   {
-    // Return 40-byte descriptor
-    return tud_control_xfer(rhport, request, (void *)ms_os_ext_compat_id, sizeof(ms_os_ext_compat_id));
+    // Older Windows, after the 0xEE string
+    return tud_control_xfer(rhport, request, (void *)ms_os_1_0_compat_id, sizeof(ms_os_1_0_compat_id));
+  }
+  if (request->bmRequestType == 0xC0)
+  {
+    return latency_stats_control_xfer(rhport, request) ||
+           stage_profile_control_xfer(rhport, request);
   }
   return false;
 }
+
 //--------------------------------------------------------------------+
 // String Descriptors
 //--------------------------------------------------------------------+
 
-// String Descriptor Index
-enum
-{
-  STRID_LANGID = 0,
-  STRID_MANUFACTURER,
-  STRID_PRODUCT,
-  STRID_SERIAL,
-};
-
-// array of pointer to string descriptors
-char const *string_desc_arr[] = {
-    (const char[]){0x09, 0x04}, // 0: is supported language is English (0x0409)
-    "Tak",                      // 1: Manufacturer
-    "Tak's Pico Device",        // 2: Product
-    NULL,                       // 3: Serials will use unique ID if possible
-    "Tak's CDC Interface",      // 4: CDC Interface
-    "Tak's Controller",         // 5: HID Interface
-    "MSFT100",
-};
-
-static uint16_t _desc_str[32 + 1];
-
 // Invoked when received GET STRING DESCRIPTOR request
 // Application return pointer to descriptor, whose contents must exist long enough for transfer to complete
+// All of them are prebuilt, see usb_strings.c
 uint16_t const *tud_descriptor_string_cb(uint8_t index, uint16_t langid)
 {
   (void)langid;
-  size_t chr_count;
 
-  switch (index)
+  // The HID personality has no XInput interface for Windows to bind
+  if (index == STRID_MS_OS && usb_personality_active() == USB_PERSONALITY_HID)
   {
-  case STRID_LANGID:
-    memcpy(&_desc_str[1], string_desc_arr[0], 2);
-    chr_count = 1;
-    break;
-
-  case STRID_SERIAL:
-    chr_count = board_usb_get_serial(_desc_str + 1, 32);
-    break;
-
-    // Respond to Microsoft OS 1.0 string descriptor request
-    // Note: the 0xEE index string is a Microsoft OS 1.0 Descriptors.
-    // https://docs.microsoft.com/en-us/windows-hardware/drivers/usbcon/microsoft-defined-usb-descriptors
-  case 0xEE:
-    // UTF-16LE encode "MSFT100" + vendor code byte
-    static uint16_t msft100_desc[9];
-    // length = 2*(7 chars) + 2(header) + 2(vendor code) = 18 bytes
-    msft100_desc[0] = (TUSB_DESC_STRING << 8) | 18;
-    // 'M','S','F','T','1','0','0'
-    const char *s = "MSFT100";
-    for (uint8_t i = 0; i < 7; i++)
-    {
-      msft100_desc[1 + i] = s[i];
-    }
-    // vendor code in low byte of the next UTF-16LE char
-    msft100_desc[8] = MS_OS_1_0_VENDOR_CODE;
-    return msft100_desc;
-    break;
-  default:
-
-    if (!(index < sizeof(string_desc_arr) / sizeof(string_desc_arr[0])))
-      return NULL;
-
-    const char *str = string_desc_arr[index];
-
-    // Cap at max char
-    chr_count = strlen(str);
-    size_t const max_count = sizeof(_desc_str) / sizeof(_desc_str[0]) - 1; // -1 for string type
-    if (chr_count > max_count)
-      chr_count = max_count;
-
-    // Convert ASCII string into UTF-16
-    for (size_t i = 0; i < chr_count; i++)
-    {
-      _desc_str[1 + i] = str[i];
-    }
-    break;
+    return NULL;
   }
-
-  // first byte is length (including header), second byte is string type
-  _desc_str[0] = (uint16_t)((TUSB_DESC_STRING << 8) | (2 * chr_count + 2));
-
-  return _desc_str;
-}
\ No newline at end of file
+  return usb_string_descriptor(index);
+}
@@ -0,0 +1,126 @@
+#include <stddef.h>
+
+#include "tusb.h"
+#include "pico/time.h"
+
+#include "usb_personality.h"
+
+// The HID report is sent straight out of xinput_report_t
+TU_VERIFY_STATIC(offsetof(xinput_report_t, wThumbRightY) + sizeof(int16_t) - offsetof(xinput_report_t, bmButtons) ==
+                     USB_HID_PAD_REPORT_LEN,
+                 "xinput_report_t no longer matches the HID gamepad report");
+
+// Between the command and the detach, lets the reply on CDC 0 reach the PC
+#define SWITCH_GRACE_US 5000
+
+enum
+{
+  SWITCH_IDLE = 0,
+  SWITCH_REQUESTED,  // waiting for the grace period
+  SWITCH_DETACHED,   // off the bus for PT_USB_DETACH_MS
+  SWITCH_ATTACHED,   // waiting for the PC to configure the device
+};
+
+const char *const usb_personality_names[USB_PERSONALITY_COUNT] = {"xinput", "hid", "both"};
+
+usb_personality_stats_t usb_personality_stats;
+
+static uint8_t active;
+static uint8_t requested;
+static uint8_t state;
+static uint32_t state_us;   // when the current state was entered
+static uint32_t detach_us;  // start of the running switch
+
+void usb_personality_init(uint8_t personality)
+{
+  active = personality < USB_PERSONALITY_COUNT ? personality : USB_PERSONALITY_XINPUT;
+  requested = active;
+}
+
+uint8_t usb_personality_active(void)
+{
+  return active;
+}
+
+void usb_personality_select(uint8_t personality)
+{
+  if (personality >= USB_PERSONALITY_COUNT || personality == requested)
+  {
+    return;
+  }
+  requested = personality;
+  if (state == SWITCH_IDLE || state == SWITCH_ATTACHED)
+  {
+    state = SWITCH_REQUESTED;
+    state_us = time_us_32();
+  }
+}
+
+bool usb_personality_task(void)
+{
+  uint32_t now = time_us_32();
+  switch (state)
+  {
+  case SWITCH_REQUESTED:
+    if (now - state_us < SWITCH_GRACE_US)
+    {
+      return true;
+    }
+    tud_disconnect();
+    state = SWITCH_DETACHED;
+    state_us = detach_us = now;
+    return true;
+
+  case SWITCH_DETACHED:
+    if (now - state_us < PT_USB_DETACH_MS * 1000u)
+    {
+      return true;
+    }
+    // Nothing asks for the descriptors while detached, the new ones are
+    // served from the next enumeration on
+    active = requested;
+    tud_connect();
+    state = SWITCH_ATTACHED;
+    state_us = now;
+    return false;
+
+  default:
+    return false;
+  }
+}
+
+void usb_personality_mounted(void)
+{
+  if (state != SWITCH_ATTACHED)
+  {
+    return;
+  }
+  state = SWITCH_IDLE;
+
+  usb_personality_stats_t *s = &usb_personality_stats;
+  s->last_us = time_us_32() - detach_us;
+  if (s->switches == 0 || s->last_us < s->best_us)
+  {
+    s->best_us = s->last_us;
+  }
+  s->switches++;
+}
+
+static bool hid_report(uint8_t pad, xinput_report_t const *report)
+{
+  return tud_hid_n_report(pad, 0, &report->bmButtons, USB_HID_PAD_REPORT_LEN);
+}
+
+bool usb_personality_report(uint8_t pad, xinput_report_t const *report)
+{
+  if (active == USB_PERSONALITY_HID)
+  {
+    return hid_report(pad, report);
+  }
+  return tud_xinput_n_report(pad, report);
+}
+
+bool usb_personality_mirror(uint8_t pad, xinput_report_t const *report)
+{
+  return active != USB_PERSONALITY_BOTH || hid_report(pad, report);
+}
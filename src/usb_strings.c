@@ -0,0 +1,68 @@
+#include <string.h>
+
+#include "usb_strings.h"
+#include "ms_os_desc.h"
+
+// TUSB_DESC_STRING, spelled out so the host tools build this file without TinyUSB
+#define DESC_STRING 0x03
+
+// A string descriptor as it goes on the wire: bLength, bDescriptorType and
+// the UTF-16 text of a u"" literal, little-endian like the RP2040 and every
+// host this is tested on. The literal's terminator is stored but not
+// counted in bLength, so it is never sent
+#define STRING_DESCRIPTOR(_name, _str)                                               \
+  static const struct                                                                \
+  {                                                                                  \
+    uint16_t header;                                                                 \
+    uint16_t text[sizeof(u"" _str) / 2];                                             \
+  } _name = {(uint16_t)((DESC_STRING << 8) | sizeof(u"" _str)), u"" _str};           \
+  _Static_assert(sizeof(u"" _str) <= 0xFF, #_name " is too long for a string descriptor")
+
+STRING_DESCRIPTOR(desc_langid, u"\x0409");  // English (0x0409)
+STRING_DESCRIPTOR(desc_manufacturer, "Tak");
+STRING_DESCRIPTOR(desc_product, "Tak's Pico Device");
+STRING_DESCRIPTOR(desc_cdc, "Tak's CDC Interface");
+STRING_DESCRIPTOR(desc_pad, "Tak's Controller");
+STRING_DESCRIPTOR(desc_msft100, "MSFT100");
+
+// Microsoft OS 1.0 string descriptor: "MSFT100", then the vendor code in the
+// low byte of one more character
+// https://docs.microsoft.com/en-us/windows-hardware/drivers/usbcon/microsoft-defined-usb-descriptors
+STRING_DESCRIPTOR(desc_ms_os, u"MSFT100\x90");
+_Static_assert(MS_OS_1_0_VENDOR_CODE == 0x90, "desc_ms_os carries the vendor code");
+
+// Filled in once at boot, header 0 until then
+static uint16_t desc_serial[1 + USB_STRING_SERIAL_MAX];
+
+static uint16_t const *const string_desc[] = {
+    [STRID_LANGID] = &desc_langid.header,
+    [STRID_MANUFACTURER] = &desc_manufacturer.header,
+    [STRID_PRODUCT] = &desc_product.header,
+    [STRID_SERIAL] = desc_serial,
+    [STRID_CDC] = &desc_cdc.header,
+    [STRID_PAD] = &desc_pad.header,
+    [STRID_MSFT100] = &desc_msft100.header,
+};
+
+void usb_string_set_serial(uint16_t const *chars, size_t count)
+{
+  if (count > USB_STRING_SERIAL_MAX)
+  {
+    count = USB_STRING_SERIAL_MAX;
+  }
+  memcpy(&desc_serial[1], chars, count * sizeof(uint16_t));
+  desc_serial[0] = (uint16_t)((DESC_STRING << 8) | (2 * count + 2));
+}
+
+uint16_t const *usb_string_descriptor(uint8_t index)
+{
+  if (index == STRID_MS_OS)
+  {
+    return &desc_ms_os.header;
+  }
+  if (index >= sizeof(string_desc) / sizeof(string_desc[0]) || string_desc[index][0] == 0)
+  {
+    return NULL;
+  }
+  return string_desc[index];
+}
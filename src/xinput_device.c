@@ -0,0 +1,156 @@
+#include "tusb.h"
+#include "device/usbd_pvt.h"
+#include "xinput_device.h"
+
+TU_ATTR_WEAK void tud_xinput_report_complete_cb(uint8_t itf, uint8_t const *report, uint16_t len)
+{
+  (void)itf;
+  (void)report;
+  (void)len;
+}
+
+TU_ATTR_WEAK void tud_xinput_report_received_cb(uint8_t itf, uint8_t const *report, uint16_t len)
+{
+  (void)itf;
+  (void)report;
+  (void)len;
+}
+
+// OUT reports are at most 8 bytes, but a transfer must take a full packet
+// of the endpoint size in the descriptors
+#define XINPUT_EPOUT_BUFSIZE 32
+
+// One entry per XInput interface in the configuration
+typedef struct
+{
+  uint8_t rhport;
+  uint8_t itf_num; // 0xFF while not opened
+  uint8_t ep_in;
+  uint8_t ep_out;
+  CFG_TUD_MEM_ALIGN uint8_t epin_buf[sizeof(xinput_report_t)];
+  CFG_TUD_MEM_ALIGN uint8_t epout_buf[XINPUT_EPOUT_BUFSIZE];
+} xinputd_interface_t;
+
+CFG_TUD_MEM_SECTION static xinputd_interface_t xinputd_itf[CFG_TUD_XINPUT];
+
+static void xinputd_init(void)
+{
+  tu_memclr(xinputd_itf, sizeof(xinputd_itf));
+  for (uint8_t i = 0; i < CFG_TUD_XINPUT; i++)
+  {
+    xinputd_itf[i].itf_num = 0xFF;
+  }
+}
+
+static bool xinputd_deinit(void)
+{
+  return true;
+}
+
+static void xinputd_reset(uint8_t rhport)
+{
+  (void)rhport;
+  xinputd_init();
+}
+
+// Claim the next free instance for each XInput interface, in descriptor
+// order, so interface n of the pads is instance n
+static uint16_t xinputd_open(uint8_t rhport, tusb_desc_interface_t const *desc_itf, uint16_t max_len)
+{
+  TU_VERIFY(desc_itf->bInterfaceClass == XINPUT_ITF_CLASS && desc_itf->bInterfaceSubClass == XINPUT_ITF_SUBCLASS &&
+                desc_itf->bInterfaceProtocol == XINPUT_ITF_PROTOCOL,
+            0);
+  uint16_t const drv_len = TUD_XINPUT_DESC_LEN;
+  TU_VERIFY(max_len >= drv_len && desc_itf->bNumEndpoints == 2, 0);
+
+  xinputd_interface_t *p = NULL;
+  for (uint8_t i = 0; i < CFG_TUD_XINPUT; i++)
+  {
+    if (xinputd_itf[i].itf_num == 0xFF)
+    {
+      p = &xinputd_itf[i];
+      break;
+    }
+  }
+  TU_VERIFY(p, 0);
+
+  // Skip the 0x21 class descriptor, then open both endpoints
+  uint8_t const *p_desc = tu_desc_next(desc_itf);
+  TU_VERIFY(tu_desc_type(p_desc) == 0x21, 0);
+  p_desc = tu_desc_next(p_desc);
+  TU_VERIFY(usbd_open_edpt_pair(rhport, p_desc, 2, TUSB_XFER_INTERRUPT, &p->ep_out, &p->ep_in), 0);
+
+  p->rhport = rhport;
+  p->itf_num = desc_itf->bInterfaceNumber;
+
+  // Ready for the first rumble or LED request
+  TU_VERIFY(usbd_edpt_xfer(rhport, p->ep_out, p->epout_buf, sizeof(p->epout_buf)), 0);
+  return drv_len;
+}
+
+// The PC needs no class requests from a wired pad, stall them
+static bool xinputd_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const *request)
+{
+  (void)rhport;
+  (void)stage;
+  (void)request;
+  return false;
+}
+
+static bool xinputd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes)
+{
+  for (uint8_t i = 0; i < CFG_TUD_XINPUT; i++)
+  {
+    xinputd_interface_t *p = &xinputd_itf[i];
+    if (p->itf_num == 0xFF)
+    {
+      continue;
+    }
+    if (ep_addr == p->ep_in)
+    {
+      // Runs from tud_task, the endpoint is free again at this point
+      tud_xinput_report_complete_cb(i, p->epin_buf, (uint16_t)xferred_bytes);
+      return true;
+    }
+    if (ep_addr == p->ep_out)
+    {
+      if (result == XFER_RESULT_SUCCESS)
+      {
+        tud_xinput_report_received_cb(i, p->epout_buf, (uint16_t)xferred_bytes);
+      }
+      // The callback has consumed the buffer, take the next request
+      return usbd_edpt_xfer(rhport, p->ep_out, p->epout_buf, sizeof(p->epout_buf));
+    }
+  }
+  return false;
+}
+
+usbd_class_driver_t const usbd_xinput_driver = {
+    .name = "XINPUT",
+    .init = xinputd_init,
+    .deinit = xinputd_deinit,
+    .reset = xinputd_reset,
+    .open = xinputd_open,
+    .control_xfer_cb = xinputd_control_xfer_cb,
+    .xfer_cb = xinputd_xfer_cb,
+    .sof = NULL,
+};
+
+bool tud_xinput_n_ready(uint8_t itf)
+{
+  TU_VERIFY(itf < CFG_TUD_XINPUT);
+  xinputd_interface_t const *p = &xinputd_itf[itf];
+  return tud_ready() && p->ep_in != 0 && !usbd_edpt_busy(p->rhport, p->ep_in);
+}
+
+bool tud_xinput_n_report(uint8_t itf, xinput_report_t const *report)
+{
+  TU_VERIFY(itf < CFG_TUD_XINPUT && tud_ready());
+  xinputd_interface_t *p = &xinputd_itf[itf];
+  TU_VERIFY(p->ep_in != 0);
+
+  // Claim the endpoint so a second caller sees it busy
+  TU_VERIFY(usbd_edpt_claim(p->rhport, p->ep_in));
+  memcpy(p->epin_buf, report, sizeof(xinput_report_t));
+  return usbd_edpt_xfer(p->rhport, p->ep_in, p->epin_buf, sizeof(xinput_report_t));
+}
@@ -0,0 +1,369 @@
+// Randomized test of the firmware's command line parser and tokenizer.
+//
+//   command_fuzz [streams] [seed]
+//
+// Feeds random byte streams into src/command_parser.c in random chunk sizes
+// and compares every line it returns with a straightforward model: lines end
+// at CR or LF, empty lines and lines longer than PT_COMMAND_LINE_MAX - 1 are
+// dropped, a line without a terminator waits for the next chunk. Every line
+// is then tokenized and compared with the model's split at spaces and tabs,
+// where a line with more than MAX_ARGS words must be reported as such.
+// Quotes have no special meaning and must come through as ordinary bytes.
+// The streams are biased towards the interesting cases: lines around the
+// length limit, missing terminators, CR LF pairs, runs of whitespace, quotes,
+// more arguments than fit and NUL bytes. The stream, every chunk and every
+// tokenized line live in heap blocks of exactly their size, so with
+// AddressSanitizer (the default build) any read or write past them aborts.
+// Exits with 1 on the first mismatch.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "command.h"
+
+#define DEFAULT_STREAMS 200000u
+#define STREAM_MAX 1024
+#define MAX_ARGS 8
+
+static uint32_t rng;
+
+static uint32_t rnd(uint32_t n)
+{
+  rng = rng * 1664525u + 1013904223u;
+  return (rng >> 8) % n;
+}
+
+static const char *const pieces[] = {
+    "\r\n", "\n", "\r", " ", "\t", "  \t ", "\"", "'", "\"a b\"", "'x y'", "\\\"",
+    "map", "btn", "stick", "0", "15", "0x10", "dz", "save", "reboot", "turbo",
+};
+
+// A random stream, returns its length
+static size_t make_stream(uint8_t *s)
+{
+  size_t len = 0;
+  uint32_t target = rnd(STREAM_MAX);
+  while (len < target)
+  {
+    uint32_t kind = rnd(16);
+    size_t room = STREAM_MAX - len;
+    if (kind < 6)
+    {
+      // A word or separator from the list
+      const char *p = pieces[rnd(sizeof(pieces) / sizeof(pieces[0]))];
+      size_t n = strlen(p) < room ? strlen(p) : room;
+      memcpy(s + len, p, n);
+      len += n;
+    }
+    else if (kind < 8)
+    {
+      // A line right around the limit, then its terminator
+      size_t n = PT_COMMAND_LINE_MAX - 3 + rnd(5);
+      for (size_t i = 0; i < n && len < STREAM_MAX; i++)
+      {
+        s[len++] = (uint8_t)('a' + rnd(26));
+      }
+      if (len < STREAM_MAX)
+      {
+        s[len++] = rnd(2) ? '\n' : '\r';
+      }
+    }
+    else if (kind < 9)
+    {
+      // Far too many arguments
+      for (uint32_t i = 0; i < MAX_ARGS + 4 && len + 2 <= STREAM_MAX; i++)
+      {
+        s[len++] = (uint8_t)('A' + i);
+        s[len++] = ' ';
+      }
+    }
+    else if (kind < 10)
+    {
+      // Any byte, NUL included
+      s[len++] = (uint8_t)rnd(256);
+    }
+    else
+    {
+      s[len++] = (uint8_t)('a' + rnd(26));
+    }
+  }
+  return len;
+}
+
+typedef struct
+{
+  char line[STREAM_MAX + 1];
+  size_t len;
+  int overflow;
+} model_t;
+
+// Feed one byte to the model, returns 1 if it completed a line
+static int model_feed(model_t *m, uint8_t c)
+{
+  if (c == '\r' || c == '\n')
+  {
+    int ready = m->len && !m->overflow;
+    m->line[m->len] = '\0';
+    if (!ready)
+    {
+      m->len = 0;
+      m->overflow = 0;
+    }
+    return ready;
+  }
+  if (m->len >= PT_COMMAND_LINE_MAX - 1)
+  {
+    m->overflow = 1;
+    return 0;
+  }
+  m->line[m->len++] = (char)c;
+  return 0;
+}
+
+static int fail(uint32_t stream, const char *what)
+{
+  fprintf(stderr, "stream %u: %s\n", stream, what);
+  return 0;
+}
+
+// Tokenize a copy of line (len bytes up to its first NUL) and compare
+static int check_tokens(uint32_t stream, const char *line, size_t len)
+{
+  size_t used = strnlen(line, len);
+  char *copy = malloc(used + 1);
+  memcpy(copy, line, used);
+  copy[used] = '\0';
+
+  // +1 so a tokenizer writing one argument too many is caught
+  char *argv[MAX_ARGS + 1];
+  argv[MAX_ARGS] = NULL;
+  uint8_t argc = command_tokenize(copy, argv, MAX_ARGS);
+
+  // The model: words split at spaces and tabs, the first MAX_ARGS of them,
+  // and MAX_ARGS + 1 as the count when there are more
+  const char *words[MAX_ARGS];
+  size_t word_len[MAX_ARGS];
+  uint8_t count = 0;
+  for (size_t i = 0; i < used && count <= MAX_ARGS;)
+  {
+    if (line[i] == ' ' || line[i] == '\t')
+    {
+      i++;
+      continue;
+    }
+    if (count == MAX_ARGS)
+    {
+      count++;
+      break;
+    }
+    words[count] = &line[i];
+    size_t n = 0;
+    while (i + n < used && line[i + n] != ' ' && line[i + n] != '\t')
+    {
+      n++;
+    }
+    word_len[count++] = n;
+    i += n;
+  }
+
+  int ok = 1;
+  if (argc != count)
+  {
+    ok = fail(stream, "token count differs");
+  }
+  if (argv[MAX_ARGS] != NULL)
+  {
+    ok = fail(stream, "argument written past max_args");
+  }
+  for (uint8_t i = 0; ok && i < argc && i < MAX_ARGS; i++)
+  {
+    if (argv[i] < copy || argv[i] > copy + used || strlen(argv[i]) != word_len[i] ||
+        memcmp(argv[i], words[i], word_len[i]) != 0)
+    {
+      ok = fail(stream, "token differs");
+    }
+  }
+  free(copy);
+  return ok;
+}
+
+static int run_stream(uint32_t stream, uint32_t *lines)
+{
+  uint8_t buf[STREAM_MAX];
+  size_t len = make_stream(buf);
+  uint8_t *data = malloc(len ? len : 1);
+  memcpy(data, buf, len);
+
+  command_parser_t *p = malloc(sizeof(*p));
+  command_parser_reset(p);
+  static model_t m;
+  m.len = 0;
+  m.overflow = 0;
+  size_t model_pos = 0;
+
+  int ok = 1;
+  for (size_t pos = 0; ok && pos < len;)
+  {
+    // Deliver the stream in USB-packet-like chunks, each in its own block
+    size_t chunk = 1 + rnd(rnd(4) ? 64 : 300);
+    if (chunk > len - pos)
+    {
+      chunk = len - pos;
+    }
+    uint8_t *piece = malloc(chunk);
+    memcpy(piece, data + pos, chunk);
+
+    for (size_t off = 0; ok && off < chunk;)
+    {
+      bool ready;
+      uint32_t used = command_parser_feed(p, piece + off, (uint32_t)(chunk - off), &ready);
+      if (used == 0 || used > chunk - off || p->len >= sizeof(p->line))
+      {
+        ok = fail(stream, "parser consumed a bad count");
+        break;
+      }
+
+      // Run the model over the same bytes, it must complete a line exactly
+      // where the parser did
+      int model_ready = 0;
+      for (uint32_t i = 0; i < used; i++)
+      {
+        model_ready = model_feed(&m, data[model_pos++]);
+        if (model_ready && i + 1 < used)
+        {
+          ok = fail(stream, "parser skipped past a complete line");
+          break;
+        }
+      }
+      if (!ok)
+      {
+        break;
+      }
+      if (ready != (bool)model_ready)
+      {
+        ok = fail(stream, ready ? "parser returned a line the model dropped" : "parser missed a line");
+        break;
+      }
+      if (ready)
+      {
+        if (memcmp(p->line, m.line, m.len + 1) != 0)
+        {
+          ok = fail(stream, "line differs");
+          break;
+        }
+        ok = check_tokens(stream, p->line, m.len);
+        (*lines)++;
+        m.len = 0;
+        m.overflow = 0;
+      }
+      off += used;
+    }
+    free(piece);
+    pos += chunk;
+  }
+
+  // An unterminated tail is still pending, never returned
+  if (ok && (p->len != m.len || p->overflow != (bool)m.overflow))
+  {
+    ok = fail(stream, "pending tail differs");
+  }
+  free(p);
+  free(data);
+  return ok;
+}
+
+// The cases the random streams are biased towards, spelled out once
+static int fixed_cases(void)
+{
+  static const struct
+  {
+    const char *in;
+    const char *lines;  // expected lines, each followed by '|'
+  } cases[] = {
+      {"help\n", "help|"},
+      {"help", ""},
+      {"\r\n\r\n", ""},
+      {"stats\r\nsave\r\n", "stats|save|"},
+      {"map \"a b\"\n", "map \"a b\"|"},
+  };
+  for (size_t k = 0; k < sizeof(cases) / sizeof(cases[0]); k++)
+  {
+    command_parser_t p;
+    command_parser_reset(&p);
+    char got[256] = "";
+    const uint8_t *in = (const uint8_t *)cases[k].in;
+    size_t len = strlen(cases[k].in);
+    for (size_t pos = 0; pos < len;)
+    {
+      bool ready;
+      pos += command_parser_feed(&p, in + pos, (uint32_t)(len - pos), &ready);
+      if (ready)
+      {
+        strcat(got, p.line);
+        strcat(got, "|");
+      }
+    }
+    if (strcmp(got, cases[k].lines) != 0)
+    {
+      fprintf(stderr, "case %zu: got \"%s\"\n", k, got);
+      return 0;
+    }
+  }
+
+  // The longest line that fits, and one byte more
+  char line[PT_COMMAND_LINE_MAX + 2];
+  for (int extra = 0; extra < 2; extra++)
+  {
+    size_t n = PT_COMMAND_LINE_MAX - 1 + extra;
+    memset(line, 'x', n);
+    line[n] = '\n';
+    command_parser_t p;
+    command_parser_reset(&p);
+    bool ready;
+    command_parser_feed(&p, (const uint8_t *)line, (uint32_t)(n + 1), &ready);
+    if (ready != !extra || (ready && strlen(p.line) != n))
+    {
+      fprintf(stderr, "line of %zu bytes: %s\n", n, ready ? "kept" : "dropped");
+      return 0;
+    }
+  }
+
+  // Quotes do not group, the tokens keep them
+  char quoted[] = "map \"a b\" 'c'";
+  char *argv[MAX_ARGS];
+  uint8_t argc = command_tokenize(quoted, argv, MAX_ARGS);
+  if (argc != 4 || strcmp(argv[1], "\"a") != 0 || strcmp(argv[2], "b\"") != 0 || strcmp(argv[3], "'c'") != 0)
+  {
+    fprintf(stderr, "quotes: %u tokens\n", argc);
+    return 0;
+  }
+
+  // Trailing blanks after a full argv are fine, a ninth token is not
+  char full[] = "dz stick 0 1 2 3 4 5 \t ";
+  char over[] = "dz stick 0 1 2 3 4 5 6";
+  if ((argc = command_tokenize(full, argv, MAX_ARGS)) != MAX_ARGS ||
+      (argc = command_tokenize(over, argv, MAX_ARGS)) != MAX_ARGS + 1)
+  {
+    fprintf(stderr, "argument limit: %u tokens\n", argc);
+    return 0;
+  }
+  return 1;
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t streams = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : DEFAULT_STREAMS;
+  rng = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : 1;
+
+  int ok = fixed_cases();
+  printf("cases    %s\n", ok ? "ok" : "FAILED");
+
+  uint32_t lines = 0;
+  for (uint32_t i = 0; ok && i < streams; i++)
+  {
+    ok = run_stream(i, &lines);
+  }
+  printf("streams  %u streams, %u lines: %s\n", streams, lines, ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,329 @@
+// Check and time the firmware's stick and trigger curve stage.
+//
+//   curve_bench [reports]
+//
+// Compiles a typical and many random curve configs with src/stick_curve.c
+// and compares curve_apply on random reports with a floating-point model of
+// the same math: the curve sampled at the table points and interpolated at
+// the integer stick magnitude. Sticks must keep their direction and stay
+// within a few counts of the model, triggers within rounding of the curve.
+// For the typical config it also prints how far the output lands from the
+// exact curve, which is what the table size buys. The default config must
+// leave reports untouched. Then the stage is timed with the default config
+// and with the typical one. curve_bench_1024 is the same with 1024-entry
+// stick tables. Exits with 1 if a check fails.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "stick_curve.h"
+
+#define DEFAULT_REPORTS 20000000u
+#define BATCH 4096
+#define CONFIGS 2000
+#define CHECK_REPORTS 512
+
+// Worst stick error allowed against the interpolated reference, in counts.
+// The Q15 input of the table build truncates, which a steep curve turns
+// into a few counts, then the entries round and the scaling truncates
+#define STICK_TOLERANCE 6
+
+static uint32_t rng = 1;
+
+static uint32_t rnd(uint32_t n)
+{
+  rng = rng * 1664525u + 1013904223u;
+  return (rng >> 8) % n;
+}
+
+static void random_report(xinput_report_t *r)
+{
+  memset(r, 0, sizeof(*r));
+  r->bSize = 0x14;
+  r->bLeftTrigger = (uint8_t)rnd(256);
+  r->bRightTrigger = (uint8_t)rnd(256);
+  int16_t axis[4];
+  for (int i = 0; i < 4; i += 2)
+  {
+    // Mostly points inside the round gate at a random magnitude, some
+    // anywhere in the square, corners and extremes included
+    if (rnd(4))
+    {
+      double a = rnd(36000) * (M_PI / 18000);
+      double m = rnd(32768);
+      axis[i] = (int16_t)lrint(m * cos(a));
+      axis[i + 1] = (int16_t)lrint(m * sin(a));
+    }
+    else
+    {
+      static const int16_t extremes[] = {-32768, -32767, -1, 0, 1, 32767};
+      axis[i] = rnd(2) ? extremes[rnd(6)] : (int16_t)rnd(0x10000);
+      axis[i + 1] = rnd(2) ? extremes[rnd(6)] : (int16_t)rnd(0x10000);
+    }
+  }
+  r->wThumbLeftX = axis[0];
+  r->wThumbLeftY = axis[1];
+  r->wThumbRightX = axis[2];
+  r->wThumbRightY = axis[3];
+}
+
+static void random_config(curve_config_t *cfg)
+{
+  for (int i = 0; i < 2; i++)
+  {
+    uint16_t dz = (uint16_t)rnd(8000);
+    cfg->stick[i] = (curve_stick_config_t){
+        .deadzone = dz,
+        .anti_deadzone = (uint16_t)rnd(8000),
+        // Now and then an outer edge the firmware ignores
+        .outer = rnd(8) ? (uint16_t)(dz + 1 + rnd(32767 - dz)) : (uint16_t)rnd(0x10000),
+        .curve = (uint8_t)rnd(101),
+    };
+    uint8_t tdz = (uint8_t)rnd(64);
+    cfg->trigger[i] = (curve_trigger_config_t){
+        .deadzone = tdz,
+        .anti_deadzone = (uint8_t)rnd(64),
+        .outer = rnd(8) ? (uint8_t)(tdz + 1 + rnd(255 - tdz)) : (uint8_t)rnd(256),
+        .curve = (uint8_t)rnd(101),
+    };
+  }
+}
+
+// The outer edge the firmware actually uses
+static double outer_edge(double outer, double deadzone, double full)
+{
+  return outer > full || outer <= deadzone ? full : outer;
+}
+
+// The response curve in floating point
+static double response(double m, double full, double deadzone, double anti, double outer, double curve)
+{
+  outer = outer_edge(outer, deadzone, full);
+  if (m <= deadzone)
+  {
+    return 0;
+  }
+  if (m >= outer)
+  {
+    return full;
+  }
+  double u = (m - deadzone) / (outer - deadzone);
+  double shaped = u + (u * u * u - u) * curve / 100;
+  return anti + shaped * (full - anti);
+}
+
+// The firmware's stick math in floating point: the curve sampled at the
+// same table points and interpolated linearly at the integer magnitude
+static double stick_reference(curve_stick_config_t const *c, uint32_t mag)
+{
+  if (mag >= 32767)
+  {
+    return 32767 + (double)(mag - 32767);
+  }
+  uint32_t step = 1u << CURVE_STICK_LUT_SHIFT;
+  uint32_t lo = mag / step * step;
+  uint32_t hi = lo + step > 32767 ? 32767 : lo + step;
+  double r_lo = response(lo, 32767, c->deadzone, c->anti_deadzone, c->outer, c->curve);
+  double r_hi = response(hi, 32767, c->deadzone, c->anti_deadzone, c->outer, c->curve);
+  return r_lo + (r_hi - r_lo) * (mag - lo) / step;
+}
+
+typedef struct
+{
+  double max_err;  // counts, against the interpolated reference
+  uint64_t samples;
+  uint64_t bad;
+  // Against the exact curve at the exact magnitude, away from the edges,
+  // for the typical config only
+  double curve_max_err;
+  double curve_sum_sq;
+  uint64_t curve_samples;
+} stats_t;
+
+static void check_stick(stats_t *st, curve_stick_config_t const *c, int typical, int16_t x, int16_t y,
+                        int16_t ox, int16_t oy)
+{
+  double exact = sqrt((double)x * x + (double)y * y);
+  uint32_t mag = (uint32_t)exact;
+  double want_x = x, want_y = y;
+  if (mag > 0)
+  {
+    double out = stick_reference(c, mag);
+    want_x = fmin(fmax(x * out / mag, -32768), 32767);
+    want_y = fmin(fmax(y * out / mag, -32768), 32767);
+  }
+
+  // Table entries and interpolation round, the scaling truncates
+  double err = fmax(fabs(ox - want_x), fabs(oy - want_y));
+  st->max_err = fmax(st->max_err, err);
+  st->samples++;
+  // Never flipped to the other side of an axis
+  if (err > STICK_TOLERANCE || (ox > 0 && x <= 0) || (ox < 0 && x >= 0) || (oy > 0 && y <= 0) ||
+      (oy < 0 && y >= 0))
+  {
+    st->bad++;
+  }
+
+  // How far the table is from the curve itself. Within one table step of an
+  // edge it blends the two sides, so those are left out
+  double step = 1u << CURVE_STICK_LUT_SHIFT;
+  double outer = outer_edge(c->outer, c->deadzone, 32767);
+  if (!typical || exact == 0 || exact >= 32767 || fabs(exact - c->deadzone) <= step + 1 ||
+      fabs(exact - outer) <= step + 1)
+  {
+    return;
+  }
+  double out = response(exact, 32767, c->deadzone, c->anti_deadzone, c->outer, c->curve);
+  double curve_err = fmax(fabs(ox - x * out / exact), fabs(oy - y * out / exact));
+  st->curve_max_err = fmax(st->curve_max_err, curve_err);
+  st->curve_sum_sq += curve_err * curve_err;
+  st->curve_samples++;
+}
+
+static int check_trigger(curve_trigger_config_t const *c, uint8_t in, uint8_t out)
+{
+  double want = response(in, 255, c->deadzone, c->anti_deadzone, c->outer, c->curve);
+  return fabs(out - want) <= 1;
+}
+
+static void check_report(stats_t *st, curve_table_t const *table, curve_config_t const *cfg, int typical,
+                         xinput_report_t const *in)
+{
+  xinput_report_t out = *in;
+  curve_apply(table, &out);
+  check_stick(st, &cfg->stick[0], typical, in->wThumbLeftX, in->wThumbLeftY, out.wThumbLeftX, out.wThumbLeftY);
+  check_stick(st, &cfg->stick[1], typical, in->wThumbRightX, in->wThumbRightY, out.wThumbRightX,
+              out.wThumbRightY);
+  if (!check_trigger(&cfg->trigger[0], in->bLeftTrigger, out.bLeftTrigger) ||
+      !check_trigger(&cfg->trigger[1], in->bRightTrigger, out.bRightTrigger) || out.bSize != in->bSize ||
+      out.bmButtons != in->bmButtons)
+  {
+    st->bad++;
+  }
+}
+
+// A typical setup: small radial deadzone, anti-deadzone for the game's own
+// deadzone, a bit of curve, and trigger deadzones
+static void typical_config(curve_config_t *cfg)
+{
+  curve_config_default(cfg);
+  for (int i = 0; i < 2; i++)
+  {
+    cfg->stick[i] = (curve_stick_config_t){.deadzone = 2500, .anti_deadzone = 7800, .outer = 31000, .curve = 40};
+    cfg->trigger[i] = (curve_trigger_config_t){.deadzone = 10, .anti_deadzone = 0, .outer = 250, .curve = 0};
+  }
+}
+
+static int check(void)
+{
+  static curve_table_t table;
+  curve_config_t cfg;
+  xinput_report_t in, out;
+  int ok = 1;
+
+  curve_config_default(&cfg);
+  curve_compile(&cfg, &table);
+  for (int k = 0; k < CHECK_REPORTS * 16; k++)
+  {
+    random_report(&in);
+    out = in;
+    curve_apply(&table, &out);
+    if (memcmp(&out, &in, sizeof(in)) != 0)
+    {
+      fprintf(stderr, "default config changed a report\n");
+      ok = 0;
+      break;
+    }
+  }
+
+  stats_t st = {0};
+  for (int c = 0; c < CONFIGS; c++)
+  {
+    if (c == 0)
+    {
+      typical_config(&cfg);
+    }
+    else
+    {
+      random_config(&cfg);
+    }
+    curve_compile(&cfg, &table);
+    // Many more reports for the typical config, it also measures the error
+    for (int k = 0; k < (c == 0 ? CONFIGS : 1) * CHECK_REPORTS; k++)
+    {
+      random_report(&in);
+      check_report(&st, &table, &cfg, c == 0, &in);
+    }
+  }
+  ok = ok && st.bad == 0;
+  printf("check    %u-entry stick tables, %d configs, %llu stick samples, max %.2f counts off the table, %llu bad: "
+         "%s\n",
+         CURVE_STICK_LUT_SIZE, CONFIGS, (unsigned long long)st.samples, st.max_err, (unsigned long long)st.bad,
+         ok ? "ok" : "FAILED");
+  printf("curve    typical config against the exact curve: max %.2f, RMS %.3f counts\n", st.curve_max_err,
+         st.curve_samples ? sqrt(st.curve_sum_sq / st.curve_samples) : 0);
+  return ok;
+}
+
+__attribute__((noinline)) static uint32_t run(const xinput_report_t *in, uint32_t reports, const curve_table_t *table)
+{
+  uint32_t sum = 0;
+  for (uint32_t k = 0; k < reports; k++)
+  {
+    xinput_report_t r = in[k % BATCH];
+    curve_apply(table, &r);
+    sum += (uint16_t)r.wThumbLeftX + (uint16_t)r.wThumbRightY + r.bLeftTrigger + r.bRightTrigger;
+  }
+  return sum;
+}
+
+static double elapsed_ns(struct timespec const *t0, struct timespec const *t1)
+{
+  return (t1->tv_sec - t0->tv_sec) * 1e9 + (t1->tv_nsec - t0->tv_nsec);
+}
+
+static double time_run(const xinput_report_t *in, uint32_t reports, const curve_table_t *table)
+{
+  static volatile uint32_t sink;
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  sink += run(in, reports, table);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  return elapsed_ns(&t0, &t1) / reports;
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t reports = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : DEFAULT_REPORTS;
+  if (reports == 0)
+  {
+    fprintf(stderr, "usage: %s [reports]\n", argv[0]);
+    return 1;
+  }
+
+  int ok = check();
+
+  static xinput_report_t in[BATCH];
+  for (int k = 0; k < BATCH; k++)
+  {
+    random_report(&in[k]);
+  }
+
+  static curve_table_t identity, typical;
+  curve_config_t cfg;
+  curve_config_default(&cfg);
+  curve_compile(&cfg, &identity);
+  typical_config(&cfg);
+  curve_compile(&cfg, &typical);
+
+  time_run(in, reports / 10 + 1, &typical);
+  double identity_ns = time_run(in, reports, &identity);
+  double typical_ns = time_run(in, reports, &typical);
+  printf("default  %u reports, %.2f ns/report\n", reports, identity_ns);
+  printf("typical  %u reports, %.2f ns/report (%.1f M reports/s)\n", reports, typical_ns, 1e3 / typical_ns);
+  return ok ? 0 : 1;
+}
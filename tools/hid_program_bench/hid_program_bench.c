@@ -0,0 +1,243 @@
+// Check and time the HID report descriptor compiler of the firmware.
+//
+//   hid_program_bench [descriptor.bin ...]
+//
+// Compiles the built-in corpus, decodes a known report of each descriptor
+// and compares the result, then times the decoder on random reports. Extra
+// files are compiled, listed and timed too; on Linux the descriptor of any
+// attached device can be given straight from
+// /sys/class/hidraw/hidrawN/device/report_descriptor.
+// Exits with 1 if a built-in check fails.
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hid_program.h"
+
+#define BENCH_REPORTS 2000000
+
+typedef struct
+{
+  const char *name;
+  const uint8_t *desc;
+  uint16_t len;
+  const uint8_t *report;  // sample report and what it must decode to
+  uint16_t report_len;
+  hid_pad_t expect;
+  const uint8_t *ignored;  // report the program has no ops for
+  uint16_t ignored_len;
+} corpus_entry_t;
+
+// HID 1.11 appendix B.1
+static const uint8_t boot_keyboard[] = {
+    0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00, 0x25, 0x01,
+    0x75, 0x01, 0x95, 0x08, 0x81, 0x02, 0x95, 0x01, 0x75, 0x08, 0x81, 0x01, 0x95, 0x05, 0x75, 0x01,
+    0x05, 0x08, 0x19, 0x01, 0x29, 0x05, 0x91, 0x02, 0x95, 0x01, 0x75, 0x03, 0x91, 0x01, 0x95, 0x06,
+    0x75, 0x08, 0x15, 0x00, 0x25, 0x65, 0x05, 0x07, 0x19, 0x00, 0x29, 0x65, 0x81, 0x00, 0xC0};
+// Left Shift, W, Space, A
+static const uint8_t boot_keyboard_report[] = {0x02, 0x00, 0x1A, 0x2C, 0x04, 0x00, 0x00, 0x00};
+
+// HID 1.11 appendix B.2
+static const uint8_t boot_mouse[] = {
+    0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x09, 0x01, 0xA1, 0x00, 0x05, 0x09, 0x19, 0x01, 0x29, 0x03,
+    0x15, 0x00, 0x25, 0x01, 0x95, 0x03, 0x75, 0x01, 0x81, 0x02, 0x95, 0x01, 0x75, 0x05, 0x81, 0x01,
+    0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x15, 0x81, 0x25, 0x7F, 0x75, 0x08, 0x95, 0x02, 0x81, 0x06,
+    0xC0, 0xC0};
+static const uint8_t boot_mouse_report[] = {0x01, 0x05, 0xFD};
+
+// Generic gamepad: six signed 8-bit axes, a 1..8 hat and 32 buttons
+static const uint8_t gamepad[] = {
+    0x05, 0x01, 0x09, 0x05, 0xA1, 0x01, 0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x09, 0x32, 0x09, 0x35,
+    0x09, 0x33, 0x09, 0x34, 0x15, 0x81, 0x25, 0x7F, 0x95, 0x06, 0x75, 0x08, 0x81, 0x02, 0x05, 0x01,
+    0x09, 0x39, 0x15, 0x01, 0x25, 0x08, 0x35, 0x00, 0x46, 0x3B, 0x01, 0x95, 0x01, 0x75, 0x08, 0x81,
+    0x02, 0x05, 0x09, 0x19, 0x01, 0x29, 0x20, 0x15, 0x00, 0x25, 0x01, 0x95, 0x20, 0x75, 0x01, 0x81,
+    0x02, 0xC0};
+// X right, Y up, Rx full, hat east, buttons 1 and 10
+static const uint8_t gamepad_report[] = {0x7F, 0x81, 0x00, 0x00, 0x7F, 0x00, 0x03, 0x01, 0x02, 0x00, 0x00};
+
+// Input report 1 of a DualShock 4: report ID, unsigned sticks on X/Y/Z/Rz,
+// a nibble hat with a null state, 14 buttons, a counter and the triggers on
+// Rx/Ry, then vendor data
+static const uint8_t dualshock4[] = {
+    0x05, 0x01, 0x09, 0x05, 0xA1, 0x01, 0x85, 0x01, 0x09, 0x30, 0x09, 0x31, 0x09, 0x32, 0x09, 0x35,
+    0x15, 0x00, 0x26, 0xFF, 0x00, 0x75, 0x08, 0x95, 0x04, 0x81, 0x02, 0x09, 0x39, 0x15, 0x00, 0x25,
+    0x07, 0x35, 0x00, 0x46, 0x3B, 0x01, 0x65, 0x14, 0x75, 0x04, 0x95, 0x01, 0x81, 0x42, 0x65, 0x00,
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x0E, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x0E, 0x81, 0x02,
+    0x06, 0x00, 0xFF, 0x09, 0x20, 0x75, 0x06, 0x95, 0x01, 0x15, 0x00, 0x25, 0x7F, 0x81, 0x02, 0x05,
+    0x01, 0x09, 0x33, 0x09, 0x34, 0x15, 0x00, 0x26, 0xFF, 0x00, 0x75, 0x08, 0x95, 0x02, 0x81, 0x02,
+    0x06, 0x00, 0xFF, 0x09, 0x21, 0x95, 0x36, 0x81, 0x02, 0x85, 0x05, 0x09, 0x22, 0x95, 0x1F, 0x91,
+    0x02, 0xC0};
+// Hat released, buttons 2 and 5, L2 pressed
+static const uint8_t dualshock4_report[] = {0x01, 0x80, 0x00, 0xFF, 0x80, 0x28, 0x01, 0xFC, 0xFF, 0x00};
+static const uint8_t dualshock4_other[] = {0x05, 0x00};
+
+// Gaming mouse: report ID 1 with five buttons, 16-bit X/Y and a wheel, and
+// a consumer control collection on report ID 2
+static const uint8_t mouse16[] = {
+    0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x85, 0x01, 0x09, 0x01, 0xA1, 0x00, 0x05, 0x09, 0x19, 0x01,
+    0x29, 0x05, 0x15, 0x00, 0x25, 0x01, 0x95, 0x05, 0x75, 0x01, 0x81, 0x02, 0x95, 0x01, 0x75, 0x03,
+    0x81, 0x01, 0x05, 0x01, 0x16, 0x01, 0x80, 0x26, 0xFF, 0x7F, 0x75, 0x10, 0x95, 0x02, 0x09, 0x30,
+    0x09, 0x31, 0x81, 0x06, 0x15, 0x81, 0x25, 0x7F, 0x75, 0x08, 0x95, 0x01, 0x09, 0x38, 0x81, 0x06,
+    0xC0, 0xC0, 0x05, 0x0C, 0x09, 0x01, 0xA1, 0x01, 0x85, 0x02, 0x19, 0x00, 0x2A, 0x3C, 0x02, 0x15,
+    0x00, 0x26, 0x3C, 0x02, 0x95, 0x01, 0x75, 0x10, 0x81, 0x00, 0xC0};
+static const uint8_t mouse16_report[] = {0x01, 0x04, 0x00, 0x01, 0xF0, 0xFF, 0x01};
+static const uint8_t mouse16_other[] = {0x02, 0xE9, 0x00};
+
+#define ENTRY(d) .desc = d, .len = sizeof(d)
+#define REPORT(r) .report = r, .report_len = sizeof(r)
+#define IGNORED(r) .ignored = r, .ignored_len = sizeof(r)
+
+static const corpus_entry_t corpus[] = {
+    {"boot keyboard", ENTRY(boot_keyboard), REPORT(boot_keyboard_report),
+     {.buttons = 0x1040, .thumb_lx = -32767, .thumb_ly = 32767}},
+    {"boot mouse", ENTRY(boot_mouse), REPORT(boot_mouse_report),
+     {.right_trigger = 255, .mouse_x = 5, .mouse_y = -3}},
+    {"gamepad", ENTRY(gamepad), REPORT(gamepad_report),
+     {.buttons = 0x1018, .left_trigger = 255, .right_trigger = 127, .thumb_lx = 32767, .thumb_ly = 32767,
+      .thumb_rx = -1, .thumb_ry = 0}},
+    {"dualshock 4", ENTRY(dualshock4), REPORT(dualshock4_report),
+     {.buttons = 0x2100, .left_trigger = 255, .thumb_lx = 128, .thumb_ly = 32767, .thumb_rx = 32767,
+      .thumb_ry = -129},
+     IGNORED(dualshock4_other)},
+    {"mouse 16-bit", ENTRY(mouse16), REPORT(mouse16_report), {.buttons = 0x0080, .mouse_x = 256, .mouse_y = -16},
+     IGNORED(mouse16_other)},
+};
+
+static const char *const kind_names[] = {"axis", "mouse", "hat", "bits", "array"};
+static const char *const ctrl_names[] = {"lx", "ly", "rx", "ry", "lt", "rt", "mouse_x", "mouse_y"};
+static const char *const map_names[] = {"pad", "mouse", "keys"};
+
+static void print_program(hid_program_t const *prog)
+{
+  printf("  %u ops, %u byte reports%s\n", prog->count, prog->report_bytes, prog->report_ids ? ", report IDs" : "");
+  for (uint8_t i = 0; i < prog->count; i++)
+  {
+    hid_op_t const *op = &prog->op[i];
+    bool buttons = op->kind == HID_OP_BITS || op->kind == HID_OP_ARRAY;
+    printf("  id %3u bit %4u  %2u x %2u  %-5s %-7s", op->report_id, op->offset, op->count, op->size,
+           kind_names[op->kind], op->kind == HID_OP_HAT ? "dpad" : buttons ? map_names[op->target] : ctrl_names[op->target]);
+    if (buttons)
+    {
+      printf(" usage 0x%02x", op->usage);
+    }
+    printf(" min %d\n", op->min);
+  }
+}
+
+static void print_pad(hid_pad_t const *p)
+{
+  printf("buttons 0x%04x lt %u rt %u lx %d ly %d rx %d ry %d mouse %d,%d", p->buttons, p->left_trigger,
+         p->right_trigger, p->thumb_lx, p->thumb_ly, p->thumb_rx, p->thumb_ry, p->mouse_x, p->mouse_y);
+}
+
+static double bench(hid_program_t const *prog)
+{
+  uint16_t len = prog->report_bytes ? prog->report_bytes : 1;
+  uint8_t *reports = malloc((size_t)len * 256);
+  if (!reports)
+  {
+    perror("malloc");
+    exit(1);
+  }
+  srand(1);
+  for (size_t i = 0; i < (size_t)len * 256; i++)
+  {
+    reports[i] = (uint8_t)rand();
+  }
+  // Keep a valid report ID in front so every report runs through the ops
+  for (int i = 0; i < 256 && prog->report_ids && prog->count; i++)
+  {
+    reports[(size_t)i * len] = prog->op[i % prog->count].report_id;
+  }
+
+  hid_pad_t pad;
+  volatile uint32_t sink = 0;
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (uint32_t i = 0; i < BENCH_REPORTS; i++)
+  {
+    if (hid_program_decode(prog, &reports[(size_t)(i & 255) * len], len, &pad))
+    {
+      sink += pad.buttons;
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  (void)sink;
+  free(reports);
+  return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / BENCH_REPORTS;
+}
+
+static bool check(corpus_entry_t const *e)
+{
+  hid_program_t prog;
+  bool ok = hid_program_compile(e->desc, e->len, &prog) > 0;
+  printf("%s: %s\n", e->name, ok ? "compiled" : "nothing usable");
+  print_program(&prog);
+
+  hid_pad_t pad;
+  if (ok && !hid_program_decode(&prog, e->report, e->report_len, &pad))
+  {
+    printf("  FAIL sample report not decoded\n");
+    ok = false;
+  }
+  else if (ok && memcmp(&pad, &e->expect, sizeof(pad)) != 0)
+  {
+    printf("  FAIL got      ");
+    print_pad(&pad);
+    printf("\n       expected ");
+    print_pad(&e->expect);
+    printf("\n");
+    ok = false;
+  }
+  if (ok && e->ignored && hid_program_decode(&prog, e->ignored, e->ignored_len, &pad))
+  {
+    printf("  FAIL report ID %u should be ignored\n", e->ignored[0]);
+    ok = false;
+  }
+
+  if (ok)
+  {
+    printf("  ok, %.1f ns per report\n", bench(&prog));
+  }
+  return ok;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned failed = 0;
+  for (size_t i = 0; i < sizeof(corpus) / sizeof(corpus[0]); i++)
+  {
+    failed += !check(&corpus[i]);
+  }
+
+  for (int i = 1; i < argc; i++)
+  {
+    static uint8_t desc[4096];
+    FILE *f = fopen(argv[i], "rb");
+    if (!f)
+    {
+      perror(argv[i]);
+      return 1;
+    }
+    uint16_t len = (uint16_t)fread(desc, 1, sizeof(desc), f);
+    fclose(f);
+
+    hid_program_t prog;
+    uint8_t ops = hid_program_compile(desc, len, &prog);
+    printf("%s: %u bytes, %s\n", argv[i], len, ops ? "compiled" : "nothing usable");
+    print_program(&prog);
+    if (ops)
+    {
+      printf("  %.1f ns per report\n", bench(&prog));
+    }
+  }
+
+  printf("%u of %zu built-in checks failed\n", failed, sizeof(corpus) / sizeof(corpus[0]));
+  return failed ? 1 : 0;
+}
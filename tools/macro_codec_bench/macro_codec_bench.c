@@ -0,0 +1,323 @@
+// Check and time the firmware's macro timeline codec.
+//
+//   macro_codec_bench [-s slot] [samples.csv]
+//
+// Reads the processed pad state (out_*) of one slot from the sample lines of
+// a telemetry_decode CSV, or generates a synthetic session when no file is
+// given, records it with src/macro_codec.c the way the firmware does and
+// prints:
+//   size     recording against 16 bytes per report (timestamp and pad)
+//   check    every decoded event matches the recorded state and time
+//   speed    encode time per report, decode time per event
+//   fuzz     random bytes never decode past their end
+// Exits with 1 if a check fails.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "macro_codec.h"
+
+// What a report costs uncompressed, rx_us plus telemetry_pad_t
+#define RAW_REPORT_BYTES (4 + sizeof(telemetry_pad_t))
+
+#define BENCH_MIN_NS 200000000.0
+#define FUZZ_ROUNDS 1000000
+
+typedef struct
+{
+  uint32_t t_us;
+  telemetry_pad_t pad;
+} sample_t;
+
+typedef struct
+{
+  sample_t *s;
+  size_t len;
+  size_t cap;
+} trace_t;
+
+static sample_t *trace_add(trace_t *tr)
+{
+  if (tr->len == tr->cap)
+  {
+    tr->cap = tr->cap ? tr->cap * 2 : 4096;
+    tr->s = realloc(tr->s, tr->cap * sizeof(*tr->s));
+    if (!tr->s)
+    {
+      perror("realloc");
+      exit(1);
+    }
+  }
+  sample_t *s = &tr->s[tr->len++];
+  memset(s, 0, sizeof(*s));
+  return s;
+}
+
+// kind,seq,slot,rx_us,forward_us,age_us,raw_buttons..raw_ry,out_buttons..out_ry
+static void load_csv(FILE *f, unsigned want_slot, trace_t *tr)
+{
+  char line[512];
+  while (fgets(line, sizeof(line), f))
+  {
+    unsigned seq, slot, rx_us, forward_us, age_us, raw[3], buttons, lt, rt;
+    int raw_sticks[4], lx, ly, rx, ry;
+    if (sscanf(line, "sample,%u,%u,%u,%u,%u,%u,%u,%u,%d,%d,%d,%d,%u,%u,%u,%d,%d,%d,%d", &seq, &slot, &rx_us,
+               &forward_us, &age_us, &raw[0], &raw[1], &raw[2], &raw_sticks[0], &raw_sticks[1], &raw_sticks[2],
+               &raw_sticks[3], &buttons, &lt, &rt, &lx, &ly, &rx, &ry) != 19 ||
+        slot != want_slot)
+    {
+      continue;
+    }
+    sample_t *s = trace_add(tr);
+    s->t_us = rx_us;
+    s->pad = (telemetry_pad_t){
+        .buttons = (uint16_t)buttons,
+        .left_trigger = (uint8_t)lt,
+        .right_trigger = (uint8_t)rt,
+        .thumb_lx = (int16_t)lx,
+        .thumb_ly = (int16_t)ly,
+        .thumb_rx = (int16_t)rx,
+        .thumb_ry = (int16_t)ry,
+    };
+  }
+}
+
+static int16_t clamp16(double v)
+{
+  return (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : lround(v));
+}
+
+// 60 s at 1 kHz as it leaves the pipeline: the sticks rest inside the
+// deadzone, sweep and flick with a little sensor noise on top, buttons are
+// tapped and held and the triggers pulled now and then
+static void synthesize(trace_t *tr)
+{
+  srand(1);
+  uint32_t t = 1000000;
+  uint16_t buttons = 0;
+  uint32_t release_us = 0;
+  for (uint32_t n = 0; n < 60000; n++)
+  {
+    t += 1000 + (uint32_t)(rand() % 20) - 10;
+    double sec = n / 1000.0;
+    int moving = fmod(sec, 10.0) > 4.0;
+
+    if (!buttons && rand() % 400 == 0)
+    {
+      buttons = (uint16_t)(1u << (rand() % 16));
+      release_us = t + 40000 + (uint32_t)(rand() % 400000);
+    }
+    else if (buttons && (int32_t)(t - release_us) >= 0)
+    {
+      buttons = 0;
+    }
+
+    sample_t *s = trace_add(tr);
+    s->t_us = t;
+    s->pad.buttons = buttons;
+    s->pad.left_trigger = (uint8_t)(fmod(sec, 7.0) < 1.0 ? 255 * sin(M_PI * fmod(sec, 7.0)) : 0);
+    s->pad.right_trigger = (uint8_t)(fmod(sec, 3.0) < 0.3 ? 255 : 0);
+    if (moving)
+    {
+      s->pad.thumb_lx = clamp16(25000 * sin(2 * M_PI * 0.5 * sec) + (rand() % 61) - 30);
+      s->pad.thumb_ly = clamp16(25000 * cos(2 * M_PI * 0.5 * sec) + (rand() % 61) - 30);
+      s->pad.thumb_rx = clamp16((fmod(sec, 1.0) < 0.5 ? 32767 : -32768) * fmin(1.0, fmod(sec, 0.5) * 20));
+      s->pad.thumb_ry = clamp16(8000 * sin(2 * M_PI * 2 * sec));
+    }
+  }
+}
+
+static double elapsed_ns(struct timespec const *t0, struct timespec const *t1)
+{
+  return (t1->tv_sec - t0->tv_sec) * 1e9 + (t1->tv_nsec - t0->tv_nsec);
+}
+
+// Record the trace, returns the length of the recording
+static size_t record(trace_t const *tr, uint8_t *out, uint32_t *events)
+{
+  macro_codec_t c;
+  macro_codec_reset(&c, tr->s[0].t_us);
+  size_t len = 0;
+  *events = 0;
+  for (size_t k = 0; k < tr->len; k++)
+  {
+    uint8_t n = macro_encode(&c, tr->s[k].t_us, &tr->s[k].pad, out + len);
+    len += n;
+    *events += n != 0;
+  }
+  return len;
+}
+
+// Replay the recording against the trace, every event must land on the
+// report that produced it
+static int verify(trace_t const *tr, uint8_t const *rec, size_t len, uint32_t events)
+{
+  macro_codec_t c;
+  macro_codec_reset(&c, 0);
+  telemetry_pad_t state = {0};
+  uint32_t decoded = 0;
+  size_t pos = 0;
+  for (size_t k = 0; k < tr->len; k++)
+  {
+    if (memcmp(&tr->s[k].pad, &state, sizeof(state)) == 0)
+    {
+      continue;
+    }
+    state = tr->s[k].pad;
+
+    uint8_t n = macro_decode(&c, rec + pos, (uint32_t)(len - pos));
+    if (n == 0 || memcmp(&c.pad, &state, sizeof(state)) != 0 || c.t_us != tr->s[k].t_us - tr->s[0].t_us)
+    {
+      fprintf(stderr, "mismatch at report %zu, byte %zu\n", k, pos);
+      return 0;
+    }
+    pos += n;
+    decoded++;
+  }
+  if (pos != len || decoded != events)
+  {
+    fprintf(stderr, "%zu of %zu bytes, %u of %u events decoded\n", pos, len, decoded, events);
+    return 0;
+  }
+  return 1;
+}
+
+// Decoding must never read past the end nor claim more than it was given
+static int fuzz(void)
+{
+  uint8_t buf[64];
+  macro_codec_t c;
+  macro_codec_reset(&c, 0);
+  for (uint32_t round = 0; round < FUZZ_ROUNDS; round++)
+  {
+    uint32_t len = 1 + (uint32_t)(rand() % (int)sizeof(buf));
+    for (uint32_t i = 0; i < len; i++)
+    {
+      // Mostly small values so the varints end early enough to reach a mask
+      buf[i] = (uint8_t)(rand() % 3 ? rand() % 0x80 : rand());
+    }
+    for (uint32_t pos = 0, n; pos < len; pos += n)
+    {
+      n = macro_decode(&c, buf + pos, len - pos);
+      if (n > len - pos)
+      {
+        fprintf(stderr, "fuzz: decoded %u of %u bytes\n", n, len - pos);
+        return 0;
+      }
+      if (n == 0)
+      {
+        break;
+      }
+    }
+  }
+  return 1;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned slot = 0;
+  int opt = 1;
+  if (opt + 1 < argc && strcmp(argv[opt], "-s") == 0)
+  {
+    slot = (unsigned)strtoul(argv[opt + 1], NULL, 0);
+    opt += 2;
+  }
+  if (opt < argc && argv[opt][0] == '-')
+  {
+    fprintf(stderr, "usage: %s [-s slot] [samples.csv]\n", argv[0]);
+    return 1;
+  }
+
+  trace_t tr = {0};
+  if (opt < argc)
+  {
+    FILE *f = fopen(argv[opt], "r");
+    if (!f)
+    {
+      perror(argv[opt]);
+      return 1;
+    }
+    load_csv(f, slot, &tr);
+    fclose(f);
+  }
+  else
+  {
+    synthesize(&tr);
+  }
+  if (tr.len < 2)
+  {
+    fprintf(stderr, "no samples\n");
+    return 1;
+  }
+
+  uint8_t *rec = malloc(tr.len * MACRO_EVENT_MAX);
+  if (!rec)
+  {
+    perror("malloc");
+    return 1;
+  }
+
+  uint32_t events;
+  size_t len = record(&tr, rec, &events);
+  double raw = (double)tr.len * RAW_REPORT_BYTES;
+  double raw_events = (double)events * RAW_REPORT_BYTES;
+  printf("%zu reports over %.1f s, %u changed\n", tr.len, (tr.s[tr.len - 1].t_us - tr.s[0].t_us) / 1e6, events);
+  printf("size     %zu bytes, %.2f per event, %.1fx smaller than every report raw (%.0f bytes), "
+         "%.1fx smaller than the changed ones raw (%.0f bytes)\n",
+         len, events ? (double)len / events : 0.0, len ? raw / len : 0.0, raw, len ? raw_events / len : 0.0,
+         raw_events);
+
+  int ok = verify(&tr, rec, len, events);
+  printf("check    %s\n", ok ? "ok" : "FAILED");
+
+  // Repeat whole recordings until the timing is long enough to trust
+  struct timespec t0, t1;
+  uint32_t rounds = 0;
+  uint8_t *scratch = malloc(tr.len * MACRO_EVENT_MAX);
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  do
+  {
+    uint32_t e;
+    record(&tr, scratch, &e);
+    rounds++;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+  } while (elapsed_ns(&t0, &t1) < BENCH_MIN_NS);
+  double encode_ns = elapsed_ns(&t0, &t1) / ((double)rounds * tr.len);
+  free(scratch);
+
+  volatile uint32_t sink = 0;
+  rounds = 0;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  do
+  {
+    macro_codec_t c;
+    macro_codec_reset(&c, 0);
+    for (size_t pos = 0, n; pos < len; pos += n)
+    {
+      n = macro_decode(&c, rec + pos, (uint32_t)(len - pos));
+      if (n == 0)
+      {
+        break;
+      }
+    }
+    sink += c.pad.buttons;
+    rounds++;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+  } while (elapsed_ns(&t0, &t1) < BENCH_MIN_NS);
+  (void)sink;
+  double decode_ns = events ? elapsed_ns(&t0, &t1) / ((double)rounds * events) : 0.0;
+  double decode_mbs = len ? (double)rounds * len / (elapsed_ns(&t0, &t1) / 1e9) / 1e6 : 0.0;
+  printf("speed    encode %.1f ns/report (%.1f MB/s of reports), decode %.1f ns/event (%.1f MB/s of recording)\n",
+         encode_ns, RAW_REPORT_BYTES / encode_ns * 1e3, decode_ns, decode_mbs);
+
+  int fuzz_ok = fuzz();
+  printf("fuzz     %u random buffers %s\n", FUZZ_ROUNDS, fuzz_ok ? "ok" : "FAILED");
+
+  free(rec);
+  free(tr.s);
+  return ok && fuzz_ok ? 0 : 1;
+}
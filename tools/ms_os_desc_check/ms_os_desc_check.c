@@ -0,0 +1,226 @@
+// Validate the Microsoft OS and BOS descriptors of src/ms_os_desc.c against
+// the MS OS 1.0 and 2.0 specifications, for the PT_XINPUT_PADS it was
+// built with.
+//
+//   ms_os_desc_check_<pads> [-v]
+//
+// Walks every descriptor by its own length fields, checks that the totals
+// add up, that the BOS announces the descriptor set Windows will request
+// and that every XInput interface, and nothing else, gets the XUSB10
+// compatible ID. -v dumps the blobs. Exits with 1 if a check fails.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ms_os_desc.h"
+#include "usb_descriptors.h"
+
+static const uint8_t ms_os_2_0_uuid[16] = {0xDF, 0x60, 0xDD, 0xD8, 0x89, 0x45, 0xC7, 0x4C,
+                                           0x9C, 0xD2, 0x65, 0x9D, 0x9E, 0x64, 0x8A, 0x9F};
+static const uint8_t xusb10[8] = {'X', 'U', 'S', 'B', '1', '0', 0, 0};
+
+static unsigned failures;
+
+#define CHECK(_cond, ...)             \
+  do                                  \
+  {                                   \
+    if (!(_cond))                     \
+    {                                 \
+      printf("  FAIL: " __VA_ARGS__); \
+      printf("\n");                   \
+      failures++;                     \
+    }                                 \
+  } while (0)
+
+static uint16_t le16(uint8_t const *p)
+{
+  return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t le32(uint8_t const *p)
+{
+  return (uint32_t)le16(p) | (uint32_t)le16(p + 2) << 16;
+}
+
+static bool all_zero(uint8_t const *p, unsigned n)
+{
+  while (n--)
+  {
+    if (*p++)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void dump(const char *name, uint8_t const *p, unsigned len)
+{
+  printf("%s (%u bytes)\n", name, len);
+  for (unsigned i = 0; i < len; i++)
+  {
+    printf("%s%02x", i % 16 ? " " : "  ", p[i]);
+    if (i % 16 == 15 || i == len - 1)
+    {
+      printf("\n");
+    }
+  }
+}
+
+static void check_ms_os_1_0(void)
+{
+  uint8_t const *d = ms_os_1_0_compat_id;
+  printf("MS OS 1.0 extended compat ID\n");
+  CHECK(le32(d) == sizeof(ms_os_1_0_compat_id), "dwLength %u", (unsigned)le32(d));
+  CHECK(le16(d + 4) == 0x0100, "bcdVersion %04x", le16(d + 4));
+  CHECK(le16(d + 6) == MS_OS_1_0_COMPAT_ID_INDEX, "wIndex %u", le16(d + 6));
+  CHECK(d[8] == PT_XINPUT_PADS, "bCount %u", d[8]);
+  CHECK(all_zero(d + 9, 7), "reserved header bytes");
+
+  for (unsigned i = 0; i < PT_XINPUT_PADS; i++)
+  {
+    uint8_t const *f = d + 16 + 24 * i;
+    CHECK(f[0] == ITF_NUM_XINPUT + i, "function %u: bFirstInterface %u", i, f[0]);
+    CHECK(f[1] == 1 || f[1] == 0, "function %u: reserved byte", i);
+    CHECK(memcmp(f + 2, xusb10, 8) == 0, "function %u: compatibleID", i);
+    CHECK(all_zero(f + 10, 14), "function %u: subCompatibleID/reserved", i);
+  }
+}
+
+static void check_ms_os_2_0(void)
+{
+  uint8_t const *d = ms_os_2_0_set;
+  unsigned len = sizeof(ms_os_2_0_set);
+  printf("MS OS 2.0 descriptor set\n");
+
+  // Set header
+  CHECK(le16(d) == 10 && le16(d + 2) == 0x00, "set header wLength/wDescriptorType");
+  CHECK(le32(d + 4) >= 0x06030000, "dwWindowsVersion %08x", (unsigned)le32(d + 4));
+  CHECK(le16(d + 8) == len, "set wTotalLength %u, blob is %u", le16(d + 8), len);
+
+  // Configuration subset spanning the rest
+  uint8_t const *c = d + 10;
+  CHECK(le16(c) == 8 && le16(c + 2) == 0x01, "configuration subset wLength/wDescriptorType");
+  CHECK(c[4] == 0, "bConfigurationValue %u, must be the index of the only configuration", c[4]);
+  CHECK(le16(c + 6) == len - 10, "configuration wTotalLength %u", le16(c + 6));
+
+  // Function subsets, one per XInput interface in order
+  unsigned pos = 18, functions = 0;
+  while (pos + 4 <= len)
+  {
+    uint8_t const *f = d + pos;
+    uint16_t flen = le16(f), type = le16(f + 2);
+    if (flen < 4 || pos + flen > len)
+    {
+      CHECK(false, "descriptor at %u has wLength %u", pos, flen);
+      return;
+    }
+    if (type != 0x02)
+    {
+      CHECK(false, "descriptor type %u at %u outside a function subset", type, pos);
+      pos += flen;
+      continue;
+    }
+
+    CHECK(flen == 8, "function subset wLength %u", flen);
+    CHECK(f[4] == ITF_NUM_XINPUT + functions, "function %u: bFirstInterface %u", functions, f[4]);
+    uint16_t subset = le16(f + 6);
+    CHECK(subset >= 8 && pos + subset <= len, "function %u: wSubsetLength %u", functions, subset);
+
+    // Its features
+    bool compat = false;
+    for (unsigned p = pos + flen; p + 4 <= pos + subset; p += le16(d + p))
+    {
+      uint8_t const *feat = d + p;
+      if (le16(feat) < 4)
+      {
+        CHECK(false, "feature at %u has wLength %u", p, le16(feat));
+        break;
+      }
+      if (le16(feat + 2) == 0x03)
+      {
+        CHECK(le16(feat) == 20, "compatible ID wLength %u", le16(feat));
+        CHECK(memcmp(feat + 4, xusb10, 8) == 0, "function %u: compatibleID", functions);
+        CHECK(all_zero(feat + 12, 8), "function %u: subCompatibleID", functions);
+        compat = true;
+      }
+    }
+    CHECK(compat, "function %u has no compatible ID", functions);
+
+    functions++;
+    pos += subset;
+  }
+  CHECK(pos == len, "trailing bytes after the last function subset");
+  CHECK(functions == PT_XINPUT_PADS, "%u function subsets for %u XInput interfaces", functions, PT_XINPUT_PADS);
+}
+
+// Returns the MS OS 2.0 platform capability of a BOS, NULL if it has none
+static uint8_t const *check_bos(const char *name, uint8_t const *d, unsigned len)
+{
+  printf("%s\n", name);
+  CHECK(d[0] == 5 && d[1] == 0x0F, "BOS bLength/bDescriptorType");
+  CHECK(le16(d + 2) == len, "BOS wTotalLength %u, blob is %u", le16(d + 2), len);
+
+  uint8_t const *ms_os = NULL;
+  unsigned pos = 5, caps = 0;
+  while (pos + 3 <= len)
+  {
+    uint8_t const *c = d + pos;
+    if (c[0] < 3 || pos + c[0] > len)
+    {
+      CHECK(false, "capability at %u has bLength %u", pos, c[0]);
+      return NULL;
+    }
+    CHECK(c[1] == 0x10, "capability %u bDescriptorType %02x", caps, c[1]);
+    if (c[2] == 0x02)
+    {
+      CHECK(c[0] == 7, "USB 2.0 extension bLength %u", c[0]);
+    }
+    else if (c[2] == 0x05 && c[0] >= 20 && memcmp(c + 4, ms_os_2_0_uuid, 16) == 0)
+    {
+      CHECK(c[0] == 28, "MS OS 2.0 platform capability bLength %u", c[0]);
+      ms_os = c;
+    }
+    caps++;
+    pos += c[0];
+  }
+  CHECK(pos == len, "trailing bytes after the last capability");
+  CHECK(d[4] == caps, "bNumDeviceCaps %u, found %u", d[4], caps);
+  return ms_os;
+}
+
+int main(int argc, char **argv)
+{
+  bool verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+  printf("%u XInput interface(s) from interface %u\n", PT_XINPUT_PADS, ITF_NUM_XINPUT);
+
+  check_ms_os_1_0();
+  check_ms_os_2_0();
+
+  CHECK(check_bos("BOS without XInput", usb_bos_plain, sizeof(usb_bos_plain)) == NULL,
+        "HID personality BOS announces MS OS 2.0");
+
+  uint8_t const *cap = check_bos("BOS with XInput", usb_bos_ms_os, sizeof(usb_bos_ms_os));
+  CHECK(cap != NULL, "no MS OS 2.0 platform capability");
+  if (cap)
+  {
+    // The request Windows derives from it must be the one the firmware serves
+    CHECK(le32(cap + 20) == le32(ms_os_2_0_set + 4), "dwWindowsVersion differs from the set header");
+    CHECK(le16(cap + 24) == sizeof(ms_os_2_0_set), "wMSOSDescriptorSetTotalLength %u", le16(cap + 24));
+    CHECK(cap[26] == MS_OS_2_0_VENDOR_CODE, "bMS_VendorCode %02x", cap[26]);
+    CHECK(cap[27] == 0, "bAltEnumCode %u", cap[27]);
+  }
+
+  if (verbose)
+  {
+    dump("ms_os_1_0_compat_id", ms_os_1_0_compat_id, sizeof(ms_os_1_0_compat_id));
+    dump("ms_os_2_0_set", ms_os_2_0_set, sizeof(ms_os_2_0_set));
+    dump("usb_bos_plain", usb_bos_plain, sizeof(usb_bos_plain));
+    dump("usb_bos_ms_os", usb_bos_ms_os, sizeof(usb_bos_ms_os));
+  }
+
+  printf("%u check(s) failed\n", failures);
+  return failures ? 1 : 0;
+}
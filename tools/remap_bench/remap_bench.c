@@ -0,0 +1,241 @@
+// Check and time the firmware's remap stage.
+//
+//   remap_bench [reports]
+//
+// Compiles random mappings with src/remap.c, out-of-range sources included,
+// and compares remap_apply on random reports with a direct per-field
+// reading of the mapping. The identity mapping must leave every report
+// untouched. Then the firmware's per-report work is timed without and with
+// the remap: a plain copy of the report, the same copy followed by
+// remap_apply with the identity mapping, and with a mapping that swaps
+// buttons and sticks and inverts axes. Exits with 1 if a check fails.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "remap.h"
+
+#define DEFAULT_REPORTS 100000000u
+#define BATCH 4096
+#define CONFIGS 10000
+#define CHECK_REPORTS 256
+
+static uint32_t rng = 1;
+
+static uint32_t rnd(uint32_t n)
+{
+  rng = rng * 1664525u + 1013904223u;
+  return (rng >> 8) % n;
+}
+
+static void random_report(xinput_report_t *r)
+{
+  static const int16_t extremes[] = {-32768, -32767, -1, 0, 1, 32767};
+  memset(r, 0, sizeof(*r));
+  r->bSize = 0x14;
+  r->bmButtons = (uint16_t)rnd(0x10000);
+  r->bLeftTrigger = (uint8_t)rnd(256);
+  r->bRightTrigger = (uint8_t)rnd(256);
+  int16_t axis[REMAP_STICK_AXES];
+  for (int i = 0; i < REMAP_STICK_AXES; i++)
+  {
+    axis[i] = rnd(4) == 0 ? extremes[rnd(6)] : (int16_t)rnd(0x10000);
+  }
+  r->wThumbLeftX = axis[0];
+  r->wThumbLeftY = axis[1];
+  r->wThumbRightX = axis[2];
+  r->wThumbRightY = axis[3];
+}
+
+// Sources past the valid range now and then, to cover the fallbacks
+static void random_config(remap_config_t *cfg)
+{
+  for (int i = 0; i < REMAP_BUTTON_COUNT; i++)
+  {
+    cfg->button_src[i] = rnd(8) == 0 ? (rnd(2) ? REMAP_NONE : (uint8_t)(REMAP_BUTTON_COUNT + rnd(8)))
+                                     : (uint8_t)rnd(REMAP_BUTTON_COUNT);
+  }
+  for (int i = 0; i < REMAP_STICK_AXES; i++)
+  {
+    cfg->stick_src[i] = (uint8_t)rnd(REMAP_STICK_AXES + 1);
+  }
+  cfg->stick_invert = (uint8_t)rnd(16);
+  for (int i = 0; i < REMAP_TRIGGERS; i++)
+  {
+    cfg->trigger_src[i] = (uint8_t)rnd(REMAP_TRIGGERS + 1);
+  }
+}
+
+// The mapping applied field by field, straight from the config
+static void reference(const remap_config_t *cfg, const xinput_report_t *in, xinput_report_t *out)
+{
+  *out = *in;
+
+  out->bmButtons = 0;
+  for (int i = 0; i < REMAP_BUTTON_COUNT; i++)
+  {
+    uint8_t src = cfg->button_src[i];
+    if (src < REMAP_BUTTON_COUNT && (in->bmButtons & (1u << src)))
+    {
+      out->bmButtons |= (uint16_t)(1u << i);
+    }
+  }
+
+  int16_t const sticks[REMAP_STICK_AXES] = {in->wThumbLeftX, in->wThumbLeftY, in->wThumbRightX, in->wThumbRightY};
+  int16_t axis[REMAP_STICK_AXES];
+  for (int i = 0; i < REMAP_STICK_AXES; i++)
+  {
+    int32_t v = sticks[cfg->stick_src[i] < REMAP_STICK_AXES ? cfg->stick_src[i] : i];
+    // Mirrored around -0.5 so -32768 maps to 32767
+    axis[i] = (int16_t)((cfg->stick_invert & (1u << i)) ? -1 - v : v);
+  }
+  out->wThumbLeftX = axis[0];
+  out->wThumbLeftY = axis[1];
+  out->wThumbRightX = axis[2];
+  out->wThumbRightY = axis[3];
+
+  uint8_t const triggers[REMAP_TRIGGERS] = {in->bLeftTrigger, in->bRightTrigger};
+  out->bLeftTrigger = triggers[cfg->trigger_src[0] < REMAP_TRIGGERS ? cfg->trigger_src[0] : 0];
+  out->bRightTrigger = triggers[cfg->trigger_src[1] < REMAP_TRIGGERS ? cfg->trigger_src[1] : 1];
+}
+
+static int check(void)
+{
+  static remap_table_t table;
+  remap_config_t cfg;
+  xinput_report_t in, got, want;
+
+  remap_config_identity(&cfg);
+  remap_compile(&cfg, &table);
+  for (int k = 0; k < CONFIGS * 4; k++)
+  {
+    random_report(&in);
+    got = in;
+    remap_apply(&table, &got);
+    if (memcmp(&got, &in, sizeof(in)) != 0)
+    {
+      fprintf(stderr, "identity mapping changed a report\n");
+      return 0;
+    }
+  }
+
+  for (int c = 0; c < CONFIGS; c++)
+  {
+    random_config(&cfg);
+    remap_compile(&cfg, &table);
+    for (int k = 0; k < CHECK_REPORTS; k++)
+    {
+      random_report(&in);
+      got = in;
+      remap_apply(&table, &got);
+      reference(&cfg, &in, &want);
+      if (memcmp(&got, &want, sizeof(want)) != 0)
+      {
+        fprintf(stderr, "config %d: report differs from the reference\n", c);
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+// The loops below stay out of line and take the table through a pointer, so
+// the compiler cannot specialise them for one mapping
+__attribute__((noinline)) static uint32_t run_copy(const xinput_report_t *in, uint32_t reports)
+{
+  uint32_t sum = 0;
+  for (uint32_t k = 0; k < reports; k++)
+  {
+    xinput_report_t r = in[k % BATCH];
+    sum += r.bmButtons + (uint16_t)r.wThumbLeftX + (uint16_t)r.wThumbRightY + r.bRightTrigger;
+  }
+  return sum;
+}
+
+__attribute__((noinline)) static uint32_t run_remap(const xinput_report_t *in, uint32_t reports,
+                                                    const remap_table_t *table)
+{
+  uint32_t sum = 0;
+  for (uint32_t k = 0; k < reports; k++)
+  {
+    xinput_report_t r = in[k % BATCH];
+    remap_apply(table, &r);
+    sum += r.bmButtons + (uint16_t)r.wThumbLeftX + (uint16_t)r.wThumbRightY + r.bRightTrigger;
+  }
+  return sum;
+}
+
+static double elapsed_ns(struct timespec const *t0, struct timespec const *t1)
+{
+  return (t1->tv_sec - t0->tv_sec) * 1e9 + (t1->tv_nsec - t0->tv_nsec);
+}
+
+// ns per report, table NULL for the plain copy
+static double time_run(const xinput_report_t *in, uint32_t reports, const remap_table_t *table)
+{
+  static volatile uint32_t sink;
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  sink += table ? run_remap(in, reports, table) : run_copy(in, reports);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  return elapsed_ns(&t0, &t1) / reports;
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t reports = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : DEFAULT_REPORTS;
+  if (reports == 0)
+  {
+    fprintf(stderr, "usage: %s [reports]\n", argv[0]);
+    return 1;
+  }
+
+  int ok = check();
+  printf("check    identity and %d random mappings: %s\n", CONFIGS, ok ? "ok" : "FAILED");
+
+  static xinput_report_t in[BATCH];
+  for (int k = 0; k < BATCH; k++)
+  {
+    random_report(&in[k]);
+  }
+
+  static remap_table_t identity, swapped;
+  remap_config_t cfg;
+  remap_config_identity(&cfg);
+  remap_compile(&cfg, &identity);
+
+  // A and B, X and Y, LB and RB swapped, the sticks swapped and Y inverted
+  cfg.button_src[12] = 13;
+  cfg.button_src[13] = 12;
+  cfg.button_src[14] = 15;
+  cfg.button_src[15] = 14;
+  cfg.button_src[8] = 9;
+  cfg.button_src[9] = 8;
+  cfg.stick_src[0] = 2;
+  cfg.stick_src[1] = 3;
+  cfg.stick_src[2] = 0;
+  cfg.stick_src[3] = 1;
+  cfg.stick_invert = 0x0A;
+  cfg.trigger_src[0] = 1;
+  cfg.trigger_src[1] = 0;
+  remap_compile(&cfg, &swapped);
+
+  // Warm up, then the plain copy last as well, in case the clock ramps up
+  time_run(in, reports / 10 + 1, &swapped);
+  double copy_ns = time_run(in, reports, NULL);
+  double identity_ns = time_run(in, reports, &identity);
+  double swapped_ns = time_run(in, reports, &swapped);
+  double copy2_ns = time_run(in, reports, NULL);
+  if (copy2_ns < copy_ns)
+  {
+    copy_ns = copy2_ns;
+  }
+
+  printf("copy     %u reports, %.2f ns/report\n", reports, copy_ns);
+  printf("identity %u reports, %.2f ns/report, +%.2f ns over the copy\n", reports, identity_ns, identity_ns - copy_ns);
+  printf("swapped  %u reports, %.2f ns/report, +%.2f ns over the copy\n", reports, swapped_ns, swapped_ns - copy_ns);
+  return ok ? 0 : 1;
+}
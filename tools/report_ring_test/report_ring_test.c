@@ -0,0 +1,317 @@
+// Test and time the firmware's report ring.
+//
+//   report_ring_test [frames]
+//
+// Runs the single-threaded cases (empty and full ring, FIFO order,
+// wraparound of the 32-bit indices, latest-wins push and pop and the drop
+// and skip counters), then a producer and a consumer thread move frames
+// through the ring. In FIFO mode the producer retries while the ring is
+// full, in latest-wins mode it overwrites the oldest frame. Every
+// frame carries its sequence number in all of its fields, so a torn or
+// reordered frame shows up. Prints the throughput of
+// each run and exits with 1 if a check fails.
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "report_ring.h"
+
+#define DEFAULT_FRAMES 20000000u
+
+static unsigned failures;
+
+#define CHECK(cond)                                              \
+  do                                                             \
+  {                                                              \
+    if (!(cond))                                                 \
+    {                                                            \
+      fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                                \
+    }                                                            \
+  } while (0)
+
+// Every field derived from seq
+static void frame_make(report_frame_t *f, uint32_t seq)
+{
+  memset(f, 0, sizeof(*f));
+  f->slot = (uint8_t)seq;
+  f->report.bmButtons = (uint16_t)seq;
+  f->report.bLeftTrigger = (uint8_t)(seq >> 8);
+  f->report.bRightTrigger = (uint8_t)(seq >> 16);
+  f->report.wThumbLeftX = (int16_t)seq;
+  f->report.wThumbLeftY = (int16_t)(seq >> 16);
+  f->report.wThumbRightX = (int16_t)~seq;
+  f->report.wThumbRightY = (int16_t)(~seq >> 16);
+#if REPORT_FRAME_TIMESTAMPS
+  f->rx_us = seq;
+#endif
+}
+
+// The sequence number of f, or -1 if its fields disagree
+static int64_t frame_seq(report_frame_t const *f)
+{
+  uint32_t seq = (uint16_t)f->report.wThumbLeftX | (uint32_t)(uint16_t)f->report.wThumbLeftY << 16;
+  report_frame_t want;
+  frame_make(&want, seq);
+  return memcmp(f, &want, sizeof(want)) == 0 ? (int64_t)seq : -1;
+}
+
+static void push_seq(report_ring_t *ring, uint32_t seq)
+{
+  report_frame_t f;
+  frame_make(&f, seq);
+  CHECK(report_ring_push(ring, &f));
+}
+
+static void test_empty_full(void)
+{
+  static report_ring_t ring;
+  report_frame_t f;
+  report_ring_init(&ring);
+  CHECK(!report_ring_pop(&ring, &f));
+  CHECK(!report_ring_pop_latest(&ring, &f));
+
+  for (uint32_t i = 0; i < PT_REPORT_RING_SIZE; i++)
+  {
+    push_seq(&ring, i);
+  }
+  frame_make(&f, 99);
+  CHECK(!report_ring_push(&ring, &f));
+  CHECK(!report_ring_push(&ring, &f));
+  CHECK(ring.dropped == 2);
+
+  for (uint32_t i = 0; i < PT_REPORT_RING_SIZE; i++)
+  {
+    CHECK(report_ring_pop(&ring, &f) && frame_seq(&f) == i);
+  }
+  CHECK(!report_ring_pop(&ring, &f));
+  CHECK(ring.skipped == 0);
+}
+
+// Start the indices just below UINT_MAX so they wrap in the middle
+static void test_wraparound(void)
+{
+  static report_ring_t ring;
+  report_frame_t f;
+  report_ring_init(&ring);
+  atomic_store(&ring.head, ~0u - 2);
+  atomic_store(&ring.tail, ~0u - 2);
+
+  uint32_t next_push = 0, next_pop = 0;
+  for (uint32_t round = 0; round < 4 * PT_REPORT_RING_SIZE; round++)
+  {
+    // Fill up, then drain all but one, so both indices cross the wrap
+    for (;; next_push++)
+    {
+      frame_make(&f, next_push);
+      if (!report_ring_push(&ring, &f))
+      {
+        break;
+      }
+    }
+    CHECK(atomic_load(&ring.head) - atomic_load(&ring.tail) == PT_REPORT_RING_SIZE);
+    for (uint32_t i = 0; i + 1 < PT_REPORT_RING_SIZE; i++)
+    {
+      CHECK(report_ring_pop(&ring, &f) && frame_seq(&f) == next_pop);
+      next_pop++;
+    }
+  }
+  // Both indices went past zero
+  CHECK(atomic_load(&ring.tail) < next_pop);
+  while (report_ring_pop(&ring, &f))
+  {
+    CHECK(frame_seq(&f) == next_pop);
+    next_pop++;
+  }
+  CHECK(next_pop == next_push);
+}
+
+static void test_pop_latest(void)
+{
+  static report_ring_t ring;
+  report_frame_t f;
+  report_ring_init(&ring);
+
+  push_seq(&ring, 1);
+  CHECK(report_ring_pop_latest(&ring, &f) && frame_seq(&f) == 1);
+  CHECK(ring.skipped == 0);
+
+  for (uint32_t i = 10; i < 15; i++)
+  {
+    push_seq(&ring, i);
+  }
+  CHECK(report_ring_pop_latest(&ring, &f) && frame_seq(&f) == 14);
+  CHECK(ring.skipped == 4);
+  CHECK(!report_ring_pop(&ring, &f));
+
+  // A full ring gives up everything but its newest frame
+  for (uint32_t i = 0; i < PT_REPORT_RING_SIZE; i++)
+  {
+    push_seq(&ring, 100 + i);
+  }
+  frame_make(&f, 0);
+  CHECK(!report_ring_push(&ring, &f));
+  CHECK(report_ring_pop_latest(&ring, &f) && frame_seq(&f) == 100 + PT_REPORT_RING_SIZE - 1);
+  CHECK(ring.skipped == 4 + PT_REPORT_RING_SIZE - 1);
+  CHECK(ring.dropped == 1);
+
+  // Room again after the pop
+  push_seq(&ring, 200);
+  CHECK(report_ring_pop(&ring, &f) && frame_seq(&f) == 200);
+}
+
+// A full ring in latest-wins mode still hands over the last frame pushed
+static void test_push_latest(void)
+{
+  static report_ring_t ring;
+  report_frame_t f;
+  report_ring_init(&ring);
+
+  for (uint32_t i = 0; i < PT_REPORT_RING_SIZE + 3; i++)
+  {
+    frame_make(&f, 100 + i);
+    report_ring_push_latest(&ring, &f);
+  }
+  CHECK(report_ring_pop_latest(&ring, &f) && frame_seq(&f) == 100 + PT_REPORT_RING_SIZE + 2);
+  CHECK(ring.skipped == PT_REPORT_RING_SIZE + 2);
+  CHECK(ring.dropped == 0);
+  CHECK(!report_ring_pop_latest(&ring, &f));
+
+  // Lapping the consumer several times, across the index wrap
+  atomic_store(&ring.head, ~0u - 2);
+  atomic_store(&ring.tail, ~0u - 2);
+  for (uint32_t i = 0; i < 5 * PT_REPORT_RING_SIZE; i++)
+  {
+    frame_make(&f, 300 + i);
+    report_ring_push_latest(&ring, &f);
+  }
+  CHECK(report_ring_pop_latest(&ring, &f) && frame_seq(&f) == 300 + 5 * PT_REPORT_RING_SIZE - 1);
+  CHECK(ring.skipped == PT_REPORT_RING_SIZE + 2 + 5 * PT_REPORT_RING_SIZE - 1);
+}
+
+typedef struct
+{
+  report_ring_t ring;
+  uint32_t frames;
+  int latest;          // push_latest and pop_latest
+  atomic_bool done;    // producer finished
+  uint64_t attempts;   // pushes tried, a full ring makes the producer retry
+  uint64_t received;
+  uint64_t bad;        // torn or out of order
+  int64_t last;        // last frame received
+} stress_t;
+
+static void *producer(void *arg)
+{
+  stress_t *st = arg;
+  report_frame_t f;
+  for (uint32_t seq = 0; seq < st->frames;)
+  {
+    frame_make(&f, seq);
+    st->attempts++;
+    if (st->latest)
+    {
+      report_ring_push_latest(&st->ring, &f);
+      seq++;
+      // Never blocks, so give a consumer on the same CPU a turn now and then
+      if (seq % 64 == 0)
+      {
+        sched_yield();
+      }
+    }
+    else if (report_ring_push(&st->ring, &f))
+    {
+      seq++;
+    }
+    else
+    {
+      // Full, let the consumer run when both threads share a CPU
+      sched_yield();
+    }
+  }
+  atomic_store(&st->done, true);
+  return NULL;
+}
+
+static void *consumer(void *arg)
+{
+  stress_t *st = arg;
+  report_frame_t f;
+  int64_t last = -1;
+  for (;;)
+  {
+    // Read done first, so a false pop after it means the ring is drained
+    bool done = atomic_load(&st->done);
+    bool got = st->latest ? report_ring_pop_latest(&st->ring, &f) : report_ring_pop(&st->ring, &f);
+    if (!got)
+    {
+      if (done)
+      {
+        break;
+      }
+      sched_yield();
+      continue;
+    }
+    int64_t seq = frame_seq(&f);
+    // FIFO sees every frame in turn, latest-wins only ever moves forward
+    if (seq < 0 || (st->latest ? seq <= last : seq != last + 1))
+    {
+      st->bad++;
+    }
+    last = seq;
+    st->received++;
+  }
+  st->last = last;
+  return NULL;
+}
+
+static void stress(uint32_t frames, int latest)
+{
+  static stress_t st;
+  memset(&st, 0, sizeof(st));
+  report_ring_init(&st.ring);
+  st.frames = frames;
+  st.latest = latest;
+
+  struct timespec t0, t1;
+  pthread_t prod, cons;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  pthread_create(&cons, NULL, consumer, &st);
+  pthread_create(&prod, NULL, producer, &st);
+  pthread_join(prod, NULL);
+  pthread_join(cons, NULL);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  double sec = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+  CHECK(st.bad == 0);
+  CHECK(st.attempts == (uint64_t)frames + st.ring.dropped);
+  CHECK(st.received + st.ring.skipped == frames);
+  CHECK(latest || st.received == frames);
+  // Neither mode may lose the newest frame
+  CHECK(st.last == (int64_t)frames - 1);
+  printf("%-6s %u frames, %llu received, %lu skipped, %lu pushes hit a full ring, %llu bad, %.1f M frames/s, "
+         "%.1f ns/frame\n",
+         latest ? "latest" : "fifo", frames, (unsigned long long)st.received, (unsigned long)st.ring.skipped,
+         (unsigned long)st.ring.dropped, (unsigned long long)st.bad, frames / sec / 1e6, sec * 1e9 / frames);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t frames = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : DEFAULT_FRAMES;
+
+  test_empty_full();
+  test_wraparound();
+  test_pop_latest();
+  test_push_latest();
+  printf("unit   %s\n", failures ? "FAILED" : "ok");
+
+  stress(frames, 0);
+  stress(frames, 1);
+
+  printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,289 @@
+// Replay stick traces through the firmware's stick filter.
+//
+//   stick_filter_bench [-m min_cutoff] [-b beta] [-d d_cutoff] [samples.csv]
+//
+// Reads the sample lines of a telemetry_decode CSV, or generates a noisy
+// synthetic trace when no file is given, runs every pad's sticks through
+// src/stick_filter.c with all four axes enabled and prints per axis:
+//   jitter   RMS of the second difference, input -> output
+//   lag      delay of the output against the noise-free signal (the input
+//            for a CSV), fitted at 1/16 sample resolution
+//   error    RMS distance to the noise-free signal (synthetic trace only)
+// and, for the whole filter, the time a resting stick takes to cover 90% of
+// a small and of a large step, interpolated between reports. Exits 1 if
+// the filter moves any axis of the synthetic trace further from the
+// noise-free signal than the raw input is.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stick_filter.h"
+
+#define MAX_LAG 64
+
+// Lag resolution, in fractions of a sample
+#define LAG_STEPS 16
+
+typedef struct
+{
+  uint32_t t_us;
+  uint8_t slot;
+  int16_t in[STICK_FILTER_AXES];
+  int16_t truth[STICK_FILTER_AXES];
+  int16_t out[STICK_FILTER_AXES];
+} sample_t;
+
+typedef struct
+{
+  sample_t *s;
+  size_t len;
+  size_t cap;
+  int synthetic;
+} trace_t;
+
+static const char *const axis_names[STICK_FILTER_AXES] = {"lx", "ly", "rx", "ry"};
+
+static sample_t *trace_add(trace_t *tr)
+{
+  if (tr->len == tr->cap)
+  {
+    tr->cap = tr->cap ? tr->cap * 2 : 4096;
+    tr->s = realloc(tr->s, tr->cap * sizeof(*tr->s));
+    if (!tr->s)
+    {
+      perror("realloc");
+      exit(1);
+    }
+  }
+  sample_t *s = &tr->s[tr->len++];
+  memset(s, 0, sizeof(*s));
+  return s;
+}
+
+// kind,seq,slot,rx_us,forward_us,age_us,buttons,lt,rt,lx,ly,rx,ry
+static void load_csv(FILE *f, trace_t *tr)
+{
+  char line[512];
+  while (fgets(line, sizeof(line), f))
+  {
+    unsigned seq, slot, rx_us, forward_us, age_us, buttons, lt, rt;
+    int lx, ly, rx, ry;
+    if (sscanf(line, "sample,%u,%u,%u,%u,%u,%u,%u,%u,%d,%d,%d,%d", &seq, &slot, &rx_us, &forward_us, &age_us,
+               &buttons, &lt, &rt, &lx, &ly, &rx, &ry) != 12 ||
+        slot > 3)
+    {
+      continue;
+    }
+    sample_t *s = trace_add(tr);
+    s->t_us = rx_us;
+    s->slot = (uint8_t)slot;
+    s->in[0] = (int16_t)lx, s->in[1] = (int16_t)ly, s->in[2] = (int16_t)rx, s->in[3] = (int16_t)ry;
+  }
+}
+
+static int16_t clamp16(double v)
+{
+  return (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : lround(v));
+}
+
+// 20 s at 250 Hz: rest, slow sweeps, flicks and a held deflection, with
+// +-400 counts of sensor noise and some poll jitter on top
+static void synthesize(trace_t *tr)
+{
+  srand(1);
+  uint32_t t = 0;
+  for (uint32_t n = 0; n < 5000; n++)
+  {
+    t += 4000 + (uint32_t)(rand() % 200);
+    double sec = t / 1e6;
+    double truth[STICK_FILTER_AXES] = {
+        sec < 4 ? 0 : sec < 12 ? 20000 * sin(2 * M_PI * 0.25 * (sec - 4)) : 0,
+        sec < 12 ? 0 : fmod(sec, 2.0) < 1.0 ? 30000 : -30000,
+        sec < 8 ? 0 : 12000,
+        15000 * sin(2 * M_PI * 1.5 * sec),
+    };
+
+    sample_t *s = trace_add(tr);
+    s->t_us = t;
+    for (uint8_t i = 0; i < STICK_FILTER_AXES; i++)
+    {
+      double noise = (rand() % 801) - 400;
+      s->truth[i] = clamp16(truth[i]);
+      s->in[i] = clamp16(truth[i] + noise);
+    }
+  }
+  tr->synthetic = 1;
+}
+
+static double second_diff_rms(trace_t const *tr, uint8_t axis, int out)
+{
+  double sum = 0;
+  size_t n = 0;
+  for (size_t k = 2; k < tr->len; k++)
+  {
+    int16_t const *a = out ? tr->s[k - 2].out : tr->s[k - 2].in;
+    int16_t const *b = out ? tr->s[k - 1].out : tr->s[k - 1].in;
+    int16_t const *c = out ? tr->s[k].out : tr->s[k].in;
+    double d = (double)c[axis] - 2.0 * b[axis] + a[axis];
+    sum += d * d;
+    n++;
+  }
+  return n ? sqrt(sum / n) : 0;
+}
+
+static double error_rms(trace_t const *tr, uint8_t axis, int out)
+{
+  double sum = 0;
+  for (size_t k = 0; k < tr->len; k++)
+  {
+    double d = (double)(out ? tr->s[k].out[axis] : tr->s[k].in[axis]) - tr->s[k].truth[axis];
+    sum += d * d;
+  }
+  return tr->len ? sqrt(sum / tr->len) : 0;
+}
+
+// Delay in samples of the output against the noise-free signal, or against
+// the input when there is none. The reference is shifted in 1/LAG_STEPS
+// sample steps, interpolating linearly, and the closest fit wins
+static double fit_lag(trace_t const *tr, uint8_t axis)
+{
+  double best = 0;
+  double best_sum = INFINITY;
+  for (unsigned step = 0; step <= MAX_LAG * LAG_STEPS && step / LAG_STEPS + 1 < tr->len; step++)
+  {
+    size_t whole = step / LAG_STEPS;
+    double frac = (double)(step % LAG_STEPS) / LAG_STEPS;
+    double sum = 0;
+    for (size_t k = whole + 1; k < tr->len; k++)
+    {
+      int16_t const *a = tr->synthetic ? tr->s[k - whole].truth : tr->s[k - whole].in;
+      int16_t const *b = tr->synthetic ? tr->s[k - whole - 1].truth : tr->s[k - whole - 1].in;
+      double d = (double)tr->s[k].out[axis] - ((1.0 - frac) * a[axis] + frac * b[axis]);
+      sum += d * d;
+    }
+    sum /= (double)(tr->len - whole - 1);
+    if (sum < best_sum)
+    {
+      best_sum = sum;
+      best = (double)step / LAG_STEPS;
+    }
+  }
+  return best;
+}
+
+// Microseconds from a step of a resting, noise-free stick until the output
+// covers 90% of it, with reports interval_us apart. 0 if the first report
+// after the step already does, -1 if it never gets there within a second
+static double step_90(stick_filter_table_t const *table, int16_t step, uint32_t interval_us)
+{
+  stick_filter_state_t state = {0};
+  uint32_t t = 0;
+  for (unsigned n = 0; n < 1000000 / interval_us; n++, t += interval_us)
+  {
+    int16_t axes[STICK_FILTER_AXES] = {0};
+    stick_filter_apply(table, &state, axes, t);
+  }
+
+  double threshold = 0.9 * step;
+  double prev = 0;
+  for (unsigned n = 0; n < 1000000 / interval_us; n++, t += interval_us)
+  {
+    int16_t axes[STICK_FILTER_AXES] = {step, step, step, step};
+    stick_filter_apply(table, &state, axes, t);
+    if (axes[0] >= threshold)
+    {
+      return n == 0 ? 0 : interval_us * (n - 1 + (threshold - prev) / (axes[0] - prev));
+    }
+    prev = axes[0];
+  }
+  return -1;
+}
+
+int main(int argc, char **argv)
+{
+  stick_filter_config_t cfg;
+  stick_filter_config_default(&cfg);
+  cfg.axes = (1u << STICK_FILTER_AXES) - 1;
+
+  int opt = 1;
+  for (; opt + 1 < argc && argv[opt][0] == '-'; opt += 2)
+  {
+    unsigned v = (unsigned)strtoul(argv[opt + 1], NULL, 0);
+    if (strcmp(argv[opt], "-m") == 0)
+    {
+      cfg.min_cutoff = (uint16_t)v;
+    }
+    else if (strcmp(argv[opt], "-b") == 0)
+    {
+      cfg.beta = (uint8_t)v;
+    }
+    else if (strcmp(argv[opt], "-d") == 0)
+    {
+      cfg.d_cutoff = (uint16_t)v;
+    }
+    else
+    {
+      fprintf(stderr, "usage: %s [-m min_cutoff] [-b beta] [-d d_cutoff] [samples.csv]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  trace_t tr = {0};
+  if (opt < argc)
+  {
+    FILE *f = fopen(argv[opt], "r");
+    if (!f)
+    {
+      perror(argv[opt]);
+      return 1;
+    }
+    load_csv(f, &tr);
+    fclose(f);
+  }
+  else
+  {
+    synthesize(&tr);
+  }
+  if (tr.len < 3)
+  {
+    fprintf(stderr, "no samples\n");
+    return 1;
+  }
+
+  stick_filter_table_t table;
+  stick_filter_compile(&cfg, &table);
+  stick_filter_state_t state[4] = {0};
+  for (size_t k = 0; k < tr.len; k++)
+  {
+    sample_t *s = &tr.s[k];
+    memcpy(s->out, s->in, sizeof(s->out));
+    stick_filter_apply(&table, &state[s->slot], s->out, s->t_us);
+  }
+
+  double interval_us = (double)(tr.s[tr.len - 1].t_us - tr.s[0].t_us) / (double)(tr.len - 1);
+  printf("%zu samples, %.0f us apart, min_cutoff %.1f Hz, beta %.1f Hz, d_cutoff %.1f Hz\n", tr.len, interval_us,
+         table.min_cutoff / 10.0, table.beta / 10.0, table.d_cutoff / 10.0);
+  printf("step to 90%%: %.1f ms (1/16 range), %.1f ms (1/2 range)\n",
+         step_90(&table, 2048, (uint32_t)interval_us) / 1000.0, step_90(&table, 16384, (uint32_t)interval_us) / 1000.0);
+  int worse = 0;
+  for (uint8_t i = 0; i < STICK_FILTER_AXES; i++)
+  {
+    double in = second_diff_rms(&tr, i, 0), out = second_diff_rms(&tr, i, 1);
+    double lag = fit_lag(&tr, i);
+    printf("%s jitter %7.1f -> %7.1f (-%4.1f%%)  lag %5.2f samples (%5.0f us)", axis_names[i], in, out,
+           in > 0 ? 100.0 * (in - out) / in : 0.0, lag, lag * interval_us);
+    if (tr.synthetic)
+    {
+      double err_in = error_rms(&tr, i, 0), err_out = error_rms(&tr, i, 1);
+      printf("  error %6.1f -> %6.1f%s", err_in, err_out, err_out > err_in ? "  WORSE" : "");
+      worse |= err_out > err_in;
+    }
+    printf("\n");
+  }
+
+  free(tr.s);
+  return worse;
+}
@@ -0,0 +1,168 @@
+// Decode a telemetry capture from CDC interface 1 into CSV.
+//
+//   telemetry_decode [capture.bin] > samples.csv
+//
+// Reads the capture from the given file or stdin, writes one CSV line per
+// sample to stdout and a latency summary to stderr. Frames with a bad CRC
+// are skipped byte by byte until the stream is back in sync.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "telemetry_proto.h"
+
+typedef struct
+{
+  uint64_t frames;
+  uint64_t samples;
+  uint64_t crc_errors;
+  uint64_t skipped_bytes;
+  uint64_t seq_gaps;
+  uint32_t *ages;
+  size_t ages_len;
+  size_t ages_cap;
+} decode_stats_t;
+
+static void print_pad(telemetry_pad_t const *p)
+{
+  printf(",%u,%u,%u,%d,%d,%d,%d", p->buttons, p->left_trigger, p->right_trigger,
+         p->thumb_lx, p->thumb_ly, p->thumb_rx, p->thumb_ry);
+}
+
+static void add_age(decode_stats_t *st, uint32_t age)
+{
+  if (st->ages_len == st->ages_cap)
+  {
+    st->ages_cap = st->ages_cap ? st->ages_cap * 2 : 4096;
+    st->ages = realloc(st->ages, st->ages_cap * sizeof(*st->ages));
+    if (!st->ages)
+    {
+      perror("realloc");
+      exit(1);
+    }
+  }
+  st->ages[st->ages_len++] = age;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+static void handle_frame(telemetry_frame_t const *f, decode_stats_t *st, bool *have_seq, uint16_t *next_seq)
+{
+  st->frames++;
+  if (*have_seq && f->seq != *next_seq)
+  {
+    st->seq_gaps++;
+  }
+  *have_seq = true;
+  *next_seq = (uint16_t)(f->seq + 1);
+
+  if (f->type == TELEMETRY_TYPE_SAMPLE)
+  {
+    telemetry_sample_t const *s = &f->payload.sample;
+    uint32_t age = s->forward_us - s->rx_us;
+    st->samples++;
+    add_age(st, age);
+
+    printf("sample,%u,%u,%u,%u,%u", f->seq, f->slot, s->rx_us, s->forward_us, age);
+    print_pad(&s->raw);
+    print_pad(&s->out);
+    printf("\n");
+  }
+  else if (f->type == TELEMETRY_TYPE_COUNTERS)
+  {
+    telemetry_counters_t const *c = &f->payload.counters;
+    printf("counters,%u,%u,%u,,,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u\n", f->seq, f->slot, c->now_us,
+           c->ring_dropped, c->ring_skipped, c->mailbox_sent, c->mailbox_overwritten,
+           c->mailbox_dropped, c->delta_suppressed, c->relay_coalesced, c->stdio_dropped,
+           c->telemetry_dropped, c->poll_rate_hz, c->poll_failed);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  FILE *in = stdin;
+  if (argc > 1)
+  {
+    in = fopen(argv[1], "rb");
+    if (!in)
+    {
+      perror(argv[1]);
+      return 1;
+    }
+  }
+
+  printf("kind,seq,slot,rx_us,forward_us,age_us,"
+         "raw_buttons,raw_lt,raw_rt,raw_lx,raw_ly,raw_rx,raw_ry,"
+         "out_buttons,out_lt,out_rt,out_lx,out_ly,out_rx,out_ry\n");
+
+  decode_stats_t st = {0};
+  bool have_seq = false;
+  uint16_t next_seq = 0;
+
+  uint8_t buf[4096];
+  size_t len = 0;
+  size_t n;
+  while ((n = fread(buf + len, 1, sizeof(buf) - len, in)) > 0)
+  {
+    len += n;
+    size_t pos = 0;
+    while (len - pos >= TELEMETRY_FRAME_SIZE)
+    {
+      uint8_t const *p = buf + pos;
+      if (p[0] != TELEMETRY_SYNC0 || p[1] != TELEMETRY_SYNC1)
+      {
+        st.skipped_bytes++;
+        pos++;
+        continue;
+      }
+
+      telemetry_frame_t frame;
+      memcpy(&frame, p, sizeof(frame));
+      if (telemetry_crc16(p, TELEMETRY_FRAME_SIZE - 2) != frame.crc)
+      {
+        st.crc_errors++;
+        st.skipped_bytes++;
+        pos++;
+        continue;
+      }
+
+      handle_frame(&frame, &st, &have_seq, &next_seq);
+      pos += TELEMETRY_FRAME_SIZE;
+    }
+    memmove(buf, buf + pos, len - pos);
+    len -= pos;
+  }
+  st.skipped_bytes += len;
+
+  if (in != stdin)
+  {
+    fclose(in);
+  }
+
+  fprintf(stderr, "frames %llu, samples %llu, crc errors %llu, skipped bytes %llu, sequence gaps %llu\n",
+          (unsigned long long)st.frames, (unsigned long long)st.samples,
+          (unsigned long long)st.crc_errors, (unsigned long long)st.skipped_bytes,
+          (unsigned long long)st.seq_gaps);
+
+  if (st.ages_len)
+  {
+    qsort(st.ages, st.ages_len, sizeof(*st.ages), cmp_u32);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < st.ages_len; i++)
+    {
+      sum += st.ages[i];
+    }
+    fprintf(stderr, "rx->forward us: min %u, mean %.1f, p50 %u, p99 %u, max %u\n",
+            st.ages[0], (double)sum / st.ages_len, st.ages[st.ages_len / 2],
+            st.ages[(st.ages_len * 99) / 100], st.ages[st.ages_len - 1]);
+  }
+  free(st.ages);
+  return 0;
+}
@@ -0,0 +1,7 @@
+#ifndef BOARD_API_H
+#define BOARD_API_H
+
+// usb_descriptors.c uses nothing of the board support package
+#include "tusb.h"
+
+#endif
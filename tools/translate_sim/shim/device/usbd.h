@@ -0,0 +1,7 @@
+#ifndef USBD_H
+#define USBD_H
+
+// What usb_descriptors.c needs from it is in the shim's tusb.h
+#include "tusb.h"
+
+#endif
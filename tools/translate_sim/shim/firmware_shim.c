@@ -0,0 +1,75 @@
+#include "xinput_shim.h"
+
+#include "host_poll.h"
+#include "host_report.h"
+#include "latency_stats.h"
+#include "pad_cache.h"
+#include "stage_profile.h"
+#include "usb_personality.h"
+
+// Stand-ins for the firmware modules around the units under test
+
+static systick_hw_t systick;
+systick_hw_t *const systick_hw = &systick;
+
+const char *const usb_personality_names[USB_PERSONALITY_COUNT] = {"xinput", "hid", "both"};
+
+static uint8_t personality;
+
+void xinput_shim_set_personality(uint8_t p)
+{
+  personality = p;
+}
+
+uint8_t usb_personality_active(void)
+{
+  return personality;
+}
+
+// With the default settings the pipeline leaves reports as they are, so the
+// frame goes to the device endpoint of its slot unchanged
+void report_process(report_frame_t *frame)
+{
+  tud_xinput_n_report(frame->slot, &frame->report);
+}
+
+void host_poll_completed(uint8_t slot, bool success)
+{
+  (void)slot;
+  (void)success;
+}
+
+void pad_cache_report(uint8_t slot)
+{
+  (void)slot;
+}
+
+uint32_t stage_profile_record(uint8_t stage, uint32_t start)
+{
+  (void)stage;
+  (void)start;
+  return 0;
+}
+
+bool stage_profile_control_xfer(uint8_t rhport, tusb_control_request_t const *request)
+{
+  (void)rhport;
+  (void)request;
+  return false;
+}
+
+bool latency_stats_control_xfer(uint8_t rhport, tusb_control_request_t const *request)
+{
+  (void)rhport;
+  (void)request;
+  return false;
+}
+
+bool tud_control_xfer(uint8_t rhport, tusb_control_request_t const *request, void *buffer, uint16_t len)
+{
+  (void)rhport;
+  (void)request;
+  (void)buffer;
+  (void)len;
+  return true;
+}
@@ -0,0 +1,19 @@
+#ifndef SYSTICK_H
+#define SYSTICK_H
+
+// The SysTick registers stage_profile.h reads, backed by a plain struct in
+// firmware_shim.c
+
+#include <stdint.h>
+
+typedef struct
+{
+  volatile uint32_t csr;
+  volatile uint32_t rvr;
+  volatile uint32_t cvr;
+  volatile uint32_t calib;
+} systick_hw_t;
+
+extern systick_hw_t *const systick_hw;
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef PICO_TIME_H
+#define PICO_TIME_H
+
+// time_us_32() from the monotonic clock, for report_frame.h
+
+#include <stdint.h>
+#include <time.h>
+
+static inline uint32_t time_us_32(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u);
+}
+
+#endif
@@ -0,0 +1,231 @@
+#ifndef TUSB_H
+#define TUSB_H
+
+// The parts of TinyUSB the host report callback and usb_descriptors.c use,
+// with the same values and descriptor layouts. The class counts come from
+// the firmware's own tusb_config.h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define OPT_MCU_NONE 0
+#define CFG_TUSB_MCU OPT_MCU_NONE
+#define OPT_MODE_DEFAULT_SPEED 0
+#include "tusb_config.h"
+
+//--------------------------------------------------------------------+
+// Common
+//--------------------------------------------------------------------+
+
+#define TU_VERIFY_STATIC _Static_assert
+#define TU_BIT(n) (1UL << (n))
+#define TU_U16_HIGH(_u16) ((uint8_t)(((_u16) >> 8) & 0x00ff))
+#define TU_U16_LOW(_u16) ((uint8_t)((_u16) & 0x00ff))
+#define U16_TO_U8S_LE(_u16) TU_U16_LOW(_u16), TU_U16_HIGH(_u16)
+
+typedef enum
+{
+  XFER_RESULT_SUCCESS = 0,
+  XFER_RESULT_FAILED,
+  XFER_RESULT_STALLED,
+  XFER_RESULT_TIMEOUT,
+  XFER_RESULT_INVALID,
+} xfer_result_t;
+
+enum
+{
+  TUSB_DESC_DEVICE = 0x01,
+  TUSB_DESC_CONFIGURATION = 0x02,
+  TUSB_DESC_STRING = 0x03,
+  TUSB_DESC_INTERFACE = 0x04,
+  TUSB_DESC_ENDPOINT = 0x05,
+  TUSB_DESC_INTERFACE_ASSOCIATION = 0x0B,
+  TUSB_DESC_BOS = 0x0F,
+  TUSB_DESC_CS_INTERFACE = 0x24,
+};
+
+enum
+{
+  TUSB_XFER_CONTROL = 0,
+  TUSB_XFER_ISOCHRONOUS,
+  TUSB_XFER_BULK,
+  TUSB_XFER_INTERRUPT,
+};
+
+enum
+{
+  TUSB_CLASS_UNSPECIFIED = 0,
+  TUSB_CLASS_CDC = 2,
+  TUSB_CLASS_HID = 3,
+  TUSB_CLASS_CDC_DATA = 10,
+  TUSB_CLASS_VENDOR_SPECIFIC = 0xFF,
+};
+
+enum
+{
+  CONTROL_STAGE_IDLE,
+  CONTROL_STAGE_SETUP,
+  CONTROL_STAGE_DATA,
+  CONTROL_STAGE_ACK,
+};
+
+typedef struct __attribute__((packed))
+{
+  uint8_t bLength;
+  uint8_t bDescriptorType;
+  uint16_t bcdUSB;
+  uint8_t bDeviceClass;
+  uint8_t bDeviceSubClass;
+  uint8_t bDeviceProtocol;
+  uint8_t bMaxPacketSize0;
+  uint16_t idVendor;
+  uint16_t idProduct;
+  uint16_t bcdDevice;
+  uint8_t iManufacturer;
+  uint8_t iProduct;
+  uint8_t iSerialNumber;
+  uint8_t bNumConfigurations;
+} tusb_desc_device_t;
+
+typedef struct __attribute__((packed))
+{
+  uint8_t bLength;
+  uint8_t bDescriptorType;
+  uint16_t wTotalLength;
+  uint8_t bNumInterfaces;
+  uint8_t bConfigurationValue;
+  uint8_t iConfiguration;
+  uint8_t bmAttributes;
+  uint8_t bMaxPower;
+} tusb_desc_configuration_t;
+
+typedef struct __attribute__((packed))
+{
+  uint8_t bmRequestType;
+  uint8_t bRequest;
+  uint16_t wValue;
+  uint16_t wIndex;
+  uint16_t wLength;
+} tusb_control_request_t;
+
+//--------------------------------------------------------------------+
+// Device descriptor templates
+//--------------------------------------------------------------------+
+
+#define TUD_CONFIG_DESC_LEN (9)
+
+// Config number, interface count, string index, total length, attribute, power in mA
+#define TUD_CONFIG_DESCRIPTOR(config_num, _itfcount, _stridx, _total_len, _attribute, _power_ma) \
+  9, TUSB_DESC_CONFIGURATION, U16_TO_U8S_LE(_total_len), _itfcount, config_num, _stridx,          \
+      TU_BIT(7) | _attribute, (_power_ma) / 2
+
+enum
+{
+  CDC_COMM_SUBCLASS_ABSTRACT_CONTROL_MODEL = 0x02,
+  CDC_COMM_PROTOCOL_NONE = 0x00,
+  CDC_FUNC_DESC_HEADER = 0x00,
+  CDC_FUNC_DESC_CALL_MANAGEMENT = 0x01,
+  CDC_FUNC_DESC_ABSTRACT_CONTROL_MANAGEMENT = 0x02,
+  CDC_FUNC_DESC_UNION = 0x06,
+};
+
+#define TUD_CDC_DESC_LEN (8 + 9 + 5 + 5 + 4 + 5 + 7 + 9 + 7 + 7)
+
+// Interface number, string index, EP notification address and size, EP data address (out, in) and size
+#define TUD_CDC_DESCRIPTOR(_itfnum, _stridx, _ep_notif, _ep_notif_size, _epout, _epin, _epsize)                     \
+  8, TUSB_DESC_INTERFACE_ASSOCIATION, _itfnum, 2, TUSB_CLASS_CDC, CDC_COMM_SUBCLASS_ABSTRACT_CONTROL_MODEL,         \
+      CDC_COMM_PROTOCOL_NONE, 0,                                                                                    \
+      9, TUSB_DESC_INTERFACE, _itfnum, 0, 1, TUSB_CLASS_CDC, CDC_COMM_SUBCLASS_ABSTRACT_CONTROL_MODEL,              \
+      CDC_COMM_PROTOCOL_NONE, _stridx,                                                                              \
+      5, TUSB_DESC_CS_INTERFACE, CDC_FUNC_DESC_HEADER, U16_TO_U8S_LE(0x0120),                                       \
+      5, TUSB_DESC_CS_INTERFACE, CDC_FUNC_DESC_CALL_MANAGEMENT, 0, (uint8_t)((_itfnum) + 1),                        \
+      4, TUSB_DESC_CS_INTERFACE, CDC_FUNC_DESC_ABSTRACT_CONTROL_MANAGEMENT, 6,                                      \
+      5, TUSB_DESC_CS_INTERFACE, CDC_FUNC_DESC_UNION, _itfnum, (uint8_t)((_itfnum) + 1),                            \
+      7, TUSB_DESC_ENDPOINT, _ep_notif, TUSB_XFER_INTERRUPT, U16_TO_U8S_LE(_ep_notif_size), 16,                     \
+      9, TUSB_DESC_INTERFACE, (uint8_t)((_itfnum) + 1), 0, 2, TUSB_CLASS_CDC_DATA, 0, 0, 0,                         \
+      7, TUSB_DESC_ENDPOINT, _epout, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0,                                     \
+      7, TUSB_DESC_ENDPOINT, _epin, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0
+
+enum
+{
+  HID_SUBCLASS_BOOT = 1,
+  HID_ITF_PROTOCOL_NONE = 0,
+  HID_DESC_TYPE_HID = 0x21,
+  HID_DESC_TYPE_REPORT = 0x22,
+};
+
+#define TUD_HID_DESC_LEN (9 + 9 + 7)
+
+// Interface number, string index, protocol, report descriptor len, EP In address, size & polling interval
+#define TUD_HID_DESCRIPTOR(_itfnum, _stridx, _boot_protocol, _report_desc_len, _epin, _epsize, _ep_interval)       \
+  9, TUSB_DESC_INTERFACE, _itfnum, 0, 1, TUSB_CLASS_HID, (uint8_t)((_boot_protocol) ? (uint8_t)HID_SUBCLASS_BOOT : 0), \
+      _boot_protocol, _stridx,                                                                                      \
+      9, HID_DESC_TYPE_HID, U16_TO_U8S_LE(0x0111), 0, 1, HID_DESC_TYPE_REPORT, U16_TO_U8S_LE(_report_desc_len),      \
+      7, TUSB_DESC_ENDPOINT, _epin, TUSB_XFER_INTERRUPT, U16_TO_U8S_LE(_epsize), _ep_interval
+
+//--------------------------------------------------------------------+
+// HID report descriptor items
+//--------------------------------------------------------------------+
+
+#define HID_REPORT_DATA_0(data)
+#define HID_REPORT_DATA_1(data) , data
+#define HID_REPORT_DATA_2(data) , U16_TO_U8S_LE(data)
+#define HID_REPORT_ITEM(data, tag, type, size) (((tag) << 4) | ((type) << 2) | (size)) HID_REPORT_DATA_##size(data)
+
+enum
+{
+  RI_TYPE_MAIN = 0,
+  RI_TYPE_GLOBAL = 1,
+  RI_TYPE_LOCAL = 2,
+};
+
+#define HID_INPUT(x) HID_REPORT_ITEM(x, 8, RI_TYPE_MAIN, 1)
+#define HID_COLLECTION(x) HID_REPORT_ITEM(x, 10, RI_TYPE_MAIN, 1)
+#define HID_COLLECTION_END HID_REPORT_ITEM(x, 12, RI_TYPE_MAIN, 0)
+
+#define HID_USAGE_PAGE(x) HID_REPORT_ITEM(x, 0, RI_TYPE_GLOBAL, 1)
+#define HID_LOGICAL_MIN(x) HID_REPORT_ITEM(x, 1, RI_TYPE_GLOBAL, 1)
+#define HID_LOGICAL_MIN_N(x, n) HID_REPORT_ITEM(x, 1, RI_TYPE_GLOBAL, n)
+#define HID_LOGICAL_MAX(x) HID_REPORT_ITEM(x, 2, RI_TYPE_GLOBAL, 1)
+#define HID_LOGICAL_MAX_N(x, n) HID_REPORT_ITEM(x, 2, RI_TYPE_GLOBAL, n)
+#define HID_REPORT_SIZE(x) HID_REPORT_ITEM(x, 7, RI_TYPE_GLOBAL, 1)
+#define HID_REPORT_COUNT(x) HID_REPORT_ITEM(x, 9, RI_TYPE_GLOBAL, 1)
+
+#define HID_USAGE(x) HID_REPORT_ITEM(x, 0, RI_TYPE_LOCAL, 1)
+#define HID_USAGE_MIN(x) HID_REPORT_ITEM(x, 1, RI_TYPE_LOCAL, 1)
+#define HID_USAGE_MAX(x) HID_REPORT_ITEM(x, 2, RI_TYPE_LOCAL, 1)
+
+enum
+{
+  HID_DATA = 0,
+  HID_VARIABLE = 1 << 1,
+  HID_ABSOLUTE = 0,
+  HID_COLLECTION_APPLICATION = 1,
+  HID_USAGE_PAGE_DESKTOP = 0x01,
+  HID_USAGE_PAGE_BUTTON = 0x09,
+  HID_USAGE_DESKTOP_GAMEPAD = 0x05,
+  HID_USAGE_DESKTOP_X = 0x30,
+  HID_USAGE_DESKTOP_Y = 0x31,
+  HID_USAGE_DESKTOP_Z = 0x32,
+  HID_USAGE_DESKTOP_RX = 0x33,
+  HID_USAGE_DESKTOP_RY = 0x34,
+  HID_USAGE_DESKTOP_RZ = 0x35,
+};
+
+//--------------------------------------------------------------------+
+// Device stack calls, see firmware_shim.c
+//--------------------------------------------------------------------+
+
+bool tud_control_xfer(uint8_t rhport, tusb_control_request_t const *request, void *buffer, uint16_t len);
+
+// Application callbacks, usb_descriptors.c implements them
+uint8_t const *tud_descriptor_device_cb(void);
+uint8_t const *tud_descriptor_configuration_cb(uint8_t index);
+uint8_t const *tud_descriptor_bos_cb(void);
+uint16_t const *tud_descriptor_string_cb(uint8_t index, uint16_t langid);
+uint8_t const *tud_hid_descriptor_report_cb(uint8_t instance);
+bool tud_vendor_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const *request);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef XINPUT_HOST_H
+#define XINPUT_HOST_H
+
+// The parts of the tusb_xinput host driver the report callback uses, with
+// the same layout
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "tusb.h"
+
+typedef enum
+{
+  XINPUT_UNKNOWN = 0,
+  XBOXONE,
+  XBOX360_WIRELESS,
+  XBOX360_WIRED,
+  XBOXOG,
+} xinput_type_t;
+
+typedef struct
+{
+  uint16_t wButtons;
+  uint8_t bLeftTrigger;
+  uint8_t bRightTrigger;
+  int16_t sThumbLX;
+  int16_t sThumbLY;
+  int16_t sThumbRX;
+  int16_t sThumbRY;
+} xinput_gamepad_t;
+
+typedef struct
+{
+  xinput_type_t type;
+  xinput_gamepad_t pad;
+  uint8_t connected;
+  uint8_t new_pad_data;
+  uint8_t itf_num;
+  xfer_result_t last_xfer_result;
+} xinputh_interface_t;
+
+// Implemented by the application, called by the fake host for every frame
+void tuh_xinput_report_received_cb(uint8_t dev_addr, uint8_t instance, xinputh_interface_t const *xid_itf,
+                                   uint16_t len);
+
+// Re-arm the interrupt IN transfer, counted by the shim
+bool tuh_xinput_receive_report(uint8_t dev_addr, uint8_t instance);
+
+#endif
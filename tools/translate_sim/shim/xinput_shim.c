@@ -0,0 +1,50 @@
+#include "xinput_shim.h"
+
+xinput_shim_stats_t xinput_shim_stats;
+
+static xinput_shim_sink_t sink;
+static void *sink_ctx;
+
+void xinput_shim_set_sink(xinput_shim_sink_t fn, void *ctx)
+{
+  sink = fn;
+  sink_ctx = ctx;
+}
+
+void xinput_shim_host_frame(uint8_t dev_addr, uint8_t instance, xinput_gamepad_t const *pad)
+{
+  xinputh_interface_t itf = {
+      .type = XBOX360_WIRED,
+      .pad = *pad,
+      .connected = 1,
+      .new_pad_data = 1,
+      .itf_num = instance,
+      .last_xfer_result = XFER_RESULT_SUCCESS,
+  };
+  xinput_shim_stats.frames++;
+  tuh_xinput_report_received_cb(dev_addr, instance, &itf, 20);
+}
+
+bool tuh_xinput_receive_report(uint8_t dev_addr, uint8_t instance)
+{
+  (void)dev_addr;
+  (void)instance;
+  xinput_shim_stats.rearmed++;
+  return true;
+}
+
+bool tud_xinput_n_ready(uint8_t itf)
+{
+  (void)itf;
+  return true;
+}
+
+bool tud_xinput_n_report(uint8_t itf, xinput_report_t const *report)
+{
+  xinput_shim_stats.reports++;
+  if (sink)
+  {
+    sink(itf, report, sink_ctx);
+  }
+  return true;
+}
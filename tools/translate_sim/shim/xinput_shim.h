@@ -0,0 +1,31 @@
+#ifndef XINPUT_SHIM_H
+#define XINPUT_SHIM_H
+
+// Drives the fake host and collects what reaches the fake device
+
+#include <stdint.h>
+
+#include "xinput_device.h"
+#include "xinput_host.h"
+
+typedef void (*xinput_shim_sink_t)(uint8_t itf, xinput_report_t const *report, void *ctx);
+
+typedef struct
+{
+  uint64_t frames;     // frames delivered to tuh_xinput_report_received_cb
+  uint64_t rearmed;    // tuh_xinput_receive_report calls
+  uint64_t reports;    // reports queued with tud_xinput_n_report
+} xinput_shim_stats_t;
+
+extern xinput_shim_stats_t xinput_shim_stats;
+
+// Every queued report goes to sink, NULL drops them
+void xinput_shim_set_sink(xinput_shim_sink_t sink, void *ctx);
+
+// Deliver one frame of the pad at dev_addr/instance as the host driver does
+void xinput_shim_host_frame(uint8_t dev_addr, uint8_t instance, xinput_gamepad_t const *pad);
+
+// Personality usb_personality_active() reports to usb_descriptors.c
+void xinput_shim_set_personality(uint8_t personality);
+
+#endif
@@ -0,0 +1,423 @@
+// Replay controller frames through the firmware's XInput report callback
+// and check its USB descriptors.
+//
+//   translate_sim [-n frames] [samples.csv]
+//
+// A fake XInput host (shim/) delivers every frame to the firmware's
+// tuh_xinput_report_received_cb (src/host_report.c), which looks up the
+// pad's slot, translates the frame and passes it on. The shim stands in
+// for the rest of the report path and queues it on the fake device. Each
+// report that reaches the device is checked byte for byte against the wire
+// layout of the frame that produced it, and against the interface of the
+// pad that sent it. The frames are the raw pad states of a telemetry_decode
+// CSV, or random ones with the extreme values mixed in, spread over every
+// pad. Then the translation is timed alone and through the whole fake path.
+//
+// The descriptors of src/usb_descriptors.c are walked for every
+// personality: lengths and totals, interface numbering, endpoints, the
+// XInput interfaces in pad order and the HID report layout.
+// Exits with 1 if a check fails.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "pad_slot.h"
+#include "report_translate.h"
+#include "usb_descriptors.h"
+#include "usb_personality.h"
+#include "xinput_shim.h"
+
+#define DEFAULT_FRAMES 10000000u
+#define CHECK_FRAMES 1000000u
+
+typedef struct
+{
+  xinput_gamepad_t *pad;
+  size_t len;
+  size_t cap;
+} trace_t;
+
+typedef struct
+{
+  xinput_gamepad_t const *pad;  // frame being delivered
+  uint8_t slot;                 // interface it must arrive on
+  uint64_t checked;
+  uint64_t failed;
+} check_t;
+
+static xinput_gamepad_t *trace_add(trace_t *tr)
+{
+  if (tr->len == tr->cap)
+  {
+    tr->cap = tr->cap ? tr->cap * 2 : 4096;
+    tr->pad = realloc(tr->pad, tr->cap * sizeof(*tr->pad));
+    if (!tr->pad)
+    {
+      perror("realloc");
+      exit(1);
+    }
+  }
+  xinput_gamepad_t *p = &tr->pad[tr->len++];
+  memset(p, 0, sizeof(*p));
+  return p;
+}
+
+// kind,seq,slot,rx_us,forward_us,age_us,raw_buttons..raw_ry,out_buttons..out_ry
+static void load_csv(FILE *f, trace_t *tr)
+{
+  char line[512];
+  while (fgets(line, sizeof(line), f))
+  {
+    unsigned seq, slot, rx_us, forward_us, age_us, buttons, lt, rt;
+    int lx, ly, rx, ry;
+    if (sscanf(line, "sample,%u,%u,%u,%u,%u,%u,%u,%u,%d,%d,%d,%d", &seq, &slot, &rx_us, &forward_us, &age_us,
+               &buttons, &lt, &rt, &lx, &ly, &rx, &ry) != 12)
+    {
+      continue;
+    }
+    xinput_gamepad_t *p = trace_add(tr);
+    *p = (xinput_gamepad_t){
+        .wButtons = (uint16_t)buttons,
+        .bLeftTrigger = (uint8_t)lt,
+        .bRightTrigger = (uint8_t)rt,
+        .sThumbLX = (int16_t)lx,
+        .sThumbLY = (int16_t)ly,
+        .sThumbRX = (int16_t)rx,
+        .sThumbRY = (int16_t)ry,
+    };
+  }
+}
+
+static uint32_t lcg(uint32_t *s)
+{
+  *s = *s * 1664525u + 1013904223u;
+  return *s;
+}
+
+// Random states, every fourth value of a field one of its extremes
+static void synthesize(trace_t *tr, size_t count)
+{
+  static const int16_t extremes[] = {-32768, -32767, -1, 0, 1, 32767};
+  uint32_t s = 1;
+  for (size_t n = 0; n < count; n++)
+  {
+    xinput_gamepad_t *p = trace_add(tr);
+    int16_t axis[4];
+    for (int i = 0; i < 4; i++)
+    {
+      uint32_t r = lcg(&s);
+      axis[i] = (r & 3) == 0 ? extremes[(r >> 2) % 6] : (int16_t)(r >> 16);
+    }
+    uint32_t r = lcg(&s);
+    p->wButtons = (uint16_t)(r >> 16);
+    p->bLeftTrigger = (r & 3) == 0 ? 255 : (uint8_t)(r >> 2);
+    p->bRightTrigger = (r & 12) == 0 ? 0 : (uint8_t)(r >> 8);
+    p->sThumbLX = axis[0];
+    p->sThumbLY = axis[1];
+    p->sThumbRX = axis[2];
+    p->sThumbRY = axis[3];
+  }
+}
+
+// The 20 bytes the PC must receive for pad, little-endian
+static void expected_bytes(xinput_gamepad_t const *pad, uint8_t out[20])
+{
+  uint16_t const words[] = {(uint16_t)pad->sThumbLX, (uint16_t)pad->sThumbLY, (uint16_t)pad->sThumbRX,
+                            (uint16_t)pad->sThumbRY};
+  memset(out, 0, 20);
+  out[0] = 0x00;
+  out[1] = 0x14;
+  out[2] = (uint8_t)pad->wButtons;
+  out[3] = (uint8_t)(pad->wButtons >> 8);
+  out[4] = pad->bLeftTrigger;
+  out[5] = pad->bRightTrigger;
+  for (int i = 0; i < 4; i++)
+  {
+    out[6 + 2 * i] = (uint8_t)words[i];
+    out[7 + 2 * i] = (uint8_t)(words[i] >> 8);
+  }
+}
+
+static void check_sink(uint8_t itf, xinput_report_t const *report, void *ctx)
+{
+  check_t *c = ctx;
+  uint8_t want[20];
+  expected_bytes(c->pad, want);
+  c->checked++;
+  if (itf != c->slot || memcmp(report, want, sizeof(want)) != 0)
+  {
+    if (c->failed++ < 5)
+    {
+      fprintf(stderr, "frame %llu: report differs\n", (unsigned long long)c->checked - 1);
+    }
+  }
+}
+
+static double elapsed_ns(struct timespec const *t0, struct timespec const *t1)
+{
+  return (t1->tv_sec - t0->tv_sec) * 1e9 + (t1->tv_nsec - t0->tv_nsec);
+}
+
+static void drop_sink(uint8_t itf, xinput_report_t const *report, void *ctx)
+{
+  (void)itf;
+  *(volatile uint16_t *)ctx += report->bmButtons;
+}
+
+//--------------------------------------------------------------------+
+// Descriptors
+//--------------------------------------------------------------------+
+
+static unsigned desc_failures;
+
+#define DESC_CHECK(_cond, ...)                    \
+  do                                              \
+  {                                               \
+    if (!(_cond))                                 \
+    {                                             \
+      fprintf(stderr, "  %s: ", personality_name); \
+      fprintf(stderr, __VA_ARGS__);               \
+      fprintf(stderr, "\n");                      \
+      desc_failures++;                            \
+    }                                             \
+  } while (0)
+
+static char const *personality_name;
+
+static uint16_t le16(uint8_t const *p)
+{
+  return (uint16_t)(p[0] | p[1] << 8);
+}
+
+// Walk a HID report descriptor and return the bits of its input report,
+// or -1 if the items run past len or the collections do not balance
+static int hid_input_bits(uint8_t const *desc, uint16_t len)
+{
+  int bits = 0, depth = 0;
+  uint32_t size = 0, count = 0;
+  for (uint16_t i = 0; i < len;)
+  {
+    uint8_t item = desc[i];
+    uint8_t n = (uint8_t)((item & 3) == 3 ? 4 : item & 3);
+    if (i + 1 + n > len)
+    {
+      return -1;
+    }
+    uint32_t data = 0;
+    for (uint8_t k = 0; k < n; k++)
+    {
+      data |= (uint32_t)desc[i + 1 + k] << (8 * k);
+    }
+    switch (item & 0xFC)
+    {
+    case 0x74: size = data; break;                                  // Report Size
+    case 0x94: count = data; break;                                 // Report Count
+    case 0x80: bits += (int)(size * count); break;                  // Input
+    case 0xA0: depth++; break;                                      // Collection
+    case 0xC0: depth--; break;                                      // End Collection
+    }
+    i = (uint16_t)(i + 1 + n);
+  }
+  return depth == 0 ? bits : -1;
+}
+
+// One personality's device and configuration descriptor
+static void check_personality(uint8_t personality, uint16_t *pids)
+{
+  personality_name = usb_personality_names[personality];
+  xinput_shim_set_personality(personality);
+
+  tusb_desc_device_t const *dev = (tusb_desc_device_t const *)tud_descriptor_device_cb();
+  DESC_CHECK(dev->bLength == sizeof(*dev) && dev->bDescriptorType == TUSB_DESC_DEVICE, "device descriptor header");
+  DESC_CHECK(dev->bNumConfigurations == 1, "%u configurations", dev->bNumConfigurations);
+  pids[personality] = dev->idProduct;
+  for (uint8_t i = 0; i < personality; i++)
+  {
+    DESC_CHECK(pids[i] != dev->idProduct, "product ID %04x shared with %s", dev->idProduct, usb_personality_names[i]);
+  }
+
+  uint8_t const *cfg = tud_descriptor_configuration_cb(0);
+  uint16_t total = le16(cfg + 2);
+  DESC_CHECK(cfg[0] == TUD_CONFIG_DESC_LEN && cfg[1] == TUSB_DESC_CONFIGURATION, "configuration header");
+
+  unsigned interfaces = 0, xinput = 0, hid = 0;
+  int itf_at = -1;       // offset of the interface being walked
+  unsigned endpoints = 0; // endpoints seen since it
+  uint8_t ep_seen[2][16] = {{0}};
+  uint16_t at = cfg[0];
+  while (at < total)
+  {
+    uint8_t const *d = cfg + at;
+    if (d[0] < 2 || at + d[0] > total)
+    {
+      DESC_CHECK(0, "descriptor at %u runs past wTotalLength %u", at, total);
+      break;
+    }
+    if (d[1] == TUSB_DESC_INTERFACE)
+    {
+      if (itf_at >= 0)
+      {
+        DESC_CHECK(cfg[itf_at + 4] == endpoints, "interface %u has %u endpoints, says %u", cfg[itf_at + 2], endpoints,
+                   cfg[itf_at + 4]);
+      }
+      DESC_CHECK(d[2] == interfaces, "interface %u where %u was due", d[2], interfaces);
+      itf_at = at;
+      endpoints = 0;
+      interfaces++;
+
+      if (d[5] == XINPUT_ITF_CLASS && d[6] == XINPUT_ITF_SUBCLASS && d[7] == XINPUT_ITF_PROTOCOL)
+      {
+        // Pad n is XInput driver instance n, so they come in pad order
+        DESC_CHECK(d[2] == ITF_NUM_PADS + xinput, "XInput interface %u is not pad %u", d[2], xinput);
+        uint8_t const *cls = d + d[0];
+        uint8_t const *in = cls + cls[0], *out = in + in[0];
+        DESC_CHECK(cls[0] == 17 && cls[1] == 0x21, "XInput interface %u lacks its class descriptor", d[2]);
+        DESC_CHECK(in[1] == TUSB_DESC_ENDPOINT && (in[2] & 0x80) && cls[6] == in[2], "XInput %u IN endpoint", d[2]);
+        DESC_CHECK(out[1] == TUSB_DESC_ENDPOINT && !(out[2] & 0x80) && cls[13] == out[2], "XInput %u OUT endpoint",
+                   d[2]);
+        DESC_CHECK(le16(in + 4) >= sizeof(xinput_report_t), "XInput %u IN endpoint too small", d[2]);
+        xinput++;
+      }
+      else if (d[5] == TUSB_CLASS_HID)
+      {
+        uint8_t const *cls = d + d[0];
+        uint8_t const *in = cls + cls[0];
+        DESC_CHECK(cls[1] == HID_DESC_TYPE_HID && cls[6] == HID_DESC_TYPE_REPORT, "HID interface %u descriptor", d[2]);
+        int bits = hid_input_bits(tud_hid_descriptor_report_cb(hid), le16(cls + 7));
+        DESC_CHECK(bits == USB_HID_PAD_REPORT_LEN * 8, "HID pad %u reports %d bits", hid, bits);
+        DESC_CHECK(le16(in + 4) >= USB_HID_PAD_REPORT_LEN, "HID pad %u IN endpoint too small", hid);
+        hid++;
+      }
+    }
+    else if (d[1] == TUSB_DESC_ENDPOINT)
+    {
+      uint8_t dir = d[2] >> 7, num = d[2] & 0x0F;
+      DESC_CHECK(num != 0 && !ep_seen[dir][num], "endpoint %02x used twice", d[2]);
+      ep_seen[dir][num] = 1;
+      endpoints++;
+    }
+    at = (uint16_t)(at + d[0]);
+  }
+  if (itf_at >= 0)
+  {
+    DESC_CHECK(cfg[itf_at + 4] == endpoints, "interface %u has %u endpoints, says %u", cfg[itf_at + 2], endpoints,
+               cfg[itf_at + 4]);
+  }
+  DESC_CHECK(at == total, "descriptors end at %u, wTotalLength %u", at, total);
+  DESC_CHECK(interfaces == cfg[4], "%u interfaces, bNumInterfaces %u", interfaces, cfg[4]);
+
+  unsigned want_xinput = personality == USB_PERSONALITY_HID ? 0 : PT_XINPUT_PADS;
+  unsigned want_hid = personality == USB_PERSONALITY_XINPUT ? 0 : PT_XINPUT_PADS;
+  DESC_CHECK(xinput == want_xinput, "%u XInput interfaces, want %u", xinput, want_xinput);
+  DESC_CHECK(hid == want_hid, "%u HID interfaces, want %u", hid, want_hid);
+
+  printf("desc     %-6s %3u bytes, %u interfaces (%u XInput, %u HID)\n", personality_name, total, interfaces, xinput,
+         hid);
+}
+
+int main(int argc, char **argv)
+{
+  size_t frames = DEFAULT_FRAMES;
+  int opt = 1;
+  if (opt + 1 < argc && strcmp(argv[opt], "-n") == 0)
+  {
+    frames = strtoul(argv[opt + 1], NULL, 0);
+    opt += 2;
+  }
+  if (opt < argc && argv[opt][0] == '-')
+  {
+    fprintf(stderr, "usage: %s [-n frames] [samples.csv]\n", argv[0]);
+    return 1;
+  }
+
+  trace_t tr = {0};
+  if (opt < argc)
+  {
+    FILE *f = fopen(argv[opt], "r");
+    if (!f)
+    {
+      perror(argv[opt]);
+      return 1;
+    }
+    load_csv(f, &tr);
+    fclose(f);
+  }
+  else
+  {
+    synthesize(&tr, CHECK_FRAMES);
+  }
+  if (tr.len == 0 || frames == 0)
+  {
+    fprintf(stderr, "no frames\n");
+    return 1;
+  }
+
+  // One pad per slot, two of them behind one device as on a wireless
+  // receiver. Mounted in slot order
+  static const uint8_t pad_addr[4][2] = {{1, 0}, {2, 0}, {2, 1}, {3, 0}};
+  pad_slot_init();
+  for (uint8_t i = 0; i < PT_XINPUT_PADS; i++)
+  {
+    if (pad_slot_acquire(pad_addr[i][0], pad_addr[i][1]) != i)
+    {
+      fprintf(stderr, "pad %u did not get slot %u\n", i, i);
+      return 1;
+    }
+  }
+
+  // Every frame once through the checking sink, from each pad in turn
+  check_t check = {0};
+  xinput_shim_set_sink(check_sink, &check);
+  for (size_t k = 0; k < tr.len; k++)
+  {
+    check.pad = &tr.pad[k];
+    check.slot = (uint8_t)(k % PT_XINPUT_PADS);
+    xinput_shim_host_frame(pad_addr[check.slot][0], pad_addr[check.slot][1], &tr.pad[k]);
+  }
+
+  // A pad without a slot is read on but not forwarded
+  xinput_shim_host_frame(PAD_SLOT_MAX_ADDR, 0, &tr.pad[0]);
+
+  int ok = check.failed == 0 && check.checked == tr.len && xinput_shim_stats.rearmed == tr.len + 1;
+  printf("check    %zu frames, %llu reports, %llu wrong: %s\n", tr.len, (unsigned long long)check.checked,
+         (unsigned long long)check.failed, ok ? "ok" : "FAILED");
+
+  uint16_t pids[USB_PERSONALITY_COUNT];
+  for (uint8_t p = 0; p < USB_PERSONALITY_COUNT; p++)
+  {
+    check_personality(p, pids);
+  }
+  ok &= desc_failures == 0;
+
+  // Then the trace over and over, without checking
+  volatile uint16_t sink = 0;
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (size_t k = 0; k < frames; k++)
+  {
+    xinput_report_t report;
+    report_translate(&tr.pad[k % tr.len], &report);
+    sink += report.bmButtons;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  double translate_ns = elapsed_ns(&t0, &t1) / (double)frames;
+
+  xinput_shim_set_sink(drop_sink, (void *)&sink);
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (size_t k = 0; k < frames; k++)
+  {
+    xinput_shim_host_frame(pad_addr[0][0], pad_addr[0][1], &tr.pad[k % tr.len]);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  double path_ns = elapsed_ns(&t0, &t1) / (double)frames;
+
+  printf("speed    %zu frames, translate %.2f ns/report, host callback to device %.2f ns/report (%.1f M reports/s)\n",
+         frames, translate_ns, path_ns, 1e3 / path_ns);
+
+  free(tr.pad);
+  printf("%s\n", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+// Compare the prebuilt string descriptors of src/usb_strings.c byte for byte
+// with what the firmware used to build on every GET_DESCRIPTOR request.
+//
+//   usb_strings_check
+//
+// Every index from 0 to 255 is requested from both. The reference below is
+// the old tud_descriptor_string_cb, with a fixed board serial number.
+// Exits with 1 on the first difference.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ms_os_desc.h"
+#include "usb_strings.h"
+
+#define TUSB_DESC_STRING 0x03
+
+// What the RP2040 BSP returns: the 8-byte unique ID of the flash as hex
+static size_t board_usb_get_serial(uint16_t desc_str1[], size_t max_chars)
+{
+  static const char id[] = "E66138935F1A2B2C";
+  size_t n = strlen(id) < max_chars ? strlen(id) : max_chars;
+  for (size_t i = 0; i < n; i++)
+  {
+    desc_str1[i] = (uint8_t)id[i];
+  }
+  return n;
+}
+
+//--------------------------------------------------------------------+
+// Reference: the conversion the prebuilt descriptors replaced
+//--------------------------------------------------------------------+
+
+static char const *string_desc_arr[] = {
+    (const char[]){0x09, 0x04}, // 0: is supported language is English (0x0409)
+    "Tak",                      // 1: Manufacturer
+    "Tak's Pico Device",        // 2: Product
+    NULL,                       // 3: Serials will use unique ID if possible
+    "Tak's CDC Interface",      // 4: CDC Interface
+    "Tak's Controller",         // 5: HID Interface
+    "MSFT100",
+};
+
+static uint16_t _desc_str[32 + 1];
+static uint16_t msft100_desc[9];
+
+static uint16_t const *reference_string_cb(uint8_t index)
+{
+  size_t chr_count;
+
+  switch (index)
+  {
+  case 0:
+    memcpy(&_desc_str[1], string_desc_arr[0], 2);
+    chr_count = 1;
+    break;
+
+  case 3:
+    chr_count = board_usb_get_serial(_desc_str + 1, 32);
+    break;
+
+  case 0xEE:
+    msft100_desc[0] = (TUSB_DESC_STRING << 8) | 18;
+    for (uint8_t i = 0; i < 7; i++)
+    {
+      msft100_desc[1 + i] = "MSFT100"[i];
+    }
+    msft100_desc[8] = MS_OS_1_0_VENDOR_CODE;
+    return msft100_desc;
+
+  default:
+    if (!(index < sizeof(string_desc_arr) / sizeof(string_desc_arr[0])))
+      return NULL;
+
+    const char *str = string_desc_arr[index];
+    chr_count = strlen(str);
+    size_t const max_count = sizeof(_desc_str) / sizeof(_desc_str[0]) - 1;
+    if (chr_count > max_count)
+      chr_count = max_count;
+    for (size_t i = 0; i < chr_count; i++)
+    {
+      _desc_str[1 + i] = str[i];
+    }
+    break;
+  }
+
+  _desc_str[0] = (uint16_t)((TUSB_DESC_STRING << 8) | (2 * chr_count + 2));
+  return _desc_str;
+}
+
+//--------------------------------------------------------------------+
+// Comparison
+//--------------------------------------------------------------------+
+
+static void dump(const char *label, uint16_t const *desc)
+{
+  uint8_t const *b = (uint8_t const *)desc;
+  printf("  %-9s", label);
+  for (uint8_t i = 0; i < b[0]; i++)
+  {
+    printf(" %02x", b[i]);
+  }
+  printf("\n");
+}
+
+int main(void)
+{
+  uint16_t serial[USB_STRING_SERIAL_MAX];
+  usb_string_set_serial(serial, board_usb_get_serial(serial, USB_STRING_SERIAL_MAX));
+
+  unsigned present = 0;
+  for (unsigned index = 0; index < 256; index++)
+  {
+    uint16_t const *want = reference_string_cb((uint8_t)index);
+    uint16_t const *got = usb_string_descriptor((uint8_t)index);
+
+    bool same = (want == NULL) == (got == NULL);
+    if (same && want)
+    {
+      uint8_t const *w = (uint8_t const *)want;
+      uint8_t const *g = (uint8_t const *)got;
+      same = w[0] == g[0] && w[1] == g[1] && w[1] == TUSB_DESC_STRING && memcmp(w, g, w[0]) == 0;
+      present++;
+    }
+    if (!same)
+    {
+      printf("string 0x%02x differs\n", index);
+      if (want)
+      {
+        dump("expected", want);
+      }
+      if (got)
+      {
+        dump("got", got);
+      }
+      return 1;
+    }
+  }
+
+  printf("%u string descriptors identical, the other %u indices absent from both\n", present, 256 - present);
+  return 0;
+}